@@ -0,0 +1,232 @@
+#ifndef CBIRDPP_BENCH_LOCALH2SERVER_H
+#define CBIRDPP_BENCH_LOCALH2SERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cbirdpp_bench
+{
+
+  /*
+   * A minimal cleartext HTTP/2 server (prior knowledge, no upgrade) on 127.0.0.1 standing in for ebird.org in
+   * benchmarks. It answers every request stream with the same body after a per request latency, without decoding the
+   * request headers. Flow control is not enforced, the client's windows are assumed to be large enough for the body.
+   */
+  class LocalH2Server
+  {
+    public:
+      using Latency = std::function<std::chrono::milliseconds(std::size_t request_number)>;
+
+      LocalH2Server(std::string body, Latency latency, unsigned int max_streams,
+                    std::chrono::microseconds handshake_delay=std::chrono::microseconds(0))
+        : body(std::move(body)), latency(std::move(latency)), max_streams(max_streams), handshake_delay(handshake_delay)
+      {
+        listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int enable = 1;
+        ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if(::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), length) != 0 || ::listen(listen_fd, 512) != 0) {
+          throw std::runtime_error("LocalH2Server could not listen on 127.0.0.1");
+        }
+        ::getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &length);
+        port = ntohs(address.sin_port);
+        acceptor = std::thread([this] { accept_loop(); });
+      }
+
+      LocalH2Server(const LocalH2Server&) = delete;
+      LocalH2Server& operator=(const LocalH2Server&) = delete;
+
+      ~LocalH2Server()
+      {
+        stopping = true;
+        ::shutdown(listen_fd, SHUT_RDWR);
+        ::close(listen_fd);
+        acceptor.join();
+        for(std::thread& worker : workers) {worker.join();}
+      }
+
+      /// The base url of the server, always ending in a '/'.
+      std::string url() const { return "http://127.0.0.1:" + std::to_string(port) + "/"; }
+
+      /// The amount of TCP connections accepted so far.
+      std::size_t connections() const { return accepted; }
+
+      /// The most streams that were open at the same time on any one connection.
+      std::size_t peak_streams() const { return peak; }
+
+    private:
+      using Clock = std::chrono::steady_clock;
+
+      // Frame types and flags from RFC 7540 section 6.
+      static const std::uint8_t DATA = 0x0;
+      static const std::uint8_t HEADERS = 0x1;
+      static const std::uint8_t SETTINGS = 0x4;
+      static const std::uint8_t PING = 0x6;
+      static const std::uint8_t GOAWAY = 0x7;
+      static const std::uint8_t END_STREAM = 0x1;
+      static const std::uint8_t ACK = 0x1;
+      static const std::uint8_t END_HEADERS = 0x4;
+      static const std::size_t MAX_FRAME = 16384;
+
+      std::string body;
+      Latency latency;
+      unsigned int max_streams;
+      std::chrono::microseconds handshake_delay;
+      int listen_fd = -1;
+      unsigned short port = 0;
+      std::atomic<bool> stopping{false};
+      std::atomic<std::size_t> accepted{0};
+      std::atomic<std::size_t> requests{0};
+      std::atomic<std::size_t> peak{0};
+      std::thread acceptor;
+      std::vector<std::thread> workers;
+
+      void accept_loop()
+      {
+        while(!stopping) {
+          int fd = ::accept(listen_fd, nullptr, nullptr);
+          if(fd < 0) {continue;}
+          ++accepted;
+          workers.emplace_back([this, fd] { serve(fd); });
+        }
+      }
+
+      static std::string frame(std::uint8_t type, std::uint8_t flags, std::uint32_t stream, const std::string& payload)
+      {
+        std::string raw;
+        std::size_t length = payload.size();
+        raw += static_cast<char>((length >> 16) & 0xff);
+        raw += static_cast<char>((length >> 8) & 0xff);
+        raw += static_cast<char>(length & 0xff);
+        raw += static_cast<char>(type);
+        raw += static_cast<char>(flags);
+        raw += static_cast<char>((stream >> 24) & 0x7f);
+        raw += static_cast<char>((stream >> 16) & 0xff);
+        raw += static_cast<char>((stream >> 8) & 0xff);
+        raw += static_cast<char>(stream & 0xff);
+        return raw + payload;
+      }
+
+      /// HEADERS and DATA frames answering one stream with status 200 and the body.
+      std::string response(std::uint32_t stream) const
+      {
+        // HPACK: indexed ":status: 200", then content-length as a literal with the indexed name 28.
+        std::string length = std::to_string(body.size());
+        std::string block = "\x88\x0f\x0d";
+        block += static_cast<char>(length.size());
+        block += length;
+        std::string raw = frame(HEADERS, END_HEADERS, stream, block);
+        for(std::size_t offset = 0; offset < body.size() || offset == 0; offset += MAX_FRAME) {
+          bool last = offset + MAX_FRAME >= body.size();
+          raw += frame(DATA, last ? END_STREAM : 0, stream, body.substr(offset, MAX_FRAME));
+          if(last) {break;}
+        }
+        return raw;
+      }
+
+      void serve(int fd)
+      {
+        if(handshake_delay.count() > 0) {std::this_thread::sleep_for(handshake_delay);}
+        std::string settings;
+        settings += std::string("\x00\x03", 2);
+        settings += static_cast<char>((max_streams >> 24) & 0xff);
+        settings += static_cast<char>((max_streams >> 16) & 0xff);
+        settings += static_cast<char>((max_streams >> 8) & 0xff);
+        settings += static_cast<char>(max_streams & 0xff);
+        std::string outgoing = frame(SETTINGS, 0, 0, settings);
+
+        std::string incoming;
+        bool preface_seen = false;
+        std::multimap<Clock::time_point, std::uint32_t> due;
+        std::set<std::uint32_t> answered;
+        char chunk[16384];
+        bool open = true;
+        while(open && !stopping) {
+          while(!due.empty() && due.begin()->first <= Clock::now()) {
+            outgoing += response(due.begin()->second);
+            due.erase(due.begin());
+          }
+          if(!outgoing.empty()) {
+            if(!send_all(fd, outgoing)) {break;}
+            outgoing.clear();
+          }
+
+          int timeout = 50;
+          if(!due.empty()) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(due.begin()->first - Clock::now()).count();
+            timeout = static_cast<int>(std::max<long long>(0, std::min<long long>(wait, timeout)));
+          }
+          pollfd readable{fd, POLLIN, 0};
+          if(::poll(&readable, 1, timeout) <= 0) {continue;}
+          ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+          if(received <= 0) {break;}
+          incoming.append(chunk, static_cast<std::size_t>(received));
+
+          if(!preface_seen) {
+            if(incoming.size() < 24) {continue;}
+            incoming.erase(0, 24);
+            preface_seen = true;
+          }
+          while(incoming.size() >= 9) {
+            auto byte = [&incoming](std::size_t i) { return static_cast<std::uint32_t>(static_cast<unsigned char>(incoming[i])); };
+            std::size_t length = (byte(0) << 16) | (byte(1) << 8) | byte(2);
+            if(incoming.size() < 9 + length) {break;}
+            std::uint8_t type = static_cast<std::uint8_t>(byte(3));
+            std::uint8_t flags = static_cast<std::uint8_t>(byte(4));
+            std::uint32_t stream = ((byte(5) & 0x7f) << 24) | (byte(6) << 16) | (byte(7) << 8) | byte(8);
+            std::string payload = incoming.substr(9, length);
+            incoming.erase(0, 9 + length);
+
+            if(type == SETTINGS && !(flags & ACK)) {
+              outgoing += frame(SETTINGS, ACK, 0, "");
+            } else if(type == PING && !(flags & ACK)) {
+              outgoing += frame(PING, ACK, 0, payload);
+            } else if(type == GOAWAY) {
+              open = false;
+            } else if((type == HEADERS || type == DATA) && (flags & END_STREAM) && answered.insert(stream).second) {
+              due.emplace(Clock::now() + latency(requests++), stream);
+              std::size_t open_streams = due.size();
+              std::size_t previous = peak;
+              while(open_streams > previous && !peak.compare_exchange_weak(previous, open_streams)) {}
+            }
+          }
+        }
+        ::close(fd);
+      }
+
+      static bool send_all(int fd, const std::string& data)
+      {
+        std::size_t sent = 0;
+        while(sent < data.size()) {
+          ssize_t result = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+          if(result <= 0) {return false;}
+          sent += static_cast<std::size_t>(result);
+        }
+        return true;
+      }
+  };
+
+}
+
+#endif
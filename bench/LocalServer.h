@@ -0,0 +1,214 @@
+#ifndef CBIRDPP_BENCH_LOCALSERVER_H
+#define CBIRDPP_BENCH_LOCALSERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cbirdpp_bench
+{
+
+  /*
+   * The parts of an HTTP request the stand-in server hands to its handler.
+   */
+  struct LocalRequest
+  {
+    std::string method;
+    std::string target;
+    std::map<std::string, std::string> headers;   // Header names are lower cased.
+  };
+
+  /*
+   * What the handler wants the stand-in server to reply with. Content-Length and Connection are added automatically.
+   */
+  struct LocalReply
+  {
+    int status = 200;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+  };
+
+  /*
+   * A minimal HTTP/1.1 server on 127.0.0.1 standing in for ebird.org in benchmarks. Connections are kept alive until
+   * the client closes them, and every new connection can be delayed to simulate the cost of a TCP+TLS handshake to
+   * the real host.
+   */
+  class LocalServer
+  {
+    public:
+      using Handler = std::function<LocalReply(const LocalRequest&)>;
+
+      explicit LocalServer(Handler handler, std::chrono::microseconds handshake_delay=std::chrono::microseconds(0))
+        : handler(std::move(handler)), handshake_delay(handshake_delay)
+      {
+        listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int enable = 1;
+        ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        socklen_t length = sizeof(address);
+        if(::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), length) != 0 || ::listen(listen_fd, 512) != 0) {
+          throw std::runtime_error("LocalServer could not listen on 127.0.0.1");
+        }
+        ::getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &length);
+        port = ntohs(address.sin_port);
+        acceptor = std::thread([this] { accept_loop(); });
+      }
+
+      /// Convenience constructor for a server that always answers 200 with the same body.
+      explicit LocalServer(const std::string& body, std::chrono::microseconds handshake_delay=std::chrono::microseconds(0))
+        : LocalServer([body](const LocalRequest&) { LocalReply reply; reply.body = body; return reply; }, handshake_delay) {}
+
+      LocalServer(const LocalServer&) = delete;
+      LocalServer& operator=(const LocalServer&) = delete;
+
+      ~LocalServer()
+      {
+        stopping = true;
+        ::shutdown(listen_fd, SHUT_RDWR);
+        ::close(listen_fd);
+        acceptor.join();
+        {
+          std::lock_guard<std::mutex> lock(clients_mutex);
+          for(int fd : client_fds) {::shutdown(fd, SHUT_RDWR);}
+        }
+        for(std::thread& worker : workers) {worker.join();}
+      }
+
+      /// The base url of the server, always ending in a '/'.
+      std::string url() const { return "http://127.0.0.1:" + std::to_string(port) + "/"; }
+
+      /// The amount of TCP connections accepted so far.
+      std::size_t connections() const { return accepted; }
+
+      /// The amount of requests answered so far.
+      std::size_t requests() const { return answered; }
+
+      /// The amount of response bytes, headers included, written to all connections so far.
+      std::size_t bytes_sent() const { return sent_total; }
+
+      /// Paces every connection to at most bytes_per_second to simulate a constrained link, 0 removes the limit.
+      void throttle(std::size_t bytes_per_second) { pace = bytes_per_second; }
+
+    private:
+      Handler handler;
+      std::chrono::microseconds handshake_delay;
+      int listen_fd = -1;
+      unsigned short port = 0;
+      std::atomic<bool> stopping{false};
+      std::atomic<std::size_t> accepted{0};
+      std::atomic<std::size_t> answered{0};
+      std::atomic<std::size_t> sent_total{0};
+      std::atomic<std::size_t> pace{0};
+      std::thread acceptor;
+      std::vector<std::thread> workers;
+      std::mutex clients_mutex;
+      std::vector<int> client_fds;
+
+      void accept_loop()
+      {
+        while(!stopping) {
+          int fd = ::accept(listen_fd, nullptr, nullptr);
+          if(fd < 0) {continue;}
+          ++accepted;
+          std::lock_guard<std::mutex> lock(clients_mutex);
+          client_fds.push_back(fd);
+          workers.emplace_back([this, fd] { serve(fd); });
+        }
+      }
+
+      void serve(int fd)
+      {
+        if(handshake_delay.count() > 0) {std::this_thread::sleep_for(handshake_delay);}
+        std::string pending;
+        char chunk[16384];
+        while(!stopping) {
+          std::size_t header_end = pending.find("\r\n\r\n");
+          if(header_end == std::string::npos) {
+            ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+            if(received <= 0) {break;}
+            pending.append(chunk, static_cast<std::size_t>(received));
+            continue;
+          }
+          LocalRequest request = parse(pending.substr(0, header_end));
+          pending.erase(0, header_end + 4);
+          LocalReply reply = handler(request);
+          bool close = request.headers["connection"] == "close";
+          std::string raw = "HTTP/1.1 " + std::to_string(reply.status) + " Status\r\n";
+          for(const auto& header : reply.headers) {raw += header.first + ": " + header.second + "\r\n";}
+          raw += "Content-Length: " + std::to_string(reply.body.size()) + "\r\n";
+          raw += close ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n";
+          // A response to HEAD announces the body but leaves it out.
+          if(request.method != "HEAD") {raw += reply.body;}
+          if(!send_all(fd, raw)) {break;}
+          ++answered;
+          if(close) {break;}
+        }
+        std::lock_guard<std::mutex> lock(clients_mutex);
+        client_fds.erase(std::remove(client_fds.begin(), client_fds.end(), fd), client_fds.end());
+        ::close(fd);
+      }
+
+      static LocalRequest parse(const std::string& head)
+      {
+        LocalRequest request;
+        std::size_t line_end = head.find("\r\n");
+        std::string request_line = head.substr(0, line_end);
+        std::size_t first_space = request_line.find(' ');
+        std::size_t second_space = request_line.find(' ', first_space + 1);
+        request.method = request_line.substr(0, first_space);
+        request.target = request_line.substr(first_space + 1, second_space - first_space - 1);
+        while(line_end != std::string::npos) {
+          std::size_t start = line_end + 2;
+          line_end = head.find("\r\n", start);
+          std::string line = head.substr(start, line_end == std::string::npos ? std::string::npos : line_end - start);
+          std::size_t colon = line.find(':');
+          if(colon == std::string::npos) {continue;}
+          std::string name = line.substr(0, colon);
+          for(char& c : name) {c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));}
+          std::size_t value_start = line.find_first_not_of(' ', colon + 1);
+          request.headers[name] = value_start == std::string::npos ? "" : line.substr(value_start);
+        }
+        return request;
+      }
+
+      bool send_all(int fd, const std::string& data)
+      {
+        const std::size_t SLICE = 16384;
+        auto start = std::chrono::steady_clock::now();
+        std::size_t sent = 0;
+        while(sent < data.size()) {
+          std::size_t limit = pace;
+          std::size_t length = limit == 0 ? data.size() - sent : std::min(SLICE, data.size() - sent);
+          ssize_t result = ::send(fd, data.data() + sent, length, MSG_NOSIGNAL);
+          if(result <= 0) {return false;}
+          sent += static_cast<std::size_t>(result);
+          sent_total += static_cast<std::size_t>(result);
+          if(limit != 0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds((sent * 1000000) / limit));
+          }
+        }
+        return true;
+      }
+  };
+
+}
+
+#endif
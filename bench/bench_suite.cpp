@@ -0,0 +1,1089 @@
+#include "../include/cbirdpp/cbirdpp.h"
+#include "../include/cbirdpp/AsyncEngine.h"
+#include "../include/cbirdpp/ConnectionPool.h"
+#include "../include/cbirdpp/FieldTable.h"
+#include "../include/cbirdpp/JsonReader.h"
+#include "../include/cbirdpp/MemoryTransport.h"
+#include "../include/cbirdpp/ResponseBuffer.h"
+#include "../include/cbirdpp/StructuralIndex.h"
+#include "../include/nlohmann/json.hpp"
+using cbirdpp::AsyncEngine;
+using cbirdpp::ConnectionPool;
+using cbirdpp::DataOptionalParameters;
+using cbirdpp::DetailedObservations;
+using cbirdpp::HttpVersion;
+using cbirdpp::JsonReader;
+using cbirdpp::MemoryTransport;
+using cbirdpp::ObservationFields;
+using cbirdpp::RateLimiter;
+using cbirdpp::RequesterOptions;
+using cbirdpp::ResponseBuffer;
+using cbirdpp::SharedContext;
+using cbirdpp::StructuralIndex;
+using cbirdpp::Timestamp;
+using nlohmann::json;
+
+#include "LocalH2Server.h"
+#include "LocalServer.h"
+using cbirdpp_bench::LocalH2Server;
+using cbirdpp_bench::LocalReply;
+using cbirdpp_bench::LocalRequest;
+using cbirdpp_bench::LocalServer;
+
+#include <curlpp/cURLpp.hpp>
+#include <curlpp/Easy.hpp>
+#include <curlpp/Options.hpp>
+
+#include <algorithm>
+
+#include <atomic>
+using std::atomic;
+
+#include <chrono>
+using std::chrono::duration;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+#include <cstdio>
+
+#include <cstdlib>
+
+#include <malloc.h>
+
+#include <new>
+
+#include <exception>
+using std::exception_ptr;
+
+#include <fstream>
+using std::ifstream;
+
+#include <functional>
+using std::function;
+
+#include <future>
+using std::promise;
+
+#include <limits>
+
+#include <list>
+using std::list;
+
+#include <mutex>
+
+#include <random>
+
+#include <sstream>
+using std::ostringstream;
+
+#include <string>
+using std::string;
+
+#include <string_view>
+using std::string_view;
+
+#include <thread>
+
+#include <vector>
+using std::vector;
+
+#include <zlib.h>
+
+// Benchmarks are run from the repository root, like the test suite.
+const string MISC_DIR = "misc/";
+
+// Every heap allocation of the process goes through the replaced operator new below, which keeps these counts.
+atomic<std::size_t> allocations(0);
+atomic<std::size_t> live_bytes(0);
+atomic<std::size_t> peak_bytes(0);
+
+void* operator new(std::size_t size)
+{
+  void* memory = std::malloc(size == 0 ? 1 : size);
+  if(memory == nullptr) {throw std::bad_alloc();}
+  ++allocations;
+  std::size_t live = live_bytes += malloc_usable_size(memory);
+  std::size_t peak = peak_bytes;
+  while(live > peak && !peak_bytes.compare_exchange_weak(peak, live)) {}
+  return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+  if(memory == nullptr) {return;}
+  live_bytes -= malloc_usable_size(memory);
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+  operator delete(memory);
+}
+
+/*
+ * Allocations and peak heap growth of one run of body, the peak is measured from the live heap size at the start.
+ */
+struct AllocationStats
+{
+  std::size_t count;
+  std::size_t peak;
+};
+
+AllocationStats count_allocations(const function<void()>& body)
+{
+  std::size_t count_before = allocations;
+  std::size_t live_before = live_bytes;
+  peak_bytes = live_before;
+  body();
+  return AllocationStats{allocations - count_before, peak_bytes - live_before};
+}
+
+string read_file(const string& path)
+{
+  ifstream fin(path);
+  ostringstream contents;
+  contents << fin.rdbuf();
+  return contents.str();
+}
+
+/*
+ * A detailed observations response like the ones returned for a busy region, with rows varied enough that it does
+ * not compress unrealistically well. Responses with a different first_row have the same species and locations, but
+ * other checklists and observation ids.
+ */
+string synthetic_observations(std::size_t rows, std::size_t first_row=0)
+{
+  const vector<string> species = {"amecro", "norcar", "mallar3", "blujay", "amerob", "houspa", "rewbla", "dowwoo"};
+  const vector<string> names = {"American Crow", "Northern Cardinal", "Mallard", "Blue Jay", "American Robin",
+                                "House Sparrow", "Red-winged Blackbird", "Downy Woodpecker"};
+  std::mt19937 generator(1234);
+  std::uniform_int_distribution<int> pick(0, static_cast<int>(species.size()) - 1);
+  std::uniform_int_distribution<int> count(1, 40);
+  std::uniform_real_distribution<double> offset(-0.5, 0.5);
+  ostringstream out;
+  out.precision(7);
+  out << '[';
+  for(std::size_t row = 0; row < rows; ++row) {
+    int which = pick(generator);
+    string sub = "S" + std::to_string(45000000 + (first_row + row) * 7);
+    string loc = "L" + std::to_string(100000 + (row * 31) % 5000);
+    if(row > 0) {out << ',';}
+    out << "{\"speciesCode\":\"" << species[which] << "\",\"comName\":\"" << names[which]
+        << "\",\"sciName\":\"Genus species\",\"locId\":\"" << loc << "\",\"locID\":\"" << loc << "\",\"locName\":\"Park " << loc
+        << "\",\"obsDt\":\"2018-05-" << 10 + row % 18 << " 0" << row % 10 << ":1" << row % 6 << "\",\"howMany\":"
+        << count(generator) << ",\"lat\":" << 42.0 + offset(generator) << ",\"lng\":" << -76.5 + offset(generator)
+        << ",\"obsValid\":true,\"obsReviewed\":false,\"locationPrivate\":" << (row % 3 == 0 ? "true" : "false")
+        << ",\"subId\":\"" << sub << "\",\"subnational2Code\":\"US-NY-109\",\"subnational2Name\":\"Tompkins\""
+        << ",\"subnational1Code\":\"US-NY\",\"subnational1Name\":\"New York\",\"countryCode\":\"US\""
+        << ",\"countryName\":\"United States\",\"userDisplayName\":\"Observer " << row % 250
+        << "\",\"obsId\":\"OBS" << 600000000 + first_row + row << "\",\"checklistId\":\"CL" << 24000 + row % 900
+        << "\",\"presenceNoted\":false,\"hasComments\":" << (row % 5 == 0 ? "true" : "false")
+        << ",\"firstName\":\"Observer\",\"lastName\":\"" << row % 250 << "\",\"hasRichMedia\":false}";
+  }
+  out << ']';
+  return out.str();
+}
+
+/// Compresses data into the gzip format, the way a server honouring "Accept-Encoding: gzip" would.
+string gzip(const string& data)
+{
+  z_stream stream{};
+  deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+  string compressed(deflateBound(&stream, data.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+  stream.avail_out = static_cast<uInt>(compressed.size());
+  deflate(&stream, Z_FINISH);
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+  return compressed;
+}
+
+/*
+ * Runs body iterations times and prints the mean, median and 99th percentile of a single run in microseconds.
+ */
+void report(const string& name, int iterations, const function<void()>& body)
+{
+  vector<double> samples;
+  samples.reserve(iterations);
+  for(int i = 0; i < iterations; ++i) {
+    auto start = steady_clock::now();
+    body();
+    samples.push_back(duration<double, std::micro>(steady_clock::now() - start).count());
+  }
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for(double sample : samples) {total += sample;}
+  std::printf("  %-44s mean %9.1f us   p50 %9.1f us   p99 %9.1f us\n", name.c_str(), total / iterations,
+              samples[samples.size() / 2], samples[(samples.size() * 99) / 100]);
+}
+
+/*
+ * Per request latency of the old request_json setup (global init and a fresh handle for every request) against
+ * handles leased from a ConnectionPool, with and without a simulated handshake cost on new connections.
+ */
+void bench_connection_pool(int iterations)
+{
+  std::printf("ConnectionPool: %d requests for top100_example.json\n", iterations);
+  string body = read_file(MISC_DIR + "top100_example.json");
+  list<string> headers = {"X-eBirdApiToken: bench"};
+  for(microseconds handshake : {microseconds(0), microseconds(milliseconds(5))}) {
+    std::printf(" simulated handshake %lld us\n", static_cast<long long>(handshake.count()));
+    {
+      LocalServer server(body, handshake);
+      // Must run before any ConnectionPool exists, otherwise the pool's global init keeps libcurl alive in between.
+      report("fresh Cleanup + Easy per request", iterations, [&] {
+        cURLpp::Cleanup cleaner;
+        cURLpp::Easy handle;
+        handle.setOpt(cURLpp::Options::Url(server.url()));
+        handle.setOpt(cURLpp::Options::HttpHeader(headers));
+        ostringstream out_stream;
+        handle.setOpt(new cURLpp::Options::WriteStream(&out_stream));
+        handle.perform();
+      });
+      std::printf("  %-44s %zu\n", "connections opened", server.connections());
+    }
+    {
+      LocalServer server(body, handshake);
+      ConnectionPool pool;
+      report("ConnectionPool lease per request", iterations, [&] {
+        ConnectionPool::Lease handle = pool.acquire();
+        handle->setOpt(cURLpp::Options::Url(server.url()));
+        handle->setOpt(cURLpp::Options::HttpHeader(headers));
+        ostringstream out_stream;
+        handle->setOpt(new cURLpp::Options::WriteStream(&out_stream));
+        handle->perform();
+      });
+      std::printf("  %-44s %zu\n", "connections opened", server.connections());
+    }
+  }
+}
+
+/*
+ * Wall time of fanning out many region queries with a random server side latency, once one after another on pooled
+ * handles, and once all at the same time through the AsyncEngine.
+ */
+void bench_async_fan_out(int fan_out)
+{
+  std::printf("AsyncEngine: fan out of %d requests with 1-10 ms of server latency each\n", fan_out);
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> latency_ms(1, 10);
+  vector<milliseconds> latencies;
+  for(int i = 0; i < fan_out; ++i) {latencies.emplace_back(latency_ms(generator));}
+  milliseconds slowest = *std::max_element(latencies.begin(), latencies.end());
+  string body = read_file(MISC_DIR + "top100_example.json");
+
+  LocalServer server([&](const LocalRequest& request) {
+    std::this_thread::sleep_for(latencies[std::stoul(request.target.substr(request.target.rfind('/') + 1))]);
+    LocalReply reply;
+    reply.body = body;
+    return reply;
+  });
+  list<string> headers = {"X-eBirdApiToken: bench"};
+
+  auto start = steady_clock::now();
+  ConnectionPool pool;
+  for(int i = 0; i < fan_out; ++i) {
+    ConnectionPool::Lease handle = pool.acquire();
+    handle->setOpt(cURLpp::Options::Url(server.url() + "region/" + std::to_string(i)));
+    handle->setOpt(cURLpp::Options::HttpHeader(headers));
+    ostringstream out_stream;
+    handle->setOpt(new cURLpp::Options::WriteStream(&out_stream));
+    handle->perform();
+  }
+  double sequential = duration<double, std::milli>(steady_clock::now() - start).count();
+
+  start = steady_clock::now();
+  {
+    AsyncEngine engine;
+    atomic<int> remaining(fan_out);
+    promise<void> all_done;
+    for(int i = 0; i < fan_out; ++i) {
+      engine.submit(server.url() + "region/" + std::to_string(i), headers, [&](const ResponseBuffer&, const exception_ptr&) {
+        if(--remaining == 0) {all_done.set_value();}
+      });
+    }
+    all_done.get_future().wait();
+  }
+  double fanned_out = duration<double, std::milli>(steady_clock::now() - start).count();
+
+  std::printf("  %-44s %9.1f ms\n", "sequential on pooled handles", sequential);
+  std::printf("  %-44s %9.1f ms\n", "concurrent through AsyncEngine", fanned_out);
+  std::printf("  %-44s %9lld ms\n", "slowest single response", static_cast<long long>(slowest.count()));
+}
+
+/*
+ * Submits fan_out requests to the engine at once and returns the wall time in milliseconds until all completed.
+ * Transfers that failed are counted in failures.
+ */
+double fan_out_through(AsyncEngine& engine, const string& url, int fan_out, int& failures)
+{
+  list<string> headers = {"X-eBirdApiToken: bench"};
+  auto start = steady_clock::now();
+  atomic<int> remaining(fan_out);
+  atomic<int> failed(0);
+  promise<void> all_done;
+  for(int i = 0; i < fan_out; ++i) {
+    engine.submit(url + "region/" + std::to_string(i), headers, [&](const ResponseBuffer&, const exception_ptr& error) {
+      if(error) {++failed;}
+      if(--remaining == 0) {all_done.set_value();}
+    });
+  }
+  all_done.get_future().wait();
+  failures = failed;
+  return duration<double, std::milli>(steady_clock::now() - start).count();
+}
+
+/*
+ * The same fan out over HTTP/1.1 with a connection per concurrent transfer, and multiplexed over HTTP/2 with a few
+ * stream concurrency limits. New connections pay a simulated 5 ms handshake. libcurl 7.88 fails to reuse cleartext
+ * prior knowledge HTTP/2 connections, so the HTTP/2 rows need a newer libcurl to be meaningful.
+ */
+void bench_http2_multiplexing(int fan_out)
+{
+  std::printf("HTTP/2: fan out of %d requests, 1-10 ms server latency, 5 ms simulated handshake\n", fan_out);
+  std::mt19937 generator(7);
+  std::uniform_int_distribution<int> latency_ms(1, 10);
+  vector<milliseconds> latencies;
+  for(int i = 0; i < fan_out; ++i) {latencies.emplace_back(latency_ms(generator));}
+  string body = read_file(MISC_DIR + "top100_example.json");
+  microseconds handshake = milliseconds(5);
+  int failures = 0;
+
+  for(unsigned int connections : {0u, 6u}) {
+    LocalServer server([&](const LocalRequest& request) {
+      std::this_thread::sleep_for(latencies[std::stoul(request.target.substr(request.target.rfind('/') + 1))]);
+      LocalReply reply;
+      reply.body = body;
+      return reply;
+    }, handshake);
+    RequesterOptions options;
+    options.set_max_host_connections(connections);
+    AsyncEngine engine(options);
+    double wall = fan_out_through(engine, server.url(), fan_out, failures);
+    string name = connections == 0 ? "HTTP/1.1, unlimited connections" : "HTTP/1.1, " + std::to_string(connections) + " connections";
+    std::printf("  %-36s %9.1f ms   failures %3d   connections %4zu\n", name.c_str(), wall, failures, server.connections());
+  }
+  for(unsigned int streams : {100u, 20u}) {
+    RequesterOptions options;
+    options.set_http_version(HttpVersion::http2_prior_knowledge);
+    options.set_max_concurrent_streams(streams);
+    options.set_max_host_connections(1);
+    LocalH2Server server(body, [&](std::size_t request) { return latencies[request % latencies.size()]; }, 1000, handshake);
+    AsyncEngine engine(options);
+    double wall = fan_out_through(engine, server.url(), fan_out, failures);
+    string name = "HTTP/2, " + std::to_string(streams) + " streams per connection";
+    std::printf("  %-36s %9.1f ms   failures %3d   connections %4zu   peak streams %zu\n", name.c_str(), wall, failures,
+                server.connections(), server.peak_streams());
+  }
+}
+
+/*
+ * A 10,000 row detailed observations response fetched with and without compression negotiated, over loopback and
+ * over a link paced to 100 Mbit/s. The server only compresses when the request offers gzip.
+ */
+void bench_compression(int iterations)
+{
+  string body = synthetic_observations(10000);
+  string compressed = gzip(body);
+  std::printf("Compression: 10000 detailed observations, %zu bytes plain, %zu bytes gzip\n", body.size(), compressed.size());
+  LocalServer server([&](const LocalRequest& request) {
+    LocalReply reply;
+    if(request.headers.count("accept-encoding") && request.headers.at("accept-encoding").find("gzip") != string::npos) {
+      reply.headers.emplace_back("Content-Encoding", "gzip");
+      reply.body = compressed;
+    } else {
+      reply.body = body;
+    }
+    return reply;
+  });
+  list<string> headers = {"X-eBirdApiToken: bench"};
+  for(std::size_t link : {std::size_t(0), std::size_t(100000000 / 8)}) {
+    server.throttle(link);
+    std::printf(" %s\n", link == 0 ? "loopback" : "100 Mbit/s link");
+    for(bool compression : {false, true}) {
+      RequesterOptions options;
+      options.set_compression(compression);
+      ConnectionPool pool(1, options);
+      std::size_t sent_before = server.bytes_sent();
+      std::size_t received = 0;
+      report(compression ? "Accept-Encoding offered" : "identity", iterations, [&] {
+        ConnectionPool::Lease handle = pool.acquire();
+        handle->setOpt(cURLpp::Options::Url(server.url()));
+        handle->setOpt(cURLpp::Options::HttpHeader(headers));
+        ostringstream out_stream;
+        handle->setOpt(new cURLpp::Options::WriteStream(&out_stream));
+        handle->perform();
+        received = out_stream.str().size();
+      });
+      std::printf("  %-44s %zu bytes on the wire, %zu bytes decoded\n", "per request",
+                  (server.bytes_sent() - sent_before) / iterations, received);
+    }
+  }
+}
+
+/*
+ * Heap allocations, peak heap growth and time for receiving a multi-megabyte response and handing it to the JSON
+ * parser: the old way through an ostringstream with the headers mixed in and str() and substr() copies, against a pooled ResponseBuffer that
+ * was sized from Content-Length and is parsed in place. The stand-in server allocates in the same process, so a run
+ * that discards the received bytes is measured as the baseline, and the parse itself is shown for reference.
+ */
+void bench_response_sink(int iterations)
+{
+  string body = synthetic_observations(20000);
+  std::printf("Response sink: %zu byte response\n", body.size());
+  LocalServer server(body);
+  list<string> headers = {"X-eBirdApiToken: bench"};
+  RequesterOptions options;
+  options.set_compression(false);
+  ConnectionPool pool(1, options);
+  std::size_t found = 0;
+
+  auto stream_sink = [&] {
+    ConnectionPool::Lease handle = pool.acquire();
+    handle->setOpt(cURLpp::Options::Url(server.url()));
+    handle->setOpt(cURLpp::Options::Header(true));
+    handle->setOpt(cURLpp::Options::HttpHeader(headers));
+    ostringstream out_stream;
+    handle->setOpt(new cURLpp::Options::WriteStream(&out_stream));
+    handle->perform();
+    size_t json_start = out_stream.str().find('[');
+    if(json_start == string::npos) {json_start = out_stream.str().find('{');}
+    string text = out_stream.str().substr(json_start);
+    found += text.size();
+  };
+  auto buffer_sink = [&] {
+    ConnectionPool::Lease handle = pool.acquire();
+    handle->setOpt(cURLpp::Options::Url(server.url()));
+    handle->setOpt(cURLpp::Options::HttpHeader(headers));
+    handle.buffer().attach(*handle);
+    handle->perform();
+    found += handle.buffer().view().size();
+  };
+
+  auto discard_sink = [&] {
+    ConnectionPool::Lease handle = pool.acquire();
+    handle->setOpt(cURLpp::Options::Url(server.url()));
+    handle->setOpt(cURLpp::Options::HttpHeader(headers));
+    handle->setOpt(cURLpp::Options::WriteFunction([&](char*, size_t size, size_t count) {
+      found += size * count;
+      return size * count;
+    }));
+    handle->perform();
+  };
+
+  for(int warm_up = 0; warm_up < 2; ++warm_up) {stream_sink(); buffer_sink();}
+  AllocationStats discard = count_allocations(discard_sink);
+  AllocationStats stream = count_allocations(stream_sink);
+  AllocationStats buffer = count_allocations(buffer_sink);
+  AllocationStats parse = count_allocations([&] { found += json::parse(body).size(); });
+  report("baseline: bytes discarded", iterations, discard_sink);
+  std::printf("  %-44s %zu allocations, peak %.1f MB\n", "", discard.count, discard.peak / 1e6);
+  report("ostringstream + str() copies", iterations, stream_sink);
+  std::printf("  %-44s %zu allocations, peak %.1f MB\n", "", stream.count, stream.peak / 1e6);
+  report("pooled ResponseBuffer, view", iterations, buffer_sink);
+  std::printf("  %-44s %zu allocations, peak %.1f MB\n", "", buffer.count, buffer.peak / 1e6);
+  std::printf("  %-44s %zu allocations, peak %.1f MB\n", "reference: json::parse of the body", parse.count,
+              parse.peak / 1e6);
+  if(found == 0) {std::printf("  nothing received\n");}
+}
+
+/*
+ * Cold request latency of a worker pool: every round starts fresh workers that each make one request, the way jobs
+ * that construct their own Requester do. Independent workers each bring their own ConnectionPool and resolve and
+ * connect from scratch, workers on a SharedContext pick up the cached DNS result and the connections earlier rounds
+ * left in the shared pool. New connections pay a simulated 5 ms handshake.
+ */
+void bench_shared_context(int rounds)
+{
+  const int WORKERS = 8;
+  std::printf("SharedContext: %d rounds of %d workers making their first request, 5 ms simulated handshake\n", rounds, WORKERS);
+  string body = read_file(MISC_DIR + "top100_example.json");
+  list<string> headers = {"X-eBirdApiToken: bench"};
+
+  auto run_workers = [&](const function<std::shared_ptr<ConnectionPool>()>& pool_for_worker, const string& url) {
+    vector<double> latencies(WORKERS * rounds);
+    for(int round = 0; round < rounds; ++round) {
+      vector<std::thread> workers;
+      for(int worker = 0; worker < WORKERS; ++worker) {
+        workers.emplace_back([&, round, worker] {
+          std::shared_ptr<ConnectionPool> pool = pool_for_worker();
+          auto start = steady_clock::now();
+          ConnectionPool::Lease handle = pool->acquire();
+          handle->setOpt(cURLpp::Options::Url(url));
+          handle->setOpt(cURLpp::Options::HttpHeader(headers));
+          handle.buffer().attach(*handle);
+          handle->perform();
+          latencies[round * WORKERS + worker] = duration<double, std::micro>(steady_clock::now() - start).count();
+        });
+      }
+      for(std::thread& worker : workers) {worker.join();}
+    }
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0;
+    for(double latency : latencies) {total += latency;}
+    return std::make_pair(total / latencies.size(), latencies[latencies.size() / 2]);
+  };
+
+  for(bool shared : {false, true}) {
+    LocalServer server(body, milliseconds(5));
+    string url = "http://localhost:" + server.url().substr(server.url().rfind(':') + 1);
+    SharedContext context;
+    auto result = run_workers([&] {
+      return shared ? context.connections() : std::make_shared<ConnectionPool>();
+    }, url);
+    std::printf("  %-44s mean %9.1f us   p50 %9.1f us   connections %zu\n",
+                shared ? "workers on one SharedContext" : "independent workers", result.first, result.second,
+                server.connections());
+  }
+}
+
+/*
+ * A bulk crawl against a server that tolerates 200 requests per second and answers 429 beyond that, retrying every
+ * 429 until the wanted amount of responses succeeded. Without a limiter the crawl fires everything at once and
+ * retries blindly, with the adaptive RateLimiter it settles just under the server's limit.
+ */
+void bench_rate_limiting(int successes)
+{
+  const double SERVER_RATE = 200;
+  std::printf("RateLimiter: crawl until %d requests succeed, server allows %.0f requests/s\n", successes, SERVER_RATE);
+  string body = read_file(MISC_DIR + "top100_example.json");
+
+  for(bool limited : {false, true}) {
+    std::mutex bucket_mutex;
+    double tokens = 10;
+    auto refilled = steady_clock::now();
+    LocalServer server([&](const LocalRequest&) {
+      LocalReply reply;
+      {
+        std::lock_guard<std::mutex> lock(bucket_mutex);
+        auto now = steady_clock::now();
+        tokens = std::min(10.0, tokens + duration<double>(now - refilled).count() * SERVER_RATE);
+        refilled = now;
+        if(tokens >= 1) {
+          tokens -= 1;
+          reply.body = body;
+        } else {
+          reply.status = 429;
+        }
+      }
+      std::this_thread::sleep_for(milliseconds(2));
+      return reply;
+    });
+
+    auto limiter = limited ? std::make_shared<RateLimiter>(400, 64) : nullptr;
+    AsyncEngine engine(RequesterOptions(), nullptr, limiter);
+    list<string> headers = {"X-eBirdApiToken: bench"};
+    atomic<int> succeeded(0);
+    atomic<int> throttled(0);
+    promise<void> all_done;
+    function<void()> submit_one = [&] {
+      engine.submit(server.url(), headers, [&](const ResponseBuffer& response, const exception_ptr& error) {
+        if(!error && response.status() == 429) {
+          ++throttled;
+          submit_one();
+        } else if(++succeeded == successes) {
+          all_done.set_value();
+        }
+      });
+    };
+    auto start = steady_clock::now();
+    for(int i = 0; i < successes; ++i) {submit_one();}
+    all_done.get_future().wait();
+    double wall = duration<double, std::milli>(steady_clock::now() - start).count();
+    std::printf("  %-28s %8.1f ms   %6d x 429", limited ? "adaptive RateLimiter" : "no limiter", wall, throttled.load());
+    if(limiter) {
+      std::printf("   settled at %.0f requests/s, concurrency %.1f", limiter->rate(), limiter->concurrency_limit());
+    }
+    std::printf("\n");
+  }
+}
+
+void bench_hedging(int requests)
+{
+  const double SLOW_SHARE = 0.02;
+  std::printf("Hedging: %d sequential get_top_100 calls, %.0f%% of responses stall for 250 ms\n", requests, SLOW_SHARE * 100);
+  string body = read_file(MISC_DIR + "top100_example.json");
+
+  for(bool hedged : {false, true}) {
+    std::mutex random_mutex;
+    std::mt19937 random(42);
+    std::bernoulli_distribution stall(SLOW_SHARE);
+    LocalServer server([&](const LocalRequest&) {
+      bool slow;
+      {
+        std::lock_guard<std::mutex> lock(random_mutex);
+        slow = stall(random);
+      }
+      std::this_thread::sleep_for(milliseconds(slow ? 250 : 3));
+      LocalReply reply;
+      reply.headers.push_back({"Content-Type", "application/json;charset=utf-8"});
+      reply.body = body;
+      return reply;
+    });
+
+    RequesterOptions options;
+    options.set_api_url(server.url());
+    options.set_hedging(hedged);
+    cbirdpp::Requester requester("bench", options);
+    vector<double> latencies;
+    for(int i = 0; i < requests; ++i) {
+      auto start = steady_clock::now();
+      requester.get_top_100("US-NY", 2020, 5, 1);
+      latencies.push_back(duration<double, std::milli>(steady_clock::now() - start).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double share) { return latencies[static_cast<std::size_t>(share * (latencies.size() - 1))]; };
+    std::printf("  %-28s p50 %6.1f ms   p95 %6.1f ms   p99 %6.1f ms   %4.1f%% extra requests\n",
+                hedged ? "hedged after p95" : "single request", percentile(0.5), percentile(0.95), percentile(0.99),
+                std::max(0.0, 100.0 * (static_cast<double>(server.requests()) - requests) / requests));
+  }
+}
+
+void bench_single_flight(int callers)
+{
+  std::printf("SingleFlight: %d threads request the same notable observations at once, 20 ms server time\n", callers);
+  string body = synthetic_observations(2000);
+
+  for(bool shared : {false, true}) {
+    LocalServer server([&](const LocalRequest&) {
+      std::this_thread::sleep_for(milliseconds(20));
+      LocalReply reply;
+      reply.headers.push_back({"Content-Type", "application/json;charset=utf-8"});
+      reply.body = body;
+      return reply;
+    });
+    RequesterOptions options;
+    options.set_api_url(server.url());
+    // Without coalescing every thread ends up with its own request, as with one Requester per worker before.
+    cbirdpp::Requester requester("bench", options);
+    vector<cbirdpp::Requester> requesters;
+    for(int i = 0; i < callers; ++i) {requesters.push_back(shared ? requester : cbirdpp::Requester("bench", options));}
+
+    vector<std::thread> threads;
+    auto start = steady_clock::now();
+    for(int i = 0; i < callers; ++i) {
+      threads.emplace_back([&, i] { requesters[i].get_recent_notable_observations_in_region("US-CA"); });
+    }
+    for(std::thread& thread : threads) {thread.join();}
+    double wall = duration<double, std::milli>(steady_clock::now() - start).count();
+    std::printf("  %-28s %8.1f ms   %4zu upstream requests\n", shared ? "coalesced" : "one request per caller", wall, server.requests());
+  }
+}
+
+void bench_decode(int iterations)
+{
+  std::printf("Decode: %d blocking requests per endpoint served from memory, no network involved, %u hardware threads\n",
+              iterations, std::thread::hardware_concurrency());
+  RequesterOptions options;
+  options.set_revalidation_cache(0);   // Every request has to decode a full body.
+  auto transport = std::make_shared<MemoryTransport>();
+  string observations = synthetic_observations(2000);
+  string large = synthetic_observations(10000);
+  transport->serve(options.api_url() + "data/obs/", observations);
+  transport->serve(options.api_url() + "data/obs/geo/", large);
+  transport->serve_file(options.api_url() + "product/top100/", MISC_DIR + "top100_example.json");
+  transport->serve_file(options.api_url() + "product/lists/", MISC_DIR + "checklist_feed_example.json");
+  transport->serve_file(options.api_url() + "product/stats/", MISC_DIR + "regional_statistics_example.json");
+  cbirdpp::Requester requester("bench", transport, options);
+
+  auto run = [&](const char* name, std::size_t bytes, const function<void()>& request) {
+    request();
+    auto start = steady_clock::now();
+    for(int i = 0; i < iterations; ++i) {request();}
+    double seconds = duration<double>(steady_clock::now() - start).count();
+    std::printf("  %-36s %10.1f us/request %8.1f MB/s\n", name, seconds * 1e6 / iterations, bytes * iterations / seconds / 1e6);
+  };
+  run("observations, 2000 rows", observations.size(), [&] { requester.get_recent_observations_in_region("US-NY"); });
+  run("observation views, 2000 rows", observations.size(), [&] { requester.view_recent_observations_in_region("US-NY"); });
+  run("observations, 10000 rows", large.size(), [&] { requester.get_recent_nearby_observations(42.5, -76.5); });
+  run("detailed, 10000 rows", large.size(), [&] { requester.get_detailed_recent_nearby_notable_observations(42.5, -76.5); });
+  DataOptionalParameters projection;
+  projection.set_fields(ObservationFields::speciesCode | ObservationFields::obsDt | ObservationFields::lat | ObservationFields::lng);
+  run("detailed, 10000 rows, 4 of 28 fields", large.size(), [&] { requester.get_detailed_recent_nearby_notable_observations(42.5, -76.5, projection); });
+  // Large responses split into a run per thread, on a single core machine this only shows the cost of splitting.
+  RequesterOptions parallel = options;
+  parallel.set_parallel_decode(1024, 4);
+  cbirdpp::Requester parallel_requester("bench", transport, parallel);
+  run("detailed, 10000 rows, 4 threads", large.size(), [&] { parallel_requester.get_detailed_recent_nearby_notable_observations(42.5, -76.5); });
+  run("top 100", read_file(MISC_DIR + "top100_example.json").size(), [&] { requester.get_top_100("US-NY", 2018, 1, 1); });
+  run("checklist feed", read_file(MISC_DIR + "checklist_feed_example.json").size(), [&] { requester.get_checklist_feed_on_date("US-NY", 2018, 1, 1); });
+  run("regional statistics", read_file(MISC_DIR + "regional_statistics_example.json").size(), [&] { requester.get_regional_statistics_on_date("US-NY", 2018, 1, 1); });
+}
+
+void bench_revalidation(int polls)
+{
+  std::printf("Revalidation: %d polls of an unchanged 2000 row observation feed, served from memory\n", polls);
+  string body = synthetic_observations(2000);
+
+  for(unsigned int entries : {0u, 256u}) {
+    RequesterOptions options;
+    options.set_revalidation_cache(entries);
+    auto transport = std::make_shared<MemoryTransport>();
+    transport->serve(options.api_url() + "data/obs/", body);
+    cbirdpp::Requester requester("bench", transport, options);
+    auto start = steady_clock::now();
+    for(int i = 0; i < polls; ++i) {requester.get_recent_observations_in_region("US-NY");}
+    double wall = duration<double, std::micro>(steady_clock::now() - start).count();
+    std::printf("  %-28s %10.1f us/poll   %10zu body bytes\n", entries ? "If-None-Match revalidation" : "full download",
+                wall / polls, transport->bytes_sent());
+  }
+}
+
+void bench_cold_start(int runs)
+{
+  const milliseconds HANDSHAKE(100);
+  const milliseconds STARTUP_WORK(150);
+  std::printf("Cold start: time to the first decoded Observations, %lld ms handshake, %lld ms of other startup work, %d runs\n",
+              static_cast<long long>(HANDSHAKE.count()), static_cast<long long>(STARTUP_WORK.count()), runs);
+  string body = synthetic_observations(100);
+
+  for(unsigned int prewarm : {0u, 2u}) {
+    double total = 0;
+    double first_request = 0;
+    for(int run = 0; run < runs; ++run) {
+      // A fresh server per run, so no connection outlives the Requester it was opened for.
+      LocalServer server([&](const LocalRequest&) {
+        LocalReply reply;
+        reply.headers.push_back({"Content-Type", "application/json;charset=utf-8"});
+        reply.body = body;
+        return reply;
+      }, HANDSHAKE);
+      RequesterOptions options;
+      options.set_api_url(server.url());
+      options.set_prewarm(prewarm);
+      auto start = steady_clock::now();
+      cbirdpp::Requester requester("bench", options);
+      std::this_thread::sleep_for(STARTUP_WORK);
+      auto requested = steady_clock::now();
+      requester.get_recent_observations_in_region("US-NY");
+      auto decoded = steady_clock::now();
+      total += duration<double, std::milli>(decoded - start).count();
+      first_request += duration<double, std::milli>(decoded - requested).count();
+    }
+    std::printf("  %-28s %8.1f ms to first result   %8.1f ms first request\n", prewarm ? "prewarm 2 connections" : "no warm-up",
+                total / runs, first_request / runs);
+  }
+}
+
+void bench_steady_state_allocations(int polls)
+{
+  std::printf("Allocations: steady state polling, %d blocking requests each, revalidation off\n", polls);
+  string observations = synthetic_observations(100);
+  // Large enough to be read through a StructuralIndex.
+  string indexed = synthetic_observations(1000);
+  string top = read_file(MISC_DIR + "top100_example.json");
+  LocalServer server([&](const LocalRequest& request) {
+    LocalReply reply;
+    reply.headers.push_back({"Content-Type", "application/json;charset=utf-8"});
+    reply.body = request.target.find("/top100/") != string::npos ? top : observations;
+    return reply;
+  });
+  RequesterOptions options;
+  options.set_revalidation_cache(0);
+  auto memory = std::make_shared<MemoryTransport>();
+  memory->serve(options.api_url() + "data/obs/", observations);
+  memory->serve(options.api_url() + "data/obs/US-CA/", indexed);
+  memory->serve(options.api_url() + "product/top100/", top);
+  cbirdpp::Requester in_memory("bench", memory, options);
+  options.set_api_url(server.url());
+  cbirdpp::Requester over_curl("bench", options);
+
+  auto run = [&](const char* name, const function<void()>& request) {
+    request();
+    auto start = steady_clock::now();
+    AllocationStats stats = count_allocations([&] { for(int i = 0; i < polls; ++i) {request();} });
+    double elapsed = duration<double, std::micro>(steady_clock::now() - start).count();
+    std::printf("  %-44s %8.1f allocations/request %9.1f us/request %8.1f KiB peak\n", name,
+                static_cast<double>(stats.count) / polls, elapsed / polls, stats.peak / 1024.0);
+  };
+  run("curl, observations (100 rows)", [&] { over_curl.get_recent_observations_in_region("US-NY"); });
+  run("curl, top 100", [&] { over_curl.get_top_100("US-NY", 2018, 1, 1); });
+  run("memory, observations (100 rows)", [&] { in_memory.get_recent_observations_in_region("US-NY"); });
+  run("memory, observation views (100 rows)", [&] { in_memory.view_recent_observations_in_region("US-NY"); });
+  run("memory, top 100", [&] { in_memory.get_top_100("US-NY", 2018, 1, 1); });
+  run("memory, interned observations (1000 rows)", [&] { in_memory.intern_recent_observations_in_region("US-CA"); });
+  run("memory, observation views (1000 rows)", [&] { in_memory.view_recent_observations_in_region("US-CA"); });
+}
+
+void bench_string_interning(int results)
+{
+  const std::size_t ROWS = 2000;
+  std::printf("Interning: a cache of %d detailed responses of %zu rows for different days, served from memory\n", results, ROWS);
+  RequesterOptions options;
+  options.set_revalidation_cache(0);
+  auto transport = std::make_shared<MemoryTransport>();
+  for(int day = 0; day < results; ++day) {
+    transport->serve(options.api_url() + "data/obs/US-NY-" + std::to_string(day) + "/", synthetic_observations(ROWS, day * ROWS));
+  }
+  cbirdpp::Requester requester("bench", transport, options);
+  auto region = [](int day) { return "US-NY-" + std::to_string(day); };
+
+  auto run = [&](const char* name, const function<void()>& fill) {
+    std::size_t live_before = live_bytes;
+    auto start = steady_clock::now();
+    fill();
+    double elapsed = duration<double, std::micro>(steady_clock::now() - start).count();
+    std::printf("  %-30s %10.1f us/request %8.1f MiB kept\n", name, elapsed / results,
+                static_cast<double>(live_bytes - live_before) / (1 << 20));
+  };
+  {
+    vector<DetailedObservations> cache;
+    run("owned strings", [&] {
+      for(int day = 0; day < results; ++day) {cache.push_back(requester.get_detailed_recent_notable_observations_in_region(region(day)));}
+    });
+  }
+  {
+    vector<cbirdpp::InternedDetailedObservations> cache;
+    run("interned strings", [&] {
+      for(int day = 0; day < results; ++day) {cache.push_back(requester.intern_detailed_recent_notable_observations_in_region(region(day)));}
+    });
+    std::size_t equal = 0;
+    auto start = steady_clock::now();
+    for(const auto& rows : cache) {
+      for(const auto& row : rows) {equal += row.comName == cache[0][0].comName;}
+    }
+    double elapsed = duration<double, std::nano>(steady_clock::now() - start).count();
+    std::printf("  %-30s %10.2f ns/row   %8zu matches\n", "interned comName == by pointer", elapsed / (results * ROWS), equal);
+  }
+}
+
+/*
+ * Decoding 10000 detailed observations and destroying the result, with the text of every row on the heap against
+ * the rows and their text in the arena of an ArenaDetailedObservations. The owned result is also copied out of the
+ * decoded result the request shares, where the arena result only copies a pointer to it.
+ */
+void bench_arena(int iterations)
+{
+  std::printf("Arena: %d blocking requests of 10000 detailed observations served from memory, decoded and destroyed\n", iterations);
+  RequesterOptions options;
+  options.set_revalidation_cache(0);
+  auto transport = std::make_shared<MemoryTransport>();
+  transport->serve(options.api_url() + "data/obs/", synthetic_observations(10000));
+  cbirdpp::Requester requester("bench", transport, options);
+
+  auto run = [&](const char* name, const function<void()>& request) {
+    request();
+    auto start = steady_clock::now();
+    AllocationStats stats = count_allocations([&] { for(int i = 0; i < iterations; ++i) {request();} });
+    double elapsed = duration<double, std::milli>(steady_clock::now() - start).count();
+    std::printf("  %-30s %8.2f ms/request %9.1f allocations/request %7.1f MiB peak\n", name, elapsed / iterations,
+                static_cast<double>(stats.count) / iterations, static_cast<double>(stats.peak) / (1 << 20));
+  };
+  auto destroy = [&](const char* name, const auto& make) {
+    double elapsed = 0;
+    for(int i = 0; i < iterations; ++i) {
+      auto result = make();
+      auto start = steady_clock::now();
+      { auto dropped = std::move(result); }
+      elapsed += duration<double, std::milli>(steady_clock::now() - start).count();
+    }
+    std::printf("  %-30s %8.2f ms/result\n", name, elapsed / iterations);
+  };
+  run("owned, decode and destroy", [&] { requester.get_detailed_recent_notable_observations_in_region("US-NY"); });
+  run("arena, decode and destroy", [&] { requester.arena_detailed_recent_notable_observations_in_region("US-NY"); });
+  destroy("owned, destroy only", [&] { return requester.get_detailed_recent_notable_observations_in_region("US-NY"); });
+  destroy("arena, destroy only", [&] { return requester.arena_detailed_recent_notable_observations_in_region("US-NY"); });
+}
+
+/*
+ * Sorting 10000 decoded observations by date and counting those in a two day window, comparing the Timestamp the
+ * rows hold against the text the API sent, which is what rows held before dates were parsed on decode.
+ */
+void bench_time_window(int iterations)
+{
+  std::printf("Time window: %d passes over 10000 decoded observations\n", iterations);
+  RequesterOptions options;
+  auto transport = std::make_shared<MemoryTransport>();
+  transport->serve(options.api_url() + "data/obs/", synthetic_observations(10000));
+  cbirdpp::Requester requester("bench", transport, options);
+  cbirdpp::Observations rows = requester.get_recent_observations_in_region("US-NY");
+  vector<string> texts;
+  for(const auto& row : rows) {texts.push_back(row.obsDt.to_string());}
+  Timestamp from(2018, 5, 14, 12, 0), to(2018, 5, 16, 12, 0);
+  string from_text = from.to_string(), to_text = to.to_string();
+  std::size_t found = 0;
+
+  report("sort by Timestamp", iterations, [&] {
+    vector<Timestamp> times;
+    times.reserve(rows.size());
+    for(const auto& row : rows) {times.push_back(row.obsDt);}
+    std::sort(times.begin(), times.end());
+    found += times.size();
+  });
+  report("sort by text", iterations, [&] {
+    vector<string> sorted = texts;
+    std::sort(sorted.begin(), sorted.end());
+    found += sorted.size();
+  });
+  report("window by Timestamp", iterations, [&] {
+    for(const auto& row : rows) {found += row.obsDt >= from && row.obsDt < to;}
+  });
+  report("window by text", iterations, [&] {
+    for(const string& text : texts) {found += text >= from_text && text < to_text;}
+  });
+  if(found == 0) {std::printf("  nothing found\n");}
+}
+
+/*
+ * A detailed observations response read as a whole against one handed out row by row as it arrives, for the time
+ * until the first row can be used and the heap the request grows to. The body served from memory arrives at once, so
+ * over the network the first row comes earlier still, after its own bytes instead of after the whole transfer.
+ */
+void bench_streaming(int iterations)
+{
+  std::printf("Streaming: %d requests per response size\n", iterations);
+  RequesterOptions options;
+  options.set_revalidation_cache(0);
+  auto transport = std::make_shared<MemoryTransport>();
+  cbirdpp::Requester requester("bench", transport, options);
+  for(std::size_t rows : {std::size_t(10000), std::size_t(40000)}) {
+    transport->serve(options.api_url() + "data/obs/", synthetic_observations(rows));
+    auto run = [&](const char* name, const function<void(steady_clock::time_point&)>& request) {
+      double first = 0, total = 0;
+      std::size_t peak = 0;
+      for(int i = 0; i < iterations; ++i) {
+        steady_clock::time_point first_row;
+        auto start = steady_clock::now();
+        AllocationStats stats = count_allocations([&] { request(first_row); });
+        total += duration<double, std::milli>(steady_clock::now() - start).count();
+        first += duration<double, std::milli>(first_row - start).count();
+        peak = std::max(peak, stats.peak);
+      }
+      std::printf("  %5zu rows, %-10s %8.2f ms to the first row %8.2f ms in all %9.1f KiB peak\n", rows, name,
+                  first / iterations, total / iterations, static_cast<double>(peak) / 1024);
+    };
+    std::size_t seen = 0;
+    run("whole", [&](steady_clock::time_point& first_row) {
+      DetailedObservations result = requester.get_detailed_recent_notable_observations_in_region("US-NY");
+      first_row = steady_clock::now();
+      seen += result.size();
+    });
+    run("streamed", [&](steady_clock::time_point& first_row) {
+      requester.for_each_detailed_recent_notable_observations_in_region("US-NY", [&](const cbirdpp::DetailedObservation&) {
+        if(seen++ % rows == 0) {first_row = steady_clock::now();}
+      });
+    });
+    if(seen == 0) {std::printf("  nothing seen\n");}
+  }
+}
+
+/*
+ * The fields of an Observation the checked decode benchmark reads, the same for both ways of recovering bad rows.
+ */
+using ObservationField = cbirdpp::Fields<cbirdpp::Observation>;
+static constexpr auto CHECKED_BENCH_TABLE = cbirdpp::make_field_table(
+  ObservationField::field("speciesCode", &cbirdpp::Observation::speciesCode),
+  ObservationField::field("comName", &cbirdpp::Observation::comName),
+  ObservationField::field("sciName", &cbirdpp::Observation::sciName),
+  ObservationField::field("locId", &cbirdpp::Observation::locId),
+  ObservationField::field("locName", &cbirdpp::Observation::locName),
+  ObservationField::field("obsDt", &cbirdpp::Observation::obsDt),
+  ObservationField::optional("howMany", &cbirdpp::Observation::howMany, 0),
+  ObservationField::field("lat", &cbirdpp::Observation::lat), ObservationField::field("lng", &cbirdpp::Observation::lng));
+
+/*
+ * 10000 observations with every bad_every-th howMany turned into a string, decoded keeping the good rows: once by
+ * catching the RequestFailed each bad row throws, once with the readers recording their errors instead.
+ */
+void bench_checked_decode(int iterations)
+{
+  std::printf("Checked decode: %d passes over 10000 observations\n", iterations);
+  for(std::size_t bad_every : {std::size_t(0), std::size_t(10), std::size_t(2)}) {
+    string body = synthetic_observations(10000);
+    std::size_t row = 0;
+    for(std::size_t at = body.find("\"howMany\":"); at != string::npos; at = body.find("\"howMany\":", at + 1), ++row) {
+      if(bad_every != 0 && row % bad_every == 0) {body.replace(at, 10, "\"howMany\":\"x\",\"h\":");}
+    }
+    std::size_t kept = 0;
+    auto run = [&](const char* name, const function<void()>& pass) {
+      pass();
+      auto start = steady_clock::now();
+      for(int i = 0; i < iterations; ++i) {pass();}
+      double elapsed = duration<double, std::milli>(steady_clock::now() - start).count();
+      std::printf("  %3zu%% bad rows, %-20s %8.2f ms/pass\n", bad_every == 0 ? 0 : 100 / bad_every, name,
+                  elapsed / iterations);
+    };
+    run("catching exceptions", [&] {
+      cbirdpp::Observations rows;
+      cbirdpp::ArrayStream split;
+      split.feed(body, [&rows](string_view element) {
+        try {
+          JsonReader source(element);
+          if(!cbirdpp::read_fields(source, rows.emplace_back(), CHECKED_BENCH_TABLE)) {throw cbirdpp::RequestFailed();}
+          source.finish();
+        } catch(const cbirdpp::RequestFailed&) {
+          rows.pop_back();
+        }
+      });
+      kept += rows.size();
+    });
+    run("recording errors", [&] {
+      auto read_row = [](JsonReader& source, cbirdpp::Observation& target) {
+        return cbirdpp::read_fields(source, target, CHECKED_BENCH_TABLE);
+      };
+      kept += cbirdpp::read_checked_rows<cbirdpp::Observations>(body, read_row)->size();
+    });
+    if(kept == 0) {std::printf("  nothing kept\n");}
+  }
+}
+
+void bench_structural_index(int iterations)
+{
+  string body = synthetic_observations(10000);
+  std::printf("Structural index: %d passes over 10000 observations, %zu bytes, %s classification\n", iterations,
+              body.size(), StructuralIndex::implementation());
+  std::size_t found = 0;
+  auto run = [&](const char* name, const function<void()>& pass) {
+    pass();
+    auto start = steady_clock::now();
+    for(int i = 0; i < iterations; ++i) {pass();}
+    double seconds = duration<double>(steady_clock::now() - start).count();
+    std::printf("  %-44s %8.3f GB/s\n", name, body.size() * iterations / seconds / 1e9);
+  };
+  run("index only", [&] { found += StructuralIndex(body).positions().size(); });
+  // Every row is stepped through and every member skipped, so the cost is finding where values end.
+  for(std::size_t threshold : {std::numeric_limits<std::size_t>::max(), std::size_t(0)}) {
+    run(threshold ? "walk every member, byte by byte" : "walk every member, indexed", [&] {
+      JsonReader reader(body, threshold);
+      string_view key;
+      reader.begin_array();
+      while(reader.next_element()) {
+        reader.begin_object();
+        while(reader.next_key(key)) {
+          reader.skip_value();
+          ++found;
+        }
+      }
+      reader.finish();
+    });
+  }
+  if(found == 0) {std::printf("  nothing found\n");}
+}
+
+int main(int argc, char **argv)
+{
+  int iterations = argc > 1 ? std::stoi(argv[1]) : 500;
+  bench_connection_pool(iterations);
+  bench_async_fan_out(500);
+  bench_http2_multiplexing(500);
+  bench_compression(std::max(1, iterations / 20));
+  bench_response_sink(std::max(1, iterations / 20));
+  bench_shared_context(std::max(1, iterations / 10));
+  bench_rate_limiting(std::max(100, iterations));
+  bench_hedging(std::max(100, iterations));
+  bench_single_flight(64);
+  bench_decode(std::max(1, iterations / 10));
+  bench_revalidation(std::max(1, iterations / 10));
+  bench_cold_start(10);
+  bench_steady_state_allocations(std::max(1, iterations / 5));
+  bench_structural_index(std::max(1, iterations / 20));
+  bench_string_interning(20);
+  bench_time_window(std::max(1, iterations / 10));
+  bench_arena(std::max(1, iterations / 50));
+  bench_streaming(std::max(1, iterations / 50));
+  bench_checked_decode(std::max(1, iterations / 50));
+  return 0;
+}
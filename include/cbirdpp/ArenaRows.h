@@ -0,0 +1,73 @@
+#ifndef CBIRDPP_ARENAROWS_H
+#define CBIRDPP_ARENAROWS_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace cbirdpp
+{
+
+  class Requester;
+
+  /** \class ArenaRows
+   *  \brief The rows of a response, with the vector holding them and all of their text in one monotonic arena.
+   *
+   *  Row is an allocator aware struct whose text members are std::pmr::strings, so decoding a row takes its memory
+   *  from the arena instead of making a heap allocation per long string, and destroying the result releases the
+   *  arena's few large blocks at once. Copies share the rows and the arena, so handing a result around copies
+   *  nothing, and the arena is released along with the last copy. Since a result may be shared with other callers and
+   *  the revalidation cache, only the Requester decoding it can change its rows.
+   */
+  template <typename Row, typename Owned>
+  class ArenaRows
+  {
+    public:
+      using value_type = Row;
+      using const_iterator = typename std::pmr::vector<Row>::const_iterator;
+
+      ArenaRows() : storage(std::make_shared<Storage>()) {}
+
+      const std::pmr::vector<Row>& rows() const {return storage->rows;}
+
+      const_iterator begin() const {return storage->rows.begin();}
+
+      const_iterator end() const {return storage->rows.end();}
+
+      std::size_t size() const {return storage->rows.size();}
+
+      bool empty() const {return storage->rows.empty();}
+
+      const Row& operator[](std::size_t position) const {return storage->rows[position];}
+
+      /// Owned copies of every row, with their text on the heap.
+      Owned to_owned() const
+      {
+        Owned owned;
+        owned.reserve(size());
+        for(const Row& row : storage->rows) {owned.push_back(row);}
+        return owned;
+      }
+
+    private:
+      friend class Requester;
+
+      // The rows, for the decoder filling in a result. Every copy of the result sees changes made through it.
+      std::pmr::vector<Row>& decoded_rows() {return storage->rows;}
+
+      /*
+       * The arena and the rows allocated from it. The rows are declared last, so they are destroyed before it.
+       */
+      struct Storage
+      {
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::vector<Row> rows{&arena};
+      };
+
+      std::shared_ptr<Storage> storage;
+  };
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef CBIRDPP_ARRAYSTREAM_H
+#define CBIRDPP_ARRAYSTREAM_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace cbirdpp
+{
+
+  /** \class ArrayStream
+   *  \brief Splits a JSON array that arrives in chunks into the text of its elements, each as soon as it is complete.
+   *
+   *  Every byte is looked at once to follow strings and brackets. An element that lies within one chunk is handed out
+   *  as a view into that chunk, only one that is split across chunks is copied, so the stream holds at most the one
+   *  element still being received however large the array is. The elements themselves are checked by whoever reads
+   *  them, the stream only checks the array around them and doesn't throw when that is malformed, so it also serves
+   *  decoding that must not throw.
+   */
+  class ArrayStream
+  {
+    public:
+      /// Receives the text of one element, valid until it returns.
+      using Element = std::function<void(std::string_view element)>;
+
+      /// Scans the next chunk of the text and hands each element it completes to element, in order.
+      /** An exception thrown by element leaves the stream unusable and passes on to the caller.
+       *  @return false if the text isn't an array, the stream then ignores the rest of it.
+       */
+      bool feed(std::string_view chunk, const Element& element);
+
+      /// True once the closing ']' has been fed, with nothing but whitespace after it.
+      bool complete() const {return state == after_array;}
+
+      /// Throws RequestFailed unless the stream is complete().
+      void finish() const;
+
+      /// The amount of elements handed out so far.
+      std::size_t elements() const {return handed_out;}
+
+      /// The bytes held back for an element split across chunks.
+      std::size_t pending() const {return partial.size();}
+
+    private:
+      enum State {before_array, first_element, next_element, in_element, after_array, malformed};
+
+      State state = before_array;
+      std::size_t depth = 0;          // Brackets opened within the current element and not closed yet.
+      bool in_string = false;
+      bool escaped = false;           // The chunk before ended on a backslash inside a string.
+      std::string partial;            // The start of an element that continues in the next chunk.
+      std::size_t handed_out = 0;
+  };
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef CBIRDPP_ASYNCENGINE_H
+#define CBIRDPP_ASYNCENGINE_H
+
+#include "ConnectionPool.h"
+#include "RateLimiter.h"
+#include "RequesterOptions.h"
+#include "ResponseBuffer.h"
+#include "Transport.h"
+
+#include <curl/curl.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace cbirdpp
+{
+
+  /** \class AsyncEngine
+   *  \brief Drives many transfers at once from a single event loop thread using the curl multi interface.
+   *
+   *  Transfers are queued with submit() from any thread and performed concurrently by one background thread, which is
+   *  started on the first submission. The completion callback of a transfer is invoked on that thread, so it should
+   *  hand off any heavy work instead of blocking the loop. cURLpp::Multi has no way to wait on or wake up the multi
+   *  handle, so the loop uses the libcurl multi API directly on the handles of pooled cURLpp::Easy objects.
+   *
+   *  With an HTTP/2 version selected in the RequesterOptions, concurrent transfers to the same host are multiplexed as
+   *  streams over one connection, up to max_concurrent_streams per connection.
+   *
+   *  With a RateLimiter, queued transfers only start once the limiter hands out a ticket, in submission order, and
+   *  each response status is reported back to it.
+   */
+  class AsyncEngine
+  {
+    public:
+      /// Invoked once per transfer with the response, or with the error that stopped it.
+      /** The response is the buffer of the pooled handle and is only valid until the callback returns.
+       */
+      using Completion = Transport::Completion;
+
+      /// Everything about a GET request besides its completion.
+      using Request = Transport::Request;
+
+      /** @param options the http version and connection limits used for every transfer.
+       *  @param share a curl share object every transfer's handle is attached to, it must outlive the engine.
+       *  @param limiter the rate limiter every transfer waits for, nullptr to start transfers right away.
+       */
+      explicit AsyncEngine(const RequesterOptions& options=RequesterOptions(), CURLSH* share=nullptr,
+                           std::shared_ptr<RateLimiter> limiter=nullptr);
+
+      AsyncEngine(const AsyncEngine&) = delete;
+      AsyncEngine& operator=(const AsyncEngine&) = delete;
+
+      /// Stops the event loop. Transfers that have not finished yet complete with a TransferAborted error, and so do
+      /// transfers submitted from then on, the loop is never started again.
+      ~AsyncEngine();
+
+      /// Queues a GET request for the url, the event loop picks it up immediately.
+      /** @param request_url the url of the request to be made.
+       *  @param headers extra HTTP headers in the format "Name: value".
+       *  @param done the callback that receives the response once the transfer finishes.
+       */
+      void submit(const std::string& request_url, const std::list<std::string>& headers, Completion done);
+
+      /// Queues a GET request, holding it back first if it has a delay.
+      /** A delayed request that is no longer wanted when it comes due is dropped and completes with RequestFailed.
+       *  @param request the url, headers, timeout and delay of the request.
+       *  @param done the callback that receives the response once the transfer finishes.
+       */
+      void submit(const Request& request, Completion done);
+
+      /// The amount of transfers that are queued or being performed.
+      std::size_t in_flight() const;
+
+    private:
+      using Clock = std::chrono::steady_clock;
+
+      struct Transfer
+      {
+        ConnectionPool::Lease handle;
+        Completion done;
+        RateLimiter::Ticket ticket;
+        std::function<bool()> wanted;
+      };
+
+      CURLM* multi;
+      ConnectionPool handles;
+      std::shared_ptr<RateLimiter> limiter;
+      std::thread loop;
+      std::atomic<bool> stopping{false};                  // Only set with queue_mutex held.
+      std::atomic<std::size_t> pending{0};
+
+      mutable std::mutex queue_mutex;
+      std::deque<std::unique_ptr<Transfer>> queued;        // Guarded by queue_mutex.
+      std::multimap<Clock::time_point, std::unique_ptr<Transfer>> delayed;  // Guarded by queue_mutex.
+      std::map<CURL*, std::unique_ptr<Transfer>> active;  // Only touched by the loop thread.
+
+      /// The event loop: adds queued transfers, performs them and dispatches completions until stopped.
+      void run();
+
+      /// Queues delayed transfers that came due and moves queued transfers onto the multi handle, as many as the
+      /// limiter admits.
+      /** @return how long the loop may sleep before a delayed transfer comes due or the limiter could admit the next
+       *  waiting transfer.
+       */
+      int start_queued();
+
+      /// Completes a transfer that never started with RequestFailed, or TransferAborted when shutting down.
+      void abandon(std::unique_ptr<Transfer> transfer);
+
+      /// Removes a finished transfer from the multi handle and invokes its completion.
+      void finish(CURL* easy, CURLcode result);
+  };
+
+}
+
+#endif
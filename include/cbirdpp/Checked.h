@@ -0,0 +1,69 @@
+#ifndef CBIRDPP_CHECKED_H
+#define CBIRDPP_CHECKED_H
+
+#include <cstddef>
+#include <vector>
+
+namespace cbirdpp
+{
+
+  /// Why a row, or the response around the rows, couldn't be decoded.
+  enum DecodeError {no_decode_error=0, malformed_response, malformed_row, invalid_row};
+
+  /*
+   * A row of a response that was left out of a Checked result: its position in the response's array and why. A
+   * malformed_row isn't JSON or holds a value of the wrong type, an invalid_row lacks a required field or holds a date
+   * that doesn't parse.
+   */
+  struct RowFailure
+  {
+    std::size_t row;
+    DecodeError error;
+  };
+
+  /** \class Checked
+   *  \brief The rows of a response that decoded, with an error code for every row that didn't, like std::expected.
+   *
+   *  Decoding a checked result throws nothing: a bad row is recorded in failures() and skipped, and the rows around it
+   *  are kept. A response that isn't an array at all, or breaks off, sets error() to malformed_response and keeps the
+   *  rows before the break. Errors of the request itself, such as an HTTP error status, are still thrown as usual.
+   */
+  template <typename Rows>
+  class Checked
+  {
+    public:
+      /// True if every row decoded, the result then holds the whole response.
+      bool has_value() const {return problem == no_decode_error && rejected.empty();}
+
+      explicit operator bool() const {return has_value();}
+
+      /// The rows that decoded, in the order of the response.
+      const Rows& value() const {return good;}
+
+      Rows& value() {return good;}
+
+      const Rows& operator*() const {return good;}
+
+      const Rows* operator->() const {return &good;}
+
+      /// malformed_response if the response wasn't an array of rows or broke off, no_decode_error otherwise.
+      DecodeError error() const {return problem;}
+
+      /// The rows that were left out, in the order of the response.
+      const std::vector<RowFailure>& failures() const {return rejected;}
+
+      /// Records that the row at position row was left out.
+      void reject(std::size_t row, DecodeError error) {rejected.push_back(RowFailure{row, error});}
+
+      /// Records that the response as a whole was malformed.
+      void fail() {problem = malformed_response;}
+
+    private:
+      Rows good;
+      std::vector<RowFailure> rejected;
+      DecodeError problem = no_decode_error;
+  };
+
+}
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef CBIRDPP_CHECKLIST_H
 #define CBIRDPP_CHECKLIST_H
 
+#include "ArenaRows.h"
+#include "Timestamp.h"
+
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -17,11 +21,7 @@ namespace cbirdpp
     std::string subID;
     std::string userDisplayName;
     unsigned int numSpecies;
-    std::string obsDt;
-    std::string obsTime;
-    std::string obsMonth;
-    unsigned int obsDay;
-    unsigned int obsYear;
+    Timestamp obsDt;      // The date and time of the checklist, read from the obsDt and obsTime fields.
     std::string name;
     double latitude;
     double longitude;
@@ -40,6 +40,58 @@ namespace cbirdpp
     Checklists() = default;
   };
 
+  /*
+   * A Checklist whose text is allocated from the arena of the ArenaChecklists holding it, see ArenaRows.
+   */
+  struct ArenaChecklist
+  {
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    ArenaChecklist(const allocator_type& arena={})
+      : locId(arena), subID(arena), userDisplayName(arena), name(arena), countryCode(arena), countryName(arena),
+        subnational1Name(arena), subnational1Code(arena), subnational2Name(arena), subnational2Code(arena),
+        hierarchicalName(arena) {}
+
+    ArenaChecklist(const ArenaChecklist& other, const allocator_type& arena) : ArenaChecklist(arena) {*this = other;}
+
+    ArenaChecklist(ArenaChecklist&& other, const allocator_type& arena) : ArenaChecklist(arena) {*this = std::move(other);}
+
+    ArenaChecklist(const ArenaChecklist&) = default;
+    ArenaChecklist(ArenaChecklist&&) = default;
+    ArenaChecklist& operator=(const ArenaChecklist&) = default;
+    ArenaChecklist& operator=(ArenaChecklist&&) = default;
+
+    std::pmr::string locId;
+    std::pmr::string subID;
+    std::pmr::string userDisplayName;
+    unsigned int numSpecies = 0;
+    Timestamp obsDt;
+    std::pmr::string name;
+    double latitude = 0;
+    double longitude = 0;
+    std::pmr::string countryCode;
+    std::pmr::string countryName;
+    std::pmr::string subnational1Name;
+    std::pmr::string subnational1Code;
+    std::pmr::string subnational2Name;
+    std::pmr::string subnational2Code;
+    bool isHotspot = false;
+    std::pmr::string hierarchicalName;
+
+    operator Checklist() const
+    {
+      return {std::string(locId), std::string(subID), std::string(userDisplayName), numSpecies, obsDt, std::string(name),
+              latitude, longitude, std::string(countryCode), std::string(countryName), std::string(subnational1Name),
+              std::string(subnational1Code), std::string(subnational2Name), std::string(subnational2Code), isHotspot,
+              std::string(hierarchicalName)};
+    }
+  };
+
+  struct ArenaChecklists : public ArenaRows<ArenaChecklist, Checklists>
+  {
+    ArenaChecklists() = default;
+  };
+
 }
 
 #endif
@@ -0,0 +1,93 @@
+#ifndef CBIRDPP_CONNECTIONPOOL_H
+#define CBIRDPP_CONNECTIONPOOL_H
+
+#include "RequesterOptions.h"
+#include "ResponseBuffer.h"
+
+#include <curl/curl.h>
+#include <curlpp/Easy.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cbirdpp
+{
+
+  /** \class ConnectionPool
+   *  \brief A thread safe pool of reusable cURLpp::Easy handles.
+   *
+   *  Every easy handle keeps its own connection cache, so handing the same handle out again lets libcurl reuse the
+   *  open TCP/TLS connection to ebird.org instead of performing a new handshake for every request. Each handle comes
+   *  with its own ResponseBuffer, so the memory for a response is reused along with the connection. The pool also
+   *  performs the global libcurl initialization exactly once per process.
+   */
+  class ConnectionPool
+  {
+    private:
+      struct Connection
+      {
+        cURLpp::Easy handle;
+        ResponseBuffer buffer;
+      };
+
+    public:
+      /** \class Lease
+       *  \brief Exclusive, scoped ownership of one pooled handle. The handle is returned to the pool on destruction.
+       */
+      class Lease
+      {
+        private:
+          ConnectionPool* pool;
+          std::unique_ptr<Connection> connection;
+
+        public:
+          Lease(ConnectionPool* owner, std::unique_ptr<Connection> leased);
+          Lease(Lease&& other) noexcept = default;
+          Lease& operator=(Lease&& other) noexcept = default;
+          Lease(const Lease&) = delete;
+          Lease& operator=(const Lease&) = delete;
+          ~Lease();
+
+          cURLpp::Easy& operator*() const { return connection->handle; }
+          cURLpp::Easy* operator->() const { return &connection->handle; }
+
+          /// The response buffer that belongs to the leased handle.
+          ResponseBuffer& buffer() const { return connection->buffer; }
+      };
+
+      /** Constructs an empty pool, handles are created lazily as they are needed.
+       *  @param max_idle the maximum amount of idle handles kept alive for reuse, extra handles are destroyed on release.
+       *  @param options the options every handle is created with, such as the HTTP version and compression.
+       *  @param share a curl share object every handle is attached to, it must outlive the pool. nullptr for none.
+       */
+      explicit ConnectionPool(std::size_t max_idle=8, const RequesterOptions& options=RequesterOptions(),
+                              CURLSH* share=nullptr);
+
+      ConnectionPool(const ConnectionPool&) = delete;
+      ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+      /// Takes an idle handle from the pool, or creates a new one if none are idle.
+      Lease acquire();
+
+      /// The amount of handles currently waiting in the pool.
+      std::size_t idle() const;
+
+    private:
+      mutable std::mutex pool_mutex;
+      std::vector<std::unique_ptr<Connection>> handles;
+      std::size_t max_idle;
+      RequesterOptions options;
+      CURLSH* share;
+
+      /// Returns a leased handle to the pool, or destroys it if the pool is already full.
+      void release(std::unique_ptr<Connection> connection);
+
+      /// Creates a handle with the options that stay the same for every request.
+      std::unique_ptr<Connection> make_handle() const;
+  };
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef CBIRDPP_CURLTRANSPORT_H
+#define CBIRDPP_CURLTRANSPORT_H
+
+#include "AsyncEngine.h"
+#include "ConnectionPool.h"
+#include "RateLimiter.h"
+#include "Transport.h"
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+
+namespace cbirdpp
+{
+
+  /** \class CurlTransport
+   *  \brief The Transport that talks to the network with libcurl.
+   *
+   *  Blocking requests are performed on a handle leased from a ConnectionPool, async requests are handed to an
+   *  AsyncEngine. Both pass through the same RateLimiter.
+   */
+  class CurlTransport: public Transport
+  {
+    public:
+      /** @param connections the pool blocking requests lease their handles from.
+       *  @param engine the engine performing async requests, it should use the same limiter.
+       *  @param limiter the rate limiter blocking requests wait for.
+       */
+      CurlTransport(std::shared_ptr<ConnectionPool> connections, std::shared_ptr<AsyncEngine> engine,
+                    std::shared_ptr<RateLimiter> limiter);
+
+      void perform(const Request& request, const std::function<void(ResponseBuffer&)>& received) override;
+
+      void submit(const Request& request, Completion done) override;
+
+      /// Opens connections for blocking requests on pooled handles and for async requests on the engine.
+      /** Every connection is opened with a HEAD request that carries no api key. This resolves the host and performs
+       *  the TCP and TLS handshakes, and the handles then keep the connections open for the first real requests.
+       */
+      std::future<void> prewarm(const std::string& url, unsigned int connections) override;
+
+    private:
+      std::shared_ptr<ConnectionPool> connections;
+      std::shared_ptr<AsyncEngine> engine;
+      std::shared_ptr<RateLimiter> limiter;
+  };
+
+}
+
+#endif
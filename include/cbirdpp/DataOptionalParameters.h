@@ -1,9 +1,11 @@
 #ifndef CBIRDPP_PARAMETERS_H
 #define CBIRDPP_PARAMETERS_H
 
+#include "Observation.h"
 #include "ParameterExceptions.h"
 
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -35,6 +37,8 @@ namespace cbirdpp
 
       std::optional<RankType> _rank;
 
+      unsigned long _fields = ObservationFields::all;
+
     public:
       /*
        * Default constructor. Every optional will be default initialized, and thus will be ignored until they are set.
@@ -97,6 +101,14 @@ namespace cbirdpp
        */
       void set_rank(const RankType& rank);
 
+      /*
+       * Set the fields observation requests decode, the others are skipped and left empty in the results. This is not
+       * sent to the API, which always returns every field, but skipping the long text fields of detailed responses
+       * saves most of the decoding work when only a few columns are used.
+       * @param fields a mask of ObservationFields, range: any non-empty combination, default: ObservationFields::all
+       */
+      void set_fields(const unsigned long fields);
+
       /*
        * Reset all parameters back to defaults.
        */
@@ -123,6 +135,8 @@ namespace cbirdpp
 
       const std::optional<RankType>& rank() const;
 
+      unsigned long fields() const;
+
       /*
        * Returns a string formatted for the API request. That is the form NAME=VALUE
        */
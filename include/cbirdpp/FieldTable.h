@@ -0,0 +1,301 @@
+#ifndef CBIRDPP_FIELDTABLE_H
+#define CBIRDPP_FIELDTABLE_H
+
+#include "JsonReader.h"
+#include "Timestamp.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace cbirdpp
+{
+
+  /// The type of a field's value, which selects how it is read.
+  enum FieldKind {text_field=0, count_field, real_field, flag_field, time_field, object_field};
+
+  /*
+   * Describes one field of a result: the key it is read from, the member it is read into, and what the member is set
+   * to when the key is missing. Text is the type of the result's text members. Only the member pointer matching kind
+   * is set, a time_field is parsed from its string by parse_time and an object_field is read by nested instead, into
+   * members of the same result.
+   */
+  template <typename Row, typename Text>
+  struct FieldDescriptor
+  {
+    std::string_view name;
+    FieldKind kind = text_field;
+    Text Row::* text = nullptr;
+    unsigned int Row::* count = nullptr;
+    double Row::* real = nullptr;
+    bool Row::* flag = nullptr;
+    Timestamp Row::* time = nullptr;
+    bool (*parse_time)(std::string_view, Timestamp&) = nullptr;
+    bool (*nested)(JsonReader&, Row&) = nullptr;
+    bool required = true;
+    std::string_view fallback_text;      // The value of a missing text field that isn't required.
+    unsigned int fallback_count = 0;     // The value of a missing count field that isn't required.
+  };
+
+  /*
+   * Builds the FieldDescriptors of a result, members of a base class of Row can be used too.
+   */
+  template <typename Row, typename Text=std::string>
+  struct Fields
+  {
+    using Descriptor = FieldDescriptor<Row, Text>;
+
+    /// A required field.
+    template <typename Base>
+    static constexpr Descriptor field(std::string_view name, Text Base::* member)
+    {
+      Descriptor descriptor;
+      descriptor.name = name;
+      descriptor.kind = text_field;
+      descriptor.text = member;
+      return descriptor;
+    }
+
+    template <typename Base>
+    static constexpr Descriptor field(std::string_view name, unsigned int Base::* member)
+    {
+      Descriptor descriptor;
+      descriptor.name = name;
+      descriptor.kind = count_field;
+      descriptor.count = member;
+      return descriptor;
+    }
+
+    template <typename Base>
+    static constexpr Descriptor field(std::string_view name, double Base::* member)
+    {
+      Descriptor descriptor;
+      descriptor.name = name;
+      descriptor.kind = real_field;
+      descriptor.real = member;
+      return descriptor;
+    }
+
+    template <typename Base>
+    static constexpr Descriptor field(std::string_view name, bool Base::* member)
+    {
+      Descriptor descriptor;
+      descriptor.name = name;
+      descriptor.kind = flag_field;
+      descriptor.flag = member;
+      return descriptor;
+    }
+
+    /// A required time.
+    /** @param parse reads the field's string into the member. It may leave part of the member as it was, so two
+     *  fields can fill in the date and the time of day of the same member.
+     */
+    template <typename Base>
+    static constexpr Descriptor field(std::string_view name, Timestamp Base::* member,
+                                      bool (*parse)(std::string_view, Timestamp&)=Timestamp::parse)
+    {
+      Descriptor descriptor;
+      descriptor.name = name;
+      descriptor.kind = time_field;
+      descriptor.time = member;
+      descriptor.parse_time = parse;
+      return descriptor;
+    }
+
+    /// A field that is set to fallback when it is missing.
+    template <typename Base>
+    static constexpr Descriptor optional(std::string_view name, Text Base::* member, std::string_view fallback)
+    {
+      Descriptor descriptor = field(name, member);
+      descriptor.required = false;
+      descriptor.fallback_text = fallback;
+      return descriptor;
+    }
+
+    template <typename Base>
+    static constexpr Descriptor optional(std::string_view name, unsigned int Base::* member, unsigned int fallback)
+    {
+      Descriptor descriptor = field(name, member);
+      descriptor.required = false;
+      descriptor.fallback_count = fallback;
+      return descriptor;
+    }
+
+    /// A required object whose members are read into the result by read, which returns false if they didn't read.
+    static constexpr Descriptor object(std::string_view name, bool (*read)(JsonReader&, Row&))
+    {
+      Descriptor descriptor;
+      descriptor.name = name;
+      descriptor.kind = object_field;
+      descriptor.nested = read;
+      return descriptor;
+    }
+  };
+
+  /// FNV-1a of key, started from seed.
+  constexpr std::uint32_t field_hash(std::string_view key, std::uint32_t seed)
+  {
+    std::uint32_t hash = 2166136261u ^ seed;
+    for(std::size_t i = 0; i < key.size(); ++i) {
+      hash = (hash ^ static_cast<unsigned char>(key[i])) * 16777619u;
+    }
+    return hash;
+  }
+
+  /** \class FieldTable
+   *  \brief The N fields of a result, with a perfect hash from their names to their positions.
+   *
+   *  The table is built at compile time: the constructor tries seeds of field_hash until every name lands in a slot
+   *  of its own, so finding a key costs one hash and one comparison however many fields the result has. A table with
+   *  two fields of the same name does not compile. Positions are the bits of the masks read_fields() takes.
+   */
+  template <typename Row, typename Text, std::size_t N>
+  class FieldTable
+  {
+    public:
+      static_assert(N < 64, "field positions must fit in an unsigned long mask");
+
+      /// Slots in the hash table, a power of two at least four times the fields so a seed is found quickly.
+      static constexpr std::size_t SLOTS = N <= 2 ? 8 : N <= 4 ? 16 : N <= 8 ? 32 : N <= 16 ? 64 : 128;
+
+      constexpr explicit FieldTable(const std::array<FieldDescriptor<Row, Text>, N>& descriptors) : fields(descriptors)
+      {
+        for(std::size_t i = 0; i < N; ++i) {
+          if(descriptors[i].required) {
+            required_fields |= 1ul << i;
+          } else {
+            fallback_fields |= 1ul << i;
+          }
+        }
+        while(!place()) {
+          if(++seed == 1u << 16) {throw std::logic_error("no perfect hash for the field names, is one repeated?");}
+        }
+      }
+
+      /// The position of the field named key, N if there is none.
+      constexpr std::size_t find(std::string_view key) const
+      {
+        std::size_t position = slots[field_hash(key, seed) & (SLOTS - 1)];
+        return position < N && fields[position].name == key ? position : N;
+      }
+
+      constexpr const FieldDescriptor<Row, Text>& operator[](std::size_t position) const {return fields[position];}
+
+      constexpr std::size_t size() const {return N;}
+
+      /// The positions of the fields that must be present.
+      constexpr unsigned long required() const {return required_fields;}
+
+      /// The positions of the fields that are set to a fallback value when they are missing.
+      constexpr unsigned long fallbacks() const {return fallback_fields;}
+
+    private:
+      // Fills the slots for the current seed, false if two names land in the same slot.
+      constexpr bool place()
+      {
+        for(std::size_t slot = 0; slot < SLOTS; ++slot) {slots[slot] = N;}
+        for(std::size_t i = 0; i < N; ++i) {
+          std::size_t slot = field_hash(fields[i].name, seed) & (SLOTS - 1);
+          if(slots[slot] != N) {return false;}
+          slots[slot] = static_cast<std::uint8_t>(i);
+        }
+        return true;
+      }
+
+      std::array<FieldDescriptor<Row, Text>, N> fields;
+      std::array<std::uint8_t, SLOTS> slots{};
+      std::uint32_t seed = 0;
+      unsigned long required_fields = 0;
+      unsigned long fallback_fields = 0;
+  };
+
+  /// A FieldTable of the given fields, in the given order.
+  template <typename Row, typename Text, typename... Rest>
+  constexpr FieldTable<Row, Text, 1 + sizeof...(Rest)> make_field_table(const FieldDescriptor<Row, Text>& first, const Rest&... rest)
+  {
+    return FieldTable<Row, Text, 1 + sizeof...(Rest)>(std::array<FieldDescriptor<Row, Text>, 1 + sizeof...(Rest)>{{first, rest...}});
+  }
+
+  /*
+   * Makes the Text of a fallback value from its characters.
+   */
+  template <typename Text>
+  struct TextFrom
+  {
+    Text operator()(std::string_view text) const {return Text(text);}
+  };
+
+  /// Reads a JSON object into target, the one decoder of every table driven result.
+  /** Each key is looked up once in the table. Fields whose position isn't in wanted are skipped without being
+   *  decoded and keep the value target had, wanted fields that are missing are set to their fallback.
+   *  @param source a reader positioned on the object.
+   *  @param target the result to fill in.
+   *  @param table the fields of the result.
+   *  @param wanted a mask of the positions of the fields to read.
+   *  @param read_text a callable reading a string value into a Text member.
+   *  @param make_text a callable making the Text of a fallback value from a string_view.
+   *  @return false if a wanted field that is required was missing, or a time or nested object that didn't read. A
+   *  source that records errors may have failed as well, which the caller checks.
+   */
+  template <typename Row, typename Text, std::size_t N, typename TextReader, typename MakeText=TextFrom<Text>>
+  bool read_fields(JsonReader& source, Row& target, const FieldTable<Row, Text, N>& table, unsigned long wanted,
+                   TextReader read_text, MakeText make_text=MakeText())
+  {
+    for(unsigned long fallbacks = table.fallbacks() & wanted; fallbacks != 0; fallbacks &= fallbacks - 1) {
+      const FieldDescriptor<Row, Text>& field = table[__builtin_ctzl(fallbacks)];
+      if(field.kind == text_field) {
+        target.*field.text = make_text(field.fallback_text);
+      } else {
+        target.*field.count = field.fallback_count;
+      }
+    }
+    unsigned long seen = 0;
+    std::string_view key;
+    source.begin_object();
+    while(source.next_key(key)) {
+      std::size_t position = table.find(key);
+      if(position == N || (wanted & (1ul << position)) == 0) {
+        source.skip_value();
+        continue;
+      }
+      const FieldDescriptor<Row, Text>& field = table[position];
+      switch(field.kind) {
+        case text_field: read_text(target.*field.text); break;
+        case count_field: target.*field.count = static_cast<unsigned int>(source.read_unsigned()); break;
+        case real_field: target.*field.real = source.read_double(); break;
+        case flag_field: target.*field.flag = source.read_bool(); break;
+        case time_field:
+          // Times with escapes, which none from the API have, are decoded into the buffer of the thread.
+          if(!field.parse_time(source.read_string_view(decode_buffer()), target.*field.time)) {return false;}
+          break;
+        case object_field:
+          if(!field.nested(source, target)) {return false;}
+          break;
+      }
+      seen |= 1ul << position;
+    }
+    return (wanted & table.required() & ~seen) == 0;
+  }
+
+  /// Reads every field of a result with owned std::string text.
+  template <typename Row, std::size_t N>
+  bool read_fields(JsonReader& source, Row& target, const FieldTable<Row, std::string, N>& table)
+  {
+    return read_fields(source, target, table, ~0ul, [&source](std::string& field) { source.read_string(field); });
+  }
+
+  /// Reads the wanted fields of a result with std::pmr::string text, into the memory the target's text already uses.
+  template <typename Row, std::size_t N>
+  bool read_fields(JsonReader& source, Row& target, const FieldTable<Row, std::pmr::string, N>& table, unsigned long wanted=~0ul)
+  {
+    auto read_text = [&source](std::pmr::string& field) { field.assign(source.read_string_view(decode_buffer())); };
+    return read_fields(source, target, table, wanted, read_text);
+  }
+
+}
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef CBIRDPP_JSONREADER_H
+#define CBIRDPP_JSONREADER_H
+
+#include "ArrayStream.h"
+#include "Checked.h"
+#include "StructuralIndex.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cbirdpp
+{
+
+  /** \class JsonReader
+   *  \brief Reads JSON text token by token, so results can be filled in without building a document first.
+   *
+   *  The caller walks the text in the order it expects it: begin_array() and next_element() step through an array,
+   *  begin_object() and next_key() through an object, the read_ methods consume one value and skip_value() passes
+   *  over a value that isn't needed, however deeply nested. Text that isn't JSON, or a value of another type than the
+   *  one asked for, throws RequestFailed. A reader constructed with record_errors marks itself as failed instead, so
+   *  rows can be checked one by one without unwinding.
+   *
+   *  Text of at least INDEX_THRESHOLD bytes is given a StructuralIndex first. Strings are then read by jumping to
+   *  their closing quote, and skipped containers by jumping to their closing bracket, instead of stepping through
+   *  every byte. Skipped containers are then only checked for balanced brackets. The index is built in the memory of
+   *  the last one of the thread, see StructuralIndex::recycled().
+   */
+  class JsonReader
+  {
+    public:
+      /// The size from which text is indexed by default.
+      static constexpr std::size_t INDEX_THRESHOLD = 64 * 1024;
+
+      /// What becomes of text that isn't JSON or holds a value of another type than the one asked for.
+      enum ErrorHandling {throw_errors, record_errors};
+
+      /** @param text the JSON text, it has to outlive the reader.
+       *  @param index_threshold the size from which the text is indexed, 0 always indexes it.
+       *  @param errors throw_errors throws RequestFailed. record_errors sets failed(), and the text is then never
+       *  indexed, as indexing throws for unterminated strings.
+       */
+      explicit JsonReader(std::string_view text, std::size_t index_threshold=INDEX_THRESHOLD,
+                          ErrorHandling errors=throw_errors);
+
+      JsonReader(const JsonReader&) = delete;
+      JsonReader& operator=(const JsonReader&) = delete;
+
+      /// Leaves the memory of the index to the next reader of the thread.
+      ~JsonReader();
+
+      /// True once a reader constructed with record_errors has met malformed or unexpected text.
+      /** The reader is then at the end of its text: the read_ methods return empty values, next_element() and
+       *  next_key() return false, and nothing throws.
+       */
+      bool failed() const {return error;}
+
+      /// Consumes the '[' that opens an array.
+      void begin_array();
+
+      /// Moves to the next element of the array, false once its closing ']' has been consumed.
+      /** After begin_run(), false once the end of the text is reached instead.
+       */
+      bool next_element();
+
+      /// Consumes the '[' or ',' a run of elements from split_array() starts with.
+      void begin_run();
+
+      /// Splits the text of an array into runs of whole elements of about the same size, so they can be read apart.
+      /** Each run starts with the '[' or ',' in front of its first element and ends right before the separator after
+       *  its last one, a reader over it is started with begin_run(). Text that isn't an array gives no runs, so the
+       *  caller reads it as a whole and gets the error there.
+       *  @param text the JSON text of the array.
+       *  @param parts the most runs to split it into.
+       *  @return the runs, in order.
+       */
+      static std::vector<std::string_view> split_array(std::string_view text, std::size_t parts);
+
+      /// Consumes the '{' that opens an object.
+      void begin_object();
+
+      /// Moves to the next member of the object and sets key to its name, false once its closing '}' has been consumed.
+      /** The key stays valid until the next call on the reader.
+       */
+      bool next_key(std::string_view& key);
+
+      /// Reads a string value into target, with its escape sequences decoded.
+      void read_string(std::string& target);
+
+      /// Reads a string value without copying it.
+      /** @param decoded where the value is decoded to if it has escape sequences.
+       *  @return a view into the text, or into decoded if the value had escapes.
+       */
+      std::string_view read_string_view(std::string& decoded);
+
+      /// Reads a number that has to be a non-negative integer.
+      std::uint64_t read_unsigned();
+
+      /// Reads a number.
+      double read_double();
+
+      /// Reads true or false.
+      bool read_bool();
+
+      /// Consumes a null value and returns true, or returns false without consuming anything if the value isn't null.
+      bool read_null();
+
+      /// Consumes the next value, whatever its type.
+      void skip_value();
+
+      /// Throws RequestFailed unless only whitespace is left.
+      void finish();
+
+    private:
+      /// Skips whitespace and returns the next character, or '\0' at the end of the text.
+      char peek();
+
+      /// Consumes the next character, which has to be expected.
+      void expect(char expected);
+
+      /// Consumes the character at the current position.
+      void consume();
+
+      /// The text of the number at the current position, consumed.
+      std::string_view number_token();
+
+      /// Reads the string at the current position, into view if it has no escapes and into decoded otherwise.
+      void scan_string(std::string_view& view, std::string& decoded);
+
+      /// Throws the error for malformed or unexpected text, or records it and moves to the end of the text.
+      void malformed();
+
+      /// Moves the cursor to the first indexed position at or after position, and returns it.
+      std::size_t indexed_from(std::size_t from);
+
+      std::string_view text;
+      std::size_t position = 0;
+      bool indexed = false;
+      StructuralIndex index;
+      std::size_t cursor = 0;      // The first index entry that may still be ahead of position.
+      bool first = false;          // The innermost array or object hasn't had an element yet.
+      bool run = false;            // The text is a run of elements from split_array().
+      std::string key_buffer;      // Keys that had escapes are decoded here.
+      bool throws = true;          // Constructed with throw_errors.
+      bool error = false;          // Malformed text was met without throwing.
+  };
+
+  /// The string that values with escape sequences are decoded into on the calling thread, for readers that copy or
+  /// intern them right away.
+  /** It keeps its memory from one response to the next. A view decoded into it is only valid until the next value is
+   *  decoded into it on the same thread.
+   */
+  std::string& decode_buffer();
+
+  /// Reads the rows of a JSON array into a Container derived from a vector, on several threads for large text.
+  /** Text of at least parallel_threshold bytes is split with JsonReader::split_array() into a run per thread of
+   *  workers. The runs are read by the calling thread and the threads of the pool, then their rows are moved onto the
+   *  end of the result in order. Splitting has already indexed the text, so the runs are read without indexing them
+   *  again. An error in any run is rethrown once every run is done.
+   *  @param text the JSON text of the array.
+   *  @param read_row a callable taking a JsonReader positioned on a row and the row to fill in, it is called from
+   *  several threads at once.
+   *  @param parallel_threshold the size from which the text is split.
+   *  @param workers the pool to read on, null to read on the calling thread only.
+   *  @return the rows, in the order of the array.
+   */
+  template <typename Container, typename ReadRow>
+  Container read_rows(std::string_view text, ReadRow read_row,
+                      std::size_t parallel_threshold=std::numeric_limits<std::size_t>::max(), WorkerPool* workers=nullptr)
+  {
+    using Row = typename Container::value_type;
+    std::vector<std::string_view> runs;
+    if(workers != nullptr && workers->size() > 1 && text.size() >= parallel_threshold) {
+      runs = JsonReader::split_array(text, workers->size());
+    }
+    Container result;
+    if(runs.size() < 2) {
+      JsonReader source(text);
+      source.begin_array();
+      while(source.next_element()) {read_row(source, result.emplace_back());}
+      source.finish();
+      return result;
+    }
+
+    std::vector<std::vector<Row>> later(runs.size() - 1);
+    workers->run(runs.size(), [&runs, &later, &result, &read_row](std::size_t i) {
+      JsonReader source(runs[i], std::numeric_limits<std::size_t>::max());
+      source.begin_run();
+      if(i == 0) {
+        while(source.next_element()) {read_row(source, result.emplace_back());}
+      } else {
+        while(source.next_element()) {read_row(source, later[i - 1].emplace_back());}
+      }
+      source.finish();
+    });
+    std::size_t total = result.size();
+    for(const std::vector<Row>& rows : later) {total += rows.size();}
+    result.reserve(total);
+    for(std::vector<Row>& rows : later) {
+      result.insert(result.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+    }
+    return result;
+  }
+
+  /// Reads the rows of a JSON array into a Checked result without throwing, leaving out the rows that don't read.
+  /** The array is split into rows with an ArrayStream and every row is read with a JsonReader of its own that records
+   *  its errors, so a bad row is recorded in the failures of the result and the rows after it are still read.
+   *  @param text the JSON text of the array.
+   *  @param read_row a callable taking a JsonReader positioned on a row and the row to fill in, returning false if a
+   *  required field was missing. It must not throw for text that isn't JSON, which the reader takes care of.
+   *  @return the rows that were read, the position and error of those that weren't, and malformed_response if the
+   *  text wasn't an array of rows or broke off.
+   */
+  template <typename Rows, typename ReadRow>
+  Checked<Rows> read_checked_rows(std::string_view text, ReadRow read_row)
+  {
+    Checked<Rows> result;
+    std::size_t row = 0;
+    ArrayStream split;
+    bool whole = split.feed(text, [&result, &row, &read_row](std::string_view element) {
+      JsonReader source(element, JsonReader::INDEX_THRESHOLD, JsonReader::record_errors);
+      Rows& rows = result.value();
+      bool complete = read_row(source, rows.emplace_back());
+      // A row that stopped at a missing field or bad date is left unfinished, so it is only checked for trailing text
+      // once it has been read.
+      DecodeError error = source.failed() ? malformed_row : !complete ? invalid_row : no_decode_error;
+      if(error == no_decode_error) {
+        source.finish();
+        if(source.failed()) {error = malformed_row;}
+      }
+      if(error != no_decode_error) {
+        rows.pop_back();
+        result.reject(row, error);
+      }
+      ++row;
+    });
+    if(!whole || !split.complete()) {result.fail();}
+    return result;
+  }
+
+}
+
+#endif
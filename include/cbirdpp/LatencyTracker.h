@@ -0,0 +1,51 @@
+#ifndef CBIRDPP_LATENCYTRACKER_H
+#define CBIRDPP_LATENCYTRACKER_H
+
+#include "RequesterOptions.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace cbirdpp
+{
+
+  /** \class LatencyTracker
+   *  \brief Keeps the latencies of the most recent successful requests to each endpoint, thread safe.
+   *
+   *  Hedged requests use the observed 95th percentile of an endpoint as the point at which a duplicate is sent.
+   */
+  class LatencyTracker
+  {
+    public:
+      /// Records the latency of a successful request.
+      void record(const Endpoint& endpoint, std::chrono::milliseconds latency);
+
+      /// The latency below which the given share of the recent requests to the endpoint completed.
+      /** @param share the percentile as a share in the range [0-1], such as 0.95.
+       *  @return the percentile, or zero while fewer than MIN_SAMPLES requests have been recorded.
+       */
+      std::chrono::milliseconds percentile(const Endpoint& endpoint, double share) const;
+
+      /// Samples needed before percentile() reports anything.
+      static const std::size_t MIN_SAMPLES = 20;
+
+      /// The amount of recent samples kept per endpoint.
+      static const std::size_t WINDOW = 200;
+
+    private:
+      struct Window
+      {
+        std::vector<std::chrono::milliseconds> samples;
+        std::size_t next = 0;
+      };
+
+      mutable std::mutex tracker_mutex;
+      std::array<Window, ENDPOINT_COUNT> windows;
+  };
+
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef CBIRDPP_MEMORYTRANSPORT_H
+#define CBIRDPP_MEMORYTRANSPORT_H
+
+#include "Transport.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cbirdpp
+{
+
+  /** \class MemoryTransport
+   *  \brief A Transport that answers every request from canned responses in memory, thread safe.
+   *
+   *  Responses are registered per url prefix, for example the base url of the Requester's options followed by
+   *  "product/top100/" with the contents of misc/top100_example.json. A request gets the response of the longest
+   *  registered prefix of its url, or a 404 if there is none. Every response carries an ETag derived from its body and
+   *  a request with a matching If-None-Match gets a 304, like from ebird.org. Bodies are handed over in chunks of
+   *  CHUNK bytes, the most curl passes to its write callback at once. Requests complete immediately on the calling
+   *  thread, so benchmarks of everything above the network layer are repeatable and tests run without an api key.
+   */
+  class MemoryTransport: public Transport
+  {
+    public:
+      /// The size of the chunks a body is handed over in.
+      static constexpr std::size_t CHUNK = 16 * 1024;
+
+      /// Answers requests whose url starts with url_prefix with the given body.
+      /** @param url_prefix the start of the urls to answer, registering the same prefix again replaces its response.
+       *  @param body the response body.
+       *  @param status the HTTP status code of the response.
+       *  @param content_type the Content-Type of the response.
+       */
+      void serve(const std::string& url_prefix, std::string body, long status=200,
+                 const std::string& content_type="application/json;charset=utf-8");
+
+      /// Answers requests whose url starts with url_prefix with the contents of a file.
+      /** Throws std::runtime_error if the file can't be read.
+       */
+      void serve_file(const std::string& url_prefix, const std::string& path);
+
+      /// The amount of requests answered so far.
+      std::size_t requests() const;
+
+      /// The amount of body bytes sent so far, which a 304 saves.
+      std::size_t bytes_sent() const;
+
+      void perform(const Request& request, const std::function<void(ResponseBuffer&)>& received) override;
+
+      void submit(const Request& request, Completion done) override;
+
+    private:
+      struct Route
+      {
+        std::string prefix;
+        long status;
+        std::string content_type;
+        std::shared_ptr<const std::string> body;       // Shared, so a response is sent without holding the lock.
+        std::string etag;
+      };
+
+      mutable std::mutex routes_mutex;
+      std::vector<Route> routes;                        // Guarded by routes_mutex.
+      std::atomic<std::size_t> answered{0};
+      std::atomic<std::size_t> sent{0};
+
+      /// Fills response the way curl would, from the route matching the url of the request.
+      void respond(const Request& request, ResponseBuffer& response);
+  };
+
+}
+
+#endif
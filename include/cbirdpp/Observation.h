@@ -1,13 +1,41 @@
 #ifndef CBIRDPP_OBSERVATION_H
 #define CBIRDPP_OBSERVATION_H
 
+#include "ArenaRows.h"
+#include "StringPool.h"
+#include "Timestamp.h"
+
+#include <deque>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
 namespace cbirdpp
 {
 
+  /*
+   * One bit for each field of a DetailedObservation, the first twelve are the fields of an Observation. A mask of them
+   * picks the fields an observation request decodes, see DataOptionalParameters::set_fields().
+   */
+  struct ObservationFields
+  {
+    enum Field : unsigned long
+    {
+      speciesCode = 1ul << 0, comName = 1ul << 1, sciName = 1ul << 2, locId = 1ul << 3, locName = 1ul << 4,
+      obsDt = 1ul << 5, howMany = 1ul << 6, lat = 1ul << 7, lng = 1ul << 8, obsValid = 1ul << 9,
+      obsReviewed = 1ul << 10, locationPrivate = 1ul << 11,
+      checklistId = 1ul << 12, countryCode = 1ul << 13, countryName = 1ul << 14, firstName = 1ul << 15,
+      hasComments = 1ul << 16, hasRichMedia = 1ul << 17, lastName = 1ul << 18, locID = 1ul << 19, obsId = 1ul << 20,
+      presenceNoted = 1ul << 21, subId = 1ul << 22, subnational1Code = 1ul << 23, subnational1Name = 1ul << 24,
+      subnational2Code = 1ul << 25, subnational2Name = 1ul << 26, userDisplayName = 1ul << 27,
+      simple = (1ul << 12) - 1,
+      all = (1ul << 28) - 1
+    };
+  };
+
   /*
    * A simple container class for holding the information returned by the eBird API when making observation requests.
    * The getter method names directly correlate with the names given to the variables by the JSON response.
@@ -19,7 +47,7 @@ namespace cbirdpp
     std::string sciName;
     std::string locId;
     std::string locName;
-    std::string obsDt;
+    Timestamp obsDt;
     unsigned int howMany;
     double lat;
     double lng;
@@ -66,9 +94,276 @@ namespace cbirdpp
   };
 
   /*
-   * An extension of the Observation class to include field for requests that have the detail argument set
+   * An Observation whose text fields point into the response it was read from instead of owning copies. A view is
+   * only valid as long as the ObservationViews holding it, or a copy of them, is alive.
+   */
+  struct ObservationView
+  {
+    std::string_view speciesCode;
+    std::string_view comName;
+    std::string_view sciName;
+    std::string_view locId;
+    std::string_view locName;
+    Timestamp obsDt;
+    unsigned int howMany;
+    double lat;
+    double lng;
+    bool obsValid;
+    bool obsReviewed;
+    bool locationPrivate;
+
+    operator Observation() const
+    {
+      return {std::string(speciesCode), std::string(comName), std::string(sciName), std::string(locId),
+              std::string(locName), obsDt, howMany, lat, lng, obsValid, obsReviewed, locationPrivate};
+    }
+  };
+
+  /*
+   * The rows of an observation response as views, along with the response body they point into. Copies share the
+   * body, so rows can be passed around without copying any text.
+   */
+  struct ObservationViews : public std::vector<ObservationView>
+  {
+    /// The text the views point into: the response body, and decoded copies of the strings that had escapes.
+    struct Text
+    {
+      std::string body;
+      std::deque<std::string> unescaped;
+    };
+
+    ObservationViews() = default;
+
+    /// Owned copies of every row.
+    Observations to_observations() const
+    {
+      Observations owned;
+      owned.reserve(size());
+      for(const ObservationView& view : *this) {owned.push_back(view);}
+      return owned;
+    }
+
+    std::shared_ptr<const Text> text;
+  };
+
+  /*
+   * An Observation whose text fields are handles to strings stored once in a StringPool. Each handle is the size of a
+   * pointer, and handles of the same text from the same pool compare equal as pointers. A row is only valid as long as
+   * the InternedObservations holding it, or another result sharing its pool, is alive.
+   */
+  struct InternedObservation
+  {
+    InternedString speciesCode;
+    InternedString comName;
+    InternedString sciName;
+    InternedString locId;
+    InternedString locName;
+    Timestamp obsDt;
+    unsigned int howMany;
+    double lat;
+    double lng;
+    bool obsValid;
+    bool obsReviewed;
+    bool locationPrivate;
+
+    operator Observation() const
+    {
+      return {speciesCode, comName, sciName, locId, locName, obsDt, howMany, lat, lng, obsValid, obsReviewed,
+              locationPrivate};
+    }
+  };
+
+  /*
+   * A DetailedObservation whose text fields are handles to strings stored once in a StringPool.
+   */
+  struct InternedDetailedObservation : public InternedObservation
+  {
+    InternedString checklistId;
+    InternedString countryCode;
+    InternedString countryName;
+    InternedString firstName;
+    bool hasComments;
+    bool hasRichMedia;
+    InternedString lastName;
+    InternedString locID;
+    InternedString obsId;
+    bool presenceNoted;
+    InternedString subId;
+    InternedString subnational1Code;
+    InternedString subnational1Name;
+    InternedString subnational2Code;
+    InternedString subnational2Name;
+    InternedString userDisplayName;
+
+    operator DetailedObservation() const
+    {
+      DetailedObservation owned;
+      static_cast<Observation&>(owned) = static_cast<const InternedObservation&>(*this);
+      owned.checklistId = checklistId;
+      owned.countryCode = countryCode;
+      owned.countryName = countryName;
+      owned.firstName = firstName;
+      owned.hasComments = hasComments;
+      owned.hasRichMedia = hasRichMedia;
+      owned.lastName = lastName;
+      owned.locID = locID;
+      owned.obsId = obsId;
+      owned.presenceNoted = presenceNoted;
+      owned.subId = subId;
+      owned.subnational1Code = subnational1Code;
+      owned.subnational1Name = subnational1Name;
+      owned.subnational2Code = subnational2Code;
+      owned.subnational2Name = subnational2Name;
+      owned.userDisplayName = userDisplayName;
+      return owned;
+    }
+  };
+
+  /*
+   * The rows of an observation response with their text interned, along with the pool holding the text. Results
+   * interned by the same Requester usually share a pool, so each distinct string is kept once for all of them.
    */
-  
+  template <typename Row, typename Owned>
+  struct InternedRows : public std::vector<Row>
+  {
+    InternedRows() = default;
+
+    /// Owned copies of every row.
+    Owned to_observations() const
+    {
+      Owned owned;
+      owned.reserve(this->size());
+      for(const Row& row : *this) {owned.push_back(row);}
+      return owned;
+    }
+
+    std::shared_ptr<const StringPool> pool;
+  };
+
+  struct InternedObservations : public InternedRows<InternedObservation, Observations>
+  {
+    InternedObservations() = default;
+  };
+
+  struct InternedDetailedObservations : public InternedRows<InternedDetailedObservation, DetailedObservations>
+  {
+    InternedDetailedObservations() = default;
+  };
+
+  /*
+   * An Observation whose text is allocated from the arena of the ArenaObservations holding it, see ArenaRows. The
+   * allocator taking constructors let the arena's vector hand its allocator on to the text of every row.
+   */
+  struct ArenaObservation
+  {
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    ArenaObservation(const allocator_type& arena={})
+      : speciesCode(arena), comName(arena), sciName(arena), locId(arena), locName(arena) {}
+
+    ArenaObservation(const ArenaObservation& other, const allocator_type& arena) : ArenaObservation(arena) {*this = other;}
+
+    ArenaObservation(ArenaObservation&& other, const allocator_type& arena) : ArenaObservation(arena) {*this = std::move(other);}
+
+    ArenaObservation(const ArenaObservation&) = default;
+    ArenaObservation(ArenaObservation&&) = default;
+    ArenaObservation& operator=(const ArenaObservation&) = default;
+    ArenaObservation& operator=(ArenaObservation&&) = default;
+
+    std::pmr::string speciesCode;
+    std::pmr::string comName;
+    std::pmr::string sciName;
+    std::pmr::string locId;
+    std::pmr::string locName;
+    Timestamp obsDt;
+    unsigned int howMany = 0;
+    double lat = 0;
+    double lng = 0;
+    bool obsValid = false;
+    bool obsReviewed = false;
+    bool locationPrivate = false;
+
+    operator Observation() const
+    {
+      return {std::string(speciesCode), std::string(comName), std::string(sciName), std::string(locId),
+              std::string(locName), obsDt, howMany, lat, lng, obsValid, obsReviewed, locationPrivate};
+    }
+  };
+
+  /*
+   * A DetailedObservation whose text is allocated from the arena of the ArenaDetailedObservations holding it.
+   */
+  struct ArenaDetailedObservation : public ArenaObservation
+  {
+    ArenaDetailedObservation(const allocator_type& arena={})
+      : ArenaObservation(arena), checklistId(arena), countryCode(arena), countryName(arena), firstName(arena),
+        lastName(arena), locID(arena), obsId(arena), subId(arena), subnational1Code(arena), subnational1Name(arena),
+        subnational2Code(arena), subnational2Name(arena), userDisplayName(arena) {}
+
+    ArenaDetailedObservation(const ArenaDetailedObservation& other, const allocator_type& arena)
+      : ArenaDetailedObservation(arena) {*this = other;}
+
+    ArenaDetailedObservation(ArenaDetailedObservation&& other, const allocator_type& arena)
+      : ArenaDetailedObservation(arena) {*this = std::move(other);}
+
+    ArenaDetailedObservation(const ArenaDetailedObservation&) = default;
+    ArenaDetailedObservation(ArenaDetailedObservation&&) = default;
+    ArenaDetailedObservation& operator=(const ArenaDetailedObservation&) = default;
+    ArenaDetailedObservation& operator=(ArenaDetailedObservation&&) = default;
+
+    std::pmr::string checklistId;
+    std::pmr::string countryCode;
+    std::pmr::string countryName;
+    std::pmr::string firstName;
+    bool hasComments = false;
+    bool hasRichMedia = false;
+    std::pmr::string lastName;
+    std::pmr::string locID;
+    std::pmr::string obsId;
+    bool presenceNoted = false;
+    std::pmr::string subId;
+    std::pmr::string subnational1Code;
+    std::pmr::string subnational1Name;
+    std::pmr::string subnational2Code;
+    std::pmr::string subnational2Name;
+    std::pmr::string userDisplayName;
+
+    operator DetailedObservation() const
+    {
+      DetailedObservation owned;
+      static_cast<Observation&>(owned) = static_cast<const ArenaObservation&>(*this);
+      owned.checklistId = checklistId;
+      owned.countryCode = countryCode;
+      owned.countryName = countryName;
+      owned.firstName = firstName;
+      owned.hasComments = hasComments;
+      owned.hasRichMedia = hasRichMedia;
+      owned.lastName = lastName;
+      owned.locID = locID;
+      owned.obsId = obsId;
+      owned.presenceNoted = presenceNoted;
+      owned.subId = subId;
+      owned.subnational1Code = subnational1Code;
+      owned.subnational1Name = subnational1Name;
+      owned.subnational2Code = subnational2Code;
+      owned.subnational2Name = subnational2Name;
+      owned.userDisplayName = userDisplayName;
+      return owned;
+    }
+  };
+
+  struct ArenaObservations : public ArenaRows<ArenaObservation, Observations>
+  {
+    ArenaObservations() = default;
+  };
+
+  struct ArenaDetailedObservations : public ArenaRows<ArenaDetailedObservation, DetailedObservations>
+  {
+    ArenaDetailedObservations() = default;
+  };
+
+
+
 }
 
 #endif
@@ -0,0 +1,110 @@
+#ifndef CBIRDPP_RATELIMITER_H
+#define CBIRDPP_RATELIMITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace cbirdpp
+{
+
+  /** \class RateLimiter
+   *  \brief A token bucket rate limiter combined with an AIMD concurrency governor, shared by every request.
+   *
+   *  Each request takes a Ticket before it is sent. A ticket needs a token from the bucket, which refills at the
+   *  current rate, and a free slot under the current concurrency limit. When a response comes back the ticket reports
+   *  its status: a 429 or 5xx cuts the concurrency limit and the rate to 70% (multiplicative decrease), at most once
+   *  for the requests that were already in flight, and honours a Retry-After by pausing the bucket. Successes raise
+   *  them again linearly (additive increase), the concurrency limit by one per round of requests and the rate by 5% of
+   *  its maximum per second, up to the configured maximums. Bulk jobs thereby settle just under the throughput the
+   *  API tolerates instead of retrying blindly after each 429.
+   */
+  class RateLimiter
+  {
+    public:
+      /** \class Ticket
+       *  \brief Permission for one request. Frees its concurrency slot on destruction.
+       */
+      class Ticket
+      {
+        private:
+          RateLimiter* limiter = nullptr;
+          unsigned long epoch = 0;
+
+        public:
+          Ticket() = default;
+          Ticket(RateLimiter* owner, unsigned long epoch);
+          Ticket(Ticket&& other) noexcept;
+          Ticket& operator=(Ticket&& other) noexcept;
+          Ticket(const Ticket&) = delete;
+          Ticket& operator=(const Ticket&) = delete;
+          ~Ticket();
+
+          /// True if the ticket holds a slot.
+          explicit operator bool() const { return limiter != nullptr; }
+
+          /// Reports the HTTP status of the response to the governor.
+          /** @param status the HTTP status code, anything other than 2xx, 429 and 5xx leaves the limits unchanged.
+           *  @param retry_after the seconds a 429 asked to wait, 0 if it didn't say.
+           */
+          void complete(long status, long retry_after=0);
+      };
+
+      /** @param max_rate the maximum sustained requests per second, 0 for no rate limit.
+       *  @param max_concurrency the maximum amount of requests in flight at once, 0 for no limit.
+       */
+      explicit RateLimiter(double max_rate=0, unsigned int max_concurrency=0);
+
+      RateLimiter(const RateLimiter&) = delete;
+      RateLimiter& operator=(const RateLimiter&) = delete;
+
+      /// Blocks until a request may be sent and returns its ticket.
+      Ticket acquire();
+
+      /// Takes a ticket if a request may be sent right now, without blocking.
+      /** @param ticket receives the ticket on success and is left alone otherwise.
+       *  @return true if a ticket was taken.
+       */
+      bool try_acquire(Ticket& ticket);
+
+      /// How long until try_acquire could succeed on the rate alone, a full slot waits for a ticket to be released.
+      std::chrono::milliseconds next_available() const;
+
+      /// The current requests per second, 0 if the rate is not limited.
+      double rate() const;
+
+      /// The current concurrency limit, 0 if it is not limited.
+      double concurrency_limit() const;
+
+      /// The amount of requests holding a ticket.
+      std::size_t in_flight() const;
+
+    private:
+      using Clock = std::chrono::steady_clock;
+
+      mutable std::mutex limiter_mutex;
+      std::condition_variable released;
+      double max_rate;
+      double current_rate;
+      double tokens;
+      Clock::time_point refilled;
+      Clock::time_point paused_until;
+      double max_concurrency;
+      double limit;
+      std::size_t active = 0;
+      unsigned long epoch = 0;
+
+      /// Refills the bucket and takes a token and a slot if both are available. Requires limiter_mutex.
+      bool admit(Clock::time_point now);
+
+      /// The wait until a token is available. Requires limiter_mutex.
+      Clock::duration token_wait(Clock::time_point now) const;
+
+      void record(unsigned long ticket_epoch, long status, long retry_after);
+      void release();
+  };
+
+}
+
+#endif
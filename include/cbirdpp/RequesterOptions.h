@@ -0,0 +1,220 @@
+#ifndef CBIRDPP_REQUESTEROPTIONS_H
+#define CBIRDPP_REQUESTEROPTIONS_H
+
+#include "ParameterExceptions.h"
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+namespace cbirdpp
+{
+  enum HttpVersion {http1_1=0, http2, http2_prior_knowledge};
+
+  /*
+   * The groups of API endpoints that timeouts and latency statistics are kept for. observations covers every recent
+   * and nearby data/obs request, and recent checklists fall under checklist_feed.
+   */
+  enum Endpoint {observations=0, historic_observations, top_100, checklist_feed, regional_statistics};
+  const std::size_t ENDPOINT_COUNT = 5;
+
+  /*
+   * A class providing an interface for tuning how a Requester talks to the eBird API.
+   * The options can optionally be passed to the Requester constructor, every option that isn't set keeps its default.
+   */
+  class RequesterOptions
+  {
+    private:
+      HttpVersion _http_version = HttpVersion::http1_1;
+      unsigned int _max_concurrent_streams = 100;
+      unsigned int _max_host_connections = 0;
+      bool _compression = true;
+      double _rate_limit = 0;
+      unsigned int _max_concurrency = 0;
+      std::array<unsigned int, ENDPOINT_COUNT> _timeouts = {{30000, 60000, 30000, 30000, 30000}};
+      unsigned int _max_retries = 2;
+      unsigned int _backoff_base = 250;
+      unsigned int _backoff_cap = 8000;
+      bool _hedging = false;
+      unsigned int _revalidation_cache = 256;
+      unsigned int _prewarm = 0;
+      unsigned int _string_pool = 64;
+      unsigned int _parallel_decode = 1024;
+      unsigned int _decode_threads = 0;
+      std::string _api_url = "https://ebird.org/ws2.0/";
+
+    public:
+      /*
+       * Default constructor. Every option starts out with its default.
+       */
+      RequesterOptions();
+
+      /*
+       * Set the HTTP version used for requests. With http2, concurrent async requests to the same host are multiplexed
+       * over a single connection. http2 is negotiated during the TLS handshake and falls back to HTTP/1.1, while
+       * http2_prior_knowledge speaks HTTP/2 right away, which is only useful for cleartext test servers.
+       * @param http_version A HttpVersion enum, range: [http1_1|http2|http2_prior_knowledge], default: http1_1
+       */
+      void set_http_version(const HttpVersion& http_version);
+
+      /*
+       * Set the maximum amount of concurrent HTTP/2 streams on one connection. Transfers beyond the limit wait for a
+       * free stream, or open another connection if max_host_connections allows it.
+       * @param max_concurrent_streams An unsigned integer, range: [1-1000], default: 100
+       */
+      void set_max_concurrent_streams(const unsigned int max_concurrent_streams);
+
+      /*
+       * Set the maximum amount of connections async requests may open to a single host.
+       * @param max_host_connections An unsigned integer, range: [0-1000], default: 0 (no max)
+       */
+      void set_max_host_connections(const unsigned int max_host_connections);
+
+      /*
+       * Set the compression option. When enabled every encoding libcurl was built with (gzip, deflate and brotli if
+       * available) is offered through Accept-Encoding, and responses are decompressed chunk by chunk as they arrive.
+       * @param compression a bool, range: [true|false], default: true
+       */
+      void set_compression(const bool compression);
+
+      /*
+       * Set the maximum requests per second, shared by every request of the Requester, its copies and async requests.
+       * The rate backs off on 429 and 5xx responses and recovers on successes, but never rises above this maximum.
+       * @param rate_limit A double, range: [0-1000], default: 0 (no limit)
+       */
+      void set_rate_limit(const double rate_limit);
+
+      /*
+       * Set the maximum amount of requests in flight at once. The concurrency limit backs off on 429 and 5xx
+       * responses and recovers on successes up to this maximum, without a maximum it only starts after a back off.
+       * @param max_concurrency An unsigned integer, range: [0-1000], default: 0 (no max)
+       */
+      void set_max_concurrency(const unsigned int max_concurrency);
+
+      /*
+       * Set the timeout of a whole request, connecting included, for one group of endpoints. A request that times
+       * out fails, or is retried if retries are left.
+       * @param endpoint An Endpoint enum, range: [observations|historic_observations|top_100|checklist_feed|regional_statistics]
+       * @param timeout An unsigned integer in milliseconds, range: [0-600000], default: 60000 for historic_observations
+       *                and 30000 for the rest, 0 for no timeout
+       */
+      void set_timeout(const Endpoint& endpoint, const unsigned int timeout);
+
+      /*
+       * Set how often a request is retried after a transport failure, a timeout, a 429 or a 5xx response.
+       * @param max_retries An unsigned integer, range: [0-10], default: 2
+       */
+      void set_max_retries(const unsigned int max_retries);
+
+      /*
+       * Set the exponential backoff between retries. Before retry n a random delay between 0 and
+       * min(backoff_cap, backoff_base * 2^n) milliseconds is waited (full jitter), so retries of many clients spread out.
+       * @param backoff_base An unsigned integer in milliseconds, range: [1-60000], default: 250
+       * @param backoff_cap An unsigned integer in milliseconds, range: [1-600000], default: 8000
+       */
+      void set_backoff(const unsigned int backoff_base, const unsigned int backoff_cap);
+
+      /*
+       * Set the hedging option. With hedging, a request still outstanding after the 95th percentile latency observed
+       * for its endpoint gets a duplicate, and whichever response arrives first is used. Only the slowest 5% of
+       * requests are duplicated, and only once 20 latencies of the endpoint have been observed.
+       * @param hedging a bool, range: [true|false], default: false
+       */
+      void set_hedging(const bool hedging);
+
+      /*
+       * Set the amount of responses kept for revalidation. The decoded result of a response that came with an ETag or
+       * Last-Modified header is kept along with them, and the next identical request sends If-None-Match and
+       * If-Modified-Since. When the server answers 304 Not Modified, the kept result is returned without downloading
+       * or decoding the body again. The least recently used responses are dropped first.
+       * @param revalidation_cache An unsigned integer, range: [0-100000], default: 256, 0 disables revalidation
+       */
+      void set_revalidation_cache(const unsigned int revalidation_cache);
+
+      /*
+       * Set the amount of connections opened in the background as soon as a Requester or SharedContext is constructed.
+       * The host is resolved and the TCP and TLS handshakes are done before the first request needs them, both for
+       * blocking and for async requests. Requester::ready() tells when the warm-up is over.
+       * @param prewarm An unsigned integer, range: [0-16], default: 0 (no warm-up)
+       */
+      void set_prewarm(const unsigned int prewarm);
+
+      /*
+       * Set the size in MiB the pool the intern_ requests store their text in grows to. Once it is reached, results
+       * are interned into a new pool, and the full one is freed along with the last result using it.
+       * @param string_pool An unsigned integer, range: [1-4096], default: 64
+       */
+      void set_string_pool(const unsigned int string_pool);
+
+      /*
+       * Set when the rows of a response are decoded on several threads. A response of at least parallel_decode KiB is
+       * split at row boundaries into one run of rows per thread, the runs are decoded at once and their rows joined
+       * in order. Smaller responses, and every response with a single thread, are decoded on one thread. The threads
+       * are those of a WorkerPool owned by the Requester, or by its SharedContext, which decode_threads sets the size of.
+       * @param parallel_decode An unsigned integer in KiB, range: [64-1048576], default: 1024
+       * @param decode_threads An unsigned integer, range: [0-64], default: 0 (one per hardware thread)
+       */
+      void set_parallel_decode(const unsigned int parallel_decode, const unsigned int decode_threads);
+
+      /*
+       * Set the base url of the API, for example to go through a caching proxy or to point at a local test server.
+       * A missing trailing '/' is added.
+       * @param api_url A string, default: "https://ebird.org/ws2.0/"
+       */
+      void set_api_url(const std::string& api_url);
+
+      /*
+       * Reset all options back to defaults.
+       */
+      void reset();
+
+      /*
+       *  Getters for each option
+       */
+      const HttpVersion& http_version() const;
+
+      unsigned int max_concurrent_streams() const;
+
+      unsigned int max_host_connections() const;
+
+      bool compression() const;
+
+      double rate_limit() const;
+
+      unsigned int max_concurrency() const;
+
+      unsigned int timeout(const Endpoint& endpoint) const;
+
+      unsigned int max_retries() const;
+
+      unsigned int backoff_base() const;
+
+      unsigned int backoff_cap() const;
+
+      bool hedging() const;
+
+      unsigned int revalidation_cache() const;
+
+      unsigned int prewarm() const;
+
+      unsigned int string_pool() const;
+
+      unsigned int parallel_decode() const;
+
+      unsigned int decode_threads() const;
+
+      const std::string& api_url() const;
+
+      /*
+       * Returns the CURL_HTTP_VERSION_* value matching http_version().
+       */
+      long curl_http_version() const;
+
+      /*
+       * Returns true if the http version allows multiplexing requests over one connection.
+       */
+      bool multiplexed() const;
+  };
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef CBIRDPP_RESPONSEBUFFER_H
+#define CBIRDPP_RESPONSEBUFFER_H
+
+#include <curlpp/Easy.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace cbirdpp
+{
+
+  /** \class ResponseBuffer
+   *  \brief A reusable sink that curl writes a response straight into.
+   *
+   *  The buffer is attached to a handle with attach(), which installs write and header callbacks on it. The body goes
+   *  to the write callback and the headers to the header callback, so the body starts at byte 0 of the buffer. From
+   *  the headers the buffer keeps the status code, the Content-Type, Retry-After and the validators, and as soon as Content-Length
+   *  arrives it reserves room for the whole body, so it is allocated once instead of growing chunk by chunk. clear()
+   *  keeps that capacity around for the next response on the same handle. The body is handed out as a view that the
+   *  Requester decodes in place while the transfer still holds the buffer, and a body that has to outlive the transfer,
+   *  one decoded on another thread or kept by its result, is moved out with release() rather than copied. A buffer
+   *  given a sink with stream_to() keeps no body at all and hands each chunk to the sink as it arrives instead.
+   */
+  class ResponseBuffer
+  {
+    public:
+      /// Receives the body chunk by chunk, returning false aborts the transfer.
+      /** The headers have all arrived by the first chunk, so the sink can look at the status of the response first.
+       */
+      using Sink = std::function<bool(const ResponseBuffer& response, std::string_view chunk)>;
+
+      ResponseBuffer() = default;
+      ResponseBuffer(ResponseBuffer&& other) noexcept = default;
+      ResponseBuffer& operator=(ResponseBuffer&& other) noexcept = default;
+      ResponseBuffer(const ResponseBuffer&) = delete;
+      ResponseBuffer& operator=(const ResponseBuffer&) = delete;
+
+      /// Points the write and header callbacks of handle at this buffer and empties it.
+      /** The buffer must outlive every transfer performed with the handle until it is attached elsewhere.
+       */
+      void attach(cURLpp::Easy& handle);
+
+      /// Hands the body of the response to sink as it arrives, until the buffer is cleared or attached again.
+      /** Content-Length then reserves nothing and the body isn't kept, so view() stays empty.
+       *  @param sink the callable receiving the body, an empty one keeps the body in the buffer as usual.
+       */
+      void stream_to(Sink sink);
+
+      /// Empties the buffer, keeping its capacity unless it grew beyond what is worth holding on to between requests.
+      void clear();
+
+      /// The body received so far.
+      std::string_view view() const;
+
+      /// Moves the body out, leaving the buffer empty.
+      /** The capacity goes with the body, so the next response on the handle allocates its body anew.
+       */
+      std::string release();
+
+      /// The amount of bytes the buffer can hold without reallocating.
+      std::size_t capacity() const;
+
+      /// The HTTP status code of the response, 0 until the status line has been received.
+      long status() const;
+
+      /// The value of the Content-Type header, empty if there was none.
+      std::string_view content_type() const;
+
+      /// The seconds to wait given by a Retry-After header, 0 if there was none or it held a date.
+      long retry_after() const;
+
+      /// The value of the ETag header, quotes included, empty if there was none.
+      std::string_view etag() const;
+
+      /// The value of the Last-Modified header, empty if there was none.
+      std::string_view last_modified() const;
+
+      /// Appends a chunk of the body, used as the curl write callback.
+      std::size_t append(const char* data, std::size_t size);
+
+      /// Inspects one header line, used as the curl header callback.
+      std::size_t header(const char* data, std::size_t size);
+
+    private:
+      std::string bytes;
+      long status_code = 0;
+      std::string type;
+      long retry_seconds = 0;
+      std::string entity_tag;
+      std::string modified;
+      Sink sink;
+  };
+
+}
+
+#endif
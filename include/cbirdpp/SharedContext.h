@@ -0,0 +1,101 @@
+#ifndef CBIRDPP_SHAREDCONTEXT_H
+#define CBIRDPP_SHAREDCONTEXT_H
+
+#include "RequesterOptions.h"
+
+#include <curl/curl.h>
+
+#include <array>
+#include <future>
+#include <memory>
+#include <mutex>
+
+namespace cbirdpp
+{
+
+  class AsyncEngine;
+  class ConnectionPool;
+  class RateLimiter;
+  class InternedStrings;
+  class SingleFlight;
+  class Transport;
+  class ValidatorCache;
+  class WorkerPool;
+
+  /** \class SharedContext
+   *  \brief Opt-in state shared by every Requester constructed with it, typically one per process.
+   *
+   *  Requesters that each own their own handles repeat the DNS lookup and the full TLS handshake to ebird.org. A
+   *  Requester constructed with a SharedContext instead uses the context's handles. Those handles are attached to a
+   *  curl share object that caches DNS results and TLS session tickets, so new connections resolve from the cache and
+   *  resume the TLS session. Open connections are shared through one ConnectionPool and one AsyncEngine owned by the
+   *  context. libcurl does not support a shared connection cache used by concurrent threads, but each pooled handle
+   *  is used by one thread at a time. The share object is guarded by a mutex for each kind of data, which libcurl
+   *  takes through the lock callbacks, so any number of threads can use Requesters on the same context. They also
+   *  share one RateLimiter, so the rate limit holds for the whole process, one SingleFlight, so identical requests
+   *  from different threads are coalesced as long as they use the same api key, and one WorkerPool to decode on.
+   */
+  class SharedContext
+  {
+    public:
+      /** @param options the options for every Requester using this context, they override the Requester's own.
+       */
+      explicit SharedContext(const RequesterOptions& options=RequesterOptions());
+
+      SharedContext(const SharedContext&) = delete;
+      SharedContext& operator=(const SharedContext&) = delete;
+
+      ~SharedContext();
+
+      /// The options every Requester using this context runs with.
+      const RequesterOptions& options() const;
+
+      /// The pool of handles for blocking requests, each attached to the share object.
+      std::shared_ptr<ConnectionPool> connections() const;
+
+      /// The engine performing async requests, its handles are attached to the share object too.
+      std::shared_ptr<AsyncEngine> engine() const;
+
+      /// The transport over the pool and the engine that Requesters using the context hand their requests to.
+      std::shared_ptr<Transport> transport() const;
+
+      /// The rate limiter shared by every request made through the context.
+      std::shared_ptr<RateLimiter> limiter() const;
+
+      /// Coalesces identical requests in flight from any Requester using this context.
+      std::shared_ptr<SingleFlight> flights() const;
+
+      /// Becomes ready once the connections the options ask to prewarm are open, see Requester::ready().
+      std::shared_future<void> ready() const;
+
+      /// The validators and results kept for revalidation, shared by every Requester using this context.
+      std::shared_ptr<ValidatorCache> validators() const;
+
+      /// The pool the intern_ requests of every Requester using this context store their text in.
+      std::shared_ptr<InternedStrings> strings() const;
+
+      /// The threads every Requester using this context decodes large responses on.
+      std::shared_ptr<WorkerPool> workers() const;
+
+    private:
+      // Declared first so the locks are destroyed last, after the destructor has cleaned up the share.
+      std::array<std::mutex, CURL_LOCK_DATA_LAST> locks;
+      CURLSH* share;
+      RequesterOptions shared_options;
+      std::shared_ptr<RateLimiter> rate_limiter;
+      std::shared_ptr<ConnectionPool> pool;
+      std::shared_ptr<AsyncEngine> async_engine;
+      std::shared_ptr<Transport> curl_transport;
+      std::shared_ptr<SingleFlight> single_flight;
+      std::shared_ptr<ValidatorCache> validator_cache;
+      std::shared_ptr<InternedStrings> interned_strings;
+      std::shared_ptr<WorkerPool> worker_pool;
+      std::shared_future<void> warmed;
+
+      static void lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* context);
+      static void unlock(CURL* handle, curl_lock_data data, void* context);
+  };
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef CBIRDPP_SINGLEFLIGHT_H
+#define CBIRDPP_SINGLEFLIGHT_H
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cbirdpp
+{
+
+  /** \class SingleFlight
+   *  \brief Coalesces concurrent identical requests into one call whose outcome every caller receives, thread safe.
+   *
+   *  The first caller for a key becomes the leader and performs the call, callers arriving while it is in flight only
+   *  wait for its outcome. Nothing is cached: once the leader completes the key is free again, so a later request
+   *  always goes to the network. The result is type erased, the Requester keys calls on the api key, the url and the
+   *  decoded type, so every waiter on a key can cast it back to the same type.
+   */
+  class SingleFlight
+  {
+    public:
+      /// Receives the decoded result of a call, or a null result and the exception that stopped it.
+      using Completion = std::function<void(std::shared_ptr<const void> result, std::exception_ptr error)>;
+
+      /// Adds done to the waiters of the call for key.
+      /** @return true if no call for key was in flight, the caller is then the leader and must hand the outcome of
+       *  the call to complete().
+       */
+      bool join(const std::string& key, Completion done);
+
+      /// Ends the call for key and hands its outcome to every waiter, on the calling thread.
+      void complete(const std::string& key, std::shared_ptr<const void> result, std::exception_ptr error);
+
+      /// The amount of calls currently in flight.
+      std::size_t in_flight() const;
+
+      /// The amount of callers so far that joined a call in flight instead of starting their own.
+      std::size_t coalesced() const;
+
+    private:
+      mutable std::mutex flight_mutex;
+      std::unordered_map<std::string, std::vector<Completion>> calls;
+      std::size_t joined = 0;
+  };
+
+}
+
+#endif
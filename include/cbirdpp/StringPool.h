@@ -0,0 +1,133 @@
+#ifndef CBIRDPP_STRINGPOOL_H
+#define CBIRDPP_STRINGPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cbirdpp
+{
+
+  /** \class InternedString
+   *  \brief A handle to a string stored once in a StringPool, the size of a pointer.
+   *
+   *  Handles are equal when their text is. Within one pool that is a pointer comparison, handles from different pools,
+   *  such as results interned before and after a Requester replaced a full pool, fall back to comparing the text. A
+   *  handle is only valid as long as the pool it came from is alive. A default constructed handle is the empty string.
+   */
+  class InternedString
+  {
+    public:
+      InternedString() = default;
+
+      std::string_view view() const
+      {
+        if(characters == nullptr) {return std::string_view();}
+        std::uint32_t size;
+        std::memcpy(&size, characters - sizeof(size), sizeof(size));
+        return std::string_view(characters, size);
+      }
+
+      operator std::string_view() const {return view();}
+
+      operator std::string() const {return std::string(view());}
+
+      const char* data() const {return view().data();}
+
+      std::size_t size() const {return view().size();}
+
+      bool empty() const {return characters == nullptr;}
+
+      friend bool operator==(InternedString first, InternedString second)
+      {
+        return first.characters == second.characters || first.view() == second.view();
+      }
+
+      friend bool operator!=(InternedString first, InternedString second) {return !(first == second);}
+
+      friend bool operator==(InternedString first, std::string_view second) {return first.view() == second;}
+
+      friend bool operator!=(InternedString first, std::string_view second) {return first.view() != second;}
+
+      friend std::ostream& operator<<(std::ostream& out, InternedString text) {return out << text.view();}
+
+    private:
+      friend class StringPool;
+
+      explicit InternedString(const char* characters) : characters(characters) {}
+
+      const char* characters = nullptr;     // Preceded in the pool by their size as a std::uint32_t.
+  };
+
+  /** \class StringPool
+   *  \brief Stores each distinct string once and hands out InternedString handles to it, thread safe.
+   *
+   *  Species, location and region names repeat across the rows of a response and across responses, rows holding
+   *  handles share one copy of each. Strings are packed into large chunks along with their size, and stay where they
+   *  are until the pool is destroyed.
+   */
+  class StringPool
+  {
+    public:
+      /// The size of the chunks strings are packed into, longer strings get a chunk of their own.
+      static constexpr std::size_t CHUNK = 64 * 1024;
+
+      StringPool();
+      StringPool(const StringPool&) = delete;
+      StringPool& operator=(const StringPool&) = delete;
+
+      /// The handle to text, which is stored first if the pool doesn't hold it yet.
+      InternedString intern(std::string_view text);
+
+      /// The amount of distinct strings in the pool.
+      std::size_t size() const;
+
+      /// The amount of bytes allocated for the pooled strings and their index.
+      std::size_t bytes() const;
+
+    private:
+      // The characters of each stored string by hash, with linear probing and at most half the slots in use. A slot is
+      // a single pointer, so the index costs little more than the handles themselves.
+      const char** slot(std::string_view text);
+
+      void grow();
+
+      mutable std::mutex pool_mutex;
+      std::vector<const char*> slots;
+      std::size_t stored = 0;
+      std::vector<std::unique_ptr<char[]>> chunks;
+      std::size_t chunk_used = 0;                     // Bytes used in the last chunk.
+      std::size_t allocated = 0;
+  };
+
+  /** \class InternedStrings
+   *  \brief The StringPool a Requester interns the text of results into, replaced by a fresh one when it is full.
+   *
+   *  Results keep the pool they were interned into alive, so a full pool is only freed once the last result using it
+   *  is gone. Every string of a result is interned into the same pool.
+   */
+  class InternedStrings
+  {
+    public:
+      /** @param limit the amount of bytes a pool holds before the next result starts a new one.
+       */
+      explicit InternedStrings(std::size_t limit);
+
+      /// The pool for the next result.
+      std::shared_ptr<StringPool> pool();
+
+    private:
+      std::mutex current_mutex;
+      std::size_t limit;
+      std::shared_ptr<StringPool> current;
+  };
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef CBIRDPP_STRUCTURALINDEX_H
+#define CBIRDPP_STRUCTURALINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace cbirdpp
+{
+
+  /** \class StructuralIndex
+   *  \brief The positions of the quotes, brackets, colons and commas that give JSON text its structure.
+   *
+   *  The text is classified 64 bytes at a time into bit masks, with AVX2 on CPUs that have it, chosen at run time
+   *  whatever the build targets, SSE2 on other x86-64 CPUs and plain loops elsewhere. Escaped quotes are discarded and everything between a pair
+   *  of quotes is masked out, so the index lists every unescaped quote and every bracket, colon and comma outside of
+   *  strings, in order. A JsonReader uses it to find the end of a string or container without looking at the bytes in
+   *  between.
+   *
+   *  The index of a large response takes more memory than the response itself, so readers don't allocate it anew for
+   *  every response: an index retired with retire() leaves its memory to the next recycled() one of the same thread.
+   */
+  class StructuralIndex
+  {
+    public:
+      /// An empty index.
+      StructuralIndex() = default;
+
+      /// Indexes text, throws RequestFailed if a string is left open or holds a raw control character.
+      /** @param text the JSON text, at most 4 GiB.
+       */
+      explicit StructuralIndex(std::string_view text);
+
+      /// Indexes text in place of what was indexed before, in the memory the index already has.
+      /** Throws RequestFailed like the constructor, the index is then left empty.
+       *  @param text the JSON text, at most 4 GiB.
+       */
+      void assign(std::string_view text);
+
+      /// Indexes text in the memory of the last index retired on the calling thread, if there was one.
+      static StructuralIndex recycled(std::string_view text);
+
+      /// Keeps the memory of index for the next recycled() index of the calling thread, unless more is kept already.
+      /** Each thread keeps the memory of the largest index it retired until it exits.
+       */
+      static void retire(StructuralIndex&& index);
+
+      /// The offsets of the structural characters in the text, ascending.
+      const std::vector<std::uint32_t>& positions() const {return offsets;}
+
+      /// False if the text has no backslash at all, so none of its strings need unescaping.
+      bool escapes() const {return backslashes;}
+
+      /// Which implementation classifies the text: "avx2", "sse2" or "scalar".
+      static const char* implementation();
+
+    private:
+      std::vector<std::uint32_t> offsets;
+      bool backslashes = false;
+  };
+
+}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef CBIRDPP_TIMESTAMP_H
+#define CBIRDPP_TIMESTAMP_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace cbirdpp
+{
+
+  /** \class Timestamp
+   *  \brief A date and, when one was recorded, a time of day, held as days since 1970-01-01 and minutes since midnight.
+   *
+   *  The dates of observations and checklists are parsed into timestamps once, as a response is decoded, so sorting
+   *  rows or picking those in a time window compares integers. A date without a time orders before every time of that
+   *  day. Text is only formatted when it is asked for.
+   */
+  class Timestamp
+  {
+    public:
+      /// 1970-01-01, without a time.
+      Timestamp() = default;
+
+      /// A date without a time, throws ArgumentOutOfRange for a date that doesn't exist.
+      /** @param year the year in the range [1-9999].
+       *  @param month the month in the range [1-12].
+       *  @param day the day of the month, in the range [1-31] depending on the month.
+       */
+      Timestamp(int year, unsigned int month, unsigned int day);
+
+      /// A date and time of day, throws ArgumentOutOfRange for a date or time that doesn't exist.
+      /** @param hour the hour in the range [0-23].
+       *  @param minute the minute in the range [0-59].
+       */
+      Timestamp(int year, unsigned int month, unsigned int day, unsigned int hour, unsigned int minute);
+
+      /// Parses "2018-01-01 23:51", or "2018-01-01" for a date without a time, as the API gives observation dates.
+      /** @return false, leaving target as it was, if text isn't a valid date in that form.
+       */
+      static bool parse(std::string_view text, Timestamp& target);
+
+      /// Parses the date of a checklist, "1 Jan 2018" or "2018-01-01", keeping the time of day target had.
+      static bool parse_date(std::string_view text, Timestamp& target);
+
+      /// Parses the time of a checklist, "08:00", keeping the date target had.
+      static bool parse_time(std::string_view text, Timestamp& target);
+
+      /// Days since 1970-01-01, negative before it.
+      std::int32_t days() const {return day_number;}
+
+      /// False for a date without a time of day.
+      bool has_time() const {return minute_number >= 0;}
+
+      /// Minutes since 1970-01-01 00:00, counting a date without a time as midnight.
+      std::int64_t minutes() const {return std::int64_t(day_number) * 1440 + (has_time() ? minute_number : 0);}
+
+      int year() const;
+
+      unsigned int month() const;
+
+      unsigned int day() const;
+
+      /// The hour, 0 for a date without a time.
+      unsigned int hour() const {return has_time() ? static_cast<unsigned int>(minute_number / 60) : 0;}
+
+      /// The minute of the hour, 0 for a date without a time.
+      unsigned int minute() const {return has_time() ? static_cast<unsigned int>(minute_number % 60) : 0;}
+
+      /// "2018-01-01 23:51", or "2018-01-01" for a date without a time.
+      std::string to_string() const;
+
+      operator std::string() const {return to_string();}
+
+      friend bool operator==(Timestamp first, Timestamp second)
+      {
+        return first.day_number == second.day_number && first.minute_number == second.minute_number;
+      }
+
+      friend bool operator!=(Timestamp first, Timestamp second) {return !(first == second);}
+
+      friend bool operator<(Timestamp first, Timestamp second)
+      {
+        return first.day_number < second.day_number ||
+               (first.day_number == second.day_number && first.minute_number < second.minute_number);
+      }
+
+      friend bool operator>(Timestamp first, Timestamp second) {return second < first;}
+
+      friend bool operator<=(Timestamp first, Timestamp second) {return !(second < first);}
+
+      friend bool operator>=(Timestamp first, Timestamp second) {return !(first < second);}
+
+      /// Compares with text in the form parse() takes, text that doesn't parse is never equal.
+      friend bool operator==(Timestamp first, std::string_view second)
+      {
+        Timestamp parsed;
+        return parse(second, parsed) && first == parsed;
+      }
+
+      friend bool operator!=(Timestamp first, std::string_view second) {return !(first == second);}
+
+      friend std::ostream& operator<<(std::ostream& out, Timestamp time) {return out << time.to_string();}
+
+    private:
+      std::int32_t day_number = 0;
+      std::int16_t minute_number = -1;      // -1 for a date without a time.
+  };
+
+}
+
+#endif
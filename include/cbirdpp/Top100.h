@@ -1,6 +1,9 @@
 #ifndef CBIRDPP_TOP100_H
 #define CBIRDPP_TOP100_H
 
+#include "ArenaRows.h"
+
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -25,6 +28,43 @@ namespace cbirdpp
   {
     Top100() = default;
   };
+
+  /*
+   * A row of the Top 100 whose text is allocated from the arena of the ArenaTop100 holding it, see ArenaRows.
+   */
+  struct ArenaTop100Base
+  {
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    ArenaTop100Base(const allocator_type& arena={}) : profileHandle(arena), userDisplayName(arena), userId(arena) {}
+
+    ArenaTop100Base(const ArenaTop100Base& other, const allocator_type& arena) : ArenaTop100Base(arena) {*this = other;}
+
+    ArenaTop100Base(ArenaTop100Base&& other, const allocator_type& arena) : ArenaTop100Base(arena) {*this = std::move(other);}
+
+    ArenaTop100Base(const ArenaTop100Base&) = default;
+    ArenaTop100Base(ArenaTop100Base&&) = default;
+    ArenaTop100Base& operator=(const ArenaTop100Base&) = default;
+    ArenaTop100Base& operator=(ArenaTop100Base&&) = default;
+
+    std::pmr::string profileHandle;
+    std::pmr::string userDisplayName;
+    unsigned int numSpecies = 0;
+    unsigned int numCompleteChecklists = 0;
+    unsigned int rowNum = 0;
+    std::pmr::string userId;
+
+    operator Top100Base() const
+    {
+      return {std::string(profileHandle), std::string(userDisplayName), numSpecies, numCompleteChecklists, rowNum,
+              std::string(userId)};
+    }
+  };
+
+  struct ArenaTop100 : public ArenaRows<ArenaTop100Base, Top100>
+  {
+    ArenaTop100() = default;
+  };
 }
 
 #endif
@@ -0,0 +1,78 @@
+#ifndef CBIRDPP_TRANSPORT_H
+#define CBIRDPP_TRANSPORT_H
+
+#include "ResponseBuffer.h"
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
+#include <list>
+#include <string>
+
+namespace cbirdpp
+{
+
+  /** \class Transport
+   *  \brief The network layer a Requester hands its requests to.
+   *
+   *  Everything above the transport, such as retries, hedging, coalescing and decoding, is done by the Requester, so
+   *  any implementation gets those for free. CurlTransport talks to ebird.org, MemoryTransport serves canned responses
+   *  from memory for tests and benchmarks that must not depend on the network.
+   */
+  class Transport
+  {
+    public:
+      /// Receives the response, or the error that stopped the transfer.
+      /** The response is only valid until the callback returns, a body that must outlive it is moved out with
+       *  ResponseBuffer::release().
+       */
+      using Completion = std::function<void(ResponseBuffer& response, std::exception_ptr error)>;
+
+      /// Everything about a GET request besides its completion.
+      struct Request
+      {
+        std::string url;
+        std::list<std::string> headers;                 // Extra HTTP headers in the format "Name: value".
+        std::chrono::milliseconds timeout{0};           // For the whole transfer, 0 for none.
+        std::chrono::milliseconds delay{0};             // How long to hold the transfer back before queueing it.
+        std::function<bool()> wanted;                   // Asked when a delayed transfer comes due, false drops it.
+        bool headers_only = false;                      // Sends a HEAD request, the body is left out.
+        ResponseBuffer::Sink stream;                    // Receives the body as it arrives instead of the response,
+                                                        // honoured by perform.
+      };
+
+      virtual ~Transport() = default;
+
+      /// Performs a request on the calling thread.
+      /** Throws TransferFailed if no response arrived, or if the stream of the request aborted it. A response with an
+       *  error status is still handed to received.
+       *  @param request the url, headers and timeout of the request, the delay is ignored.
+       *  @param received invoked with the response before perform returns, while the connection is still held.
+       */
+      virtual void perform(const Request& request, const std::function<void(ResponseBuffer&)>& received) = 0;
+
+      /// Queues a request, holding it back first if it has a delay, and returns immediately.
+      /** A delayed request that is no longer wanted when it comes due is dropped and completes with RequestFailed.
+       *  @param request the url, headers, timeout and delay of the request.
+       *  @param done the callback that receives the response, it may run on any thread, including this one.
+       */
+      virtual void submit(const Request& request, Completion done) = 0;
+
+      /// Opens connections to the host of a url in the background, ahead of the first request.
+      /** @param url a url on the host, it is requested with HEAD.
+       *  @param connections the amount of connections to open.
+       *  @return a future that becomes ready once the warm-up is over, it holds TransferFailed if no connection could
+       *  be opened. Transports without connections are ready right away.
+       */
+      virtual std::future<void> prewarm(const std::string& /*url*/, unsigned int /*connections*/)
+      {
+        std::promise<void> ready;
+        ready.set_value();
+        return ready.get_future();
+      }
+  };
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef CBIRDPP_VALIDATORCACHE_H
+#define CBIRDPP_VALIDATORCACHE_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace cbirdpp
+{
+
+  /** \class ValidatorCache
+   *  \brief Remembers the validators and the decoded result of recent responses for conditional requests, thread safe.
+   *
+   *  The Requester looks a request up before sending it. If an entry exists, the request carries If-None-Match and
+   *  If-Modified-Since, and a 304 Not Modified response is answered with the entry's decoded result. Entries are keyed
+   *  like coalesced requests, on the api key, the url and the decoded type, and the least recently used entry is
+   *  dropped once the cache is full.
+   */
+  class ValidatorCache
+  {
+    public:
+      /// The validators of a response and the result decoded from its body, which has to be a const object.
+      struct Entry
+      {
+        std::string etag;
+        std::string last_modified;
+        std::shared_ptr<const void> decoded;
+
+        /// The headers that make a request conditional on the response having changed since.
+        std::list<std::string> conditions() const;
+      };
+
+      /** @param capacity the amount of entries kept, 0 keeps none.
+       */
+      explicit ValidatorCache(std::size_t capacity);
+
+      /// The entry for key, or nullptr. Marks the entry as recently used.
+      std::shared_ptr<const Entry> find(const std::string& key);
+
+      /// Adds or replaces the entry for key.
+      void store(const std::string& key, Entry entry);
+
+      /// The amount of entries kept.
+      std::size_t size() const;
+
+    private:
+      using Recent = std::list<std::pair<std::string, std::shared_ptr<const Entry>>>;
+
+      mutable std::mutex cache_mutex;
+      std::size_t capacity;
+      Recent recent;                                                  // Most recently used first.
+      std::unordered_map<std::string, Recent::iterator> index;
+  };
+
+}
+
+#endif
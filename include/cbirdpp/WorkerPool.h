@@ -0,0 +1,67 @@
+#ifndef CBIRDPP_WORKERPOOL_H
+#define CBIRDPP_WORKERPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cbirdpp
+{
+
+  /** \class WorkerPool
+   *  \brief A fixed set of threads that decode responses off the threads that requested them, thread safe.
+   *
+   *  The threads are started by the first task, so a Requester that never decodes in the background never starts
+   *  them, and they are joined when the pool is destroyed, after the tasks already posted have run. run() lets the
+   *  calling thread take part in its own tasks, so a task running on the pool can use run() as well without waiting
+   *  on a thread that is waiting for it.
+   */
+  class WorkerPool
+  {
+    public:
+      /** @param threads the amount of threads, 0 for one per hardware thread.
+       */
+      explicit WorkerPool(unsigned int threads);
+
+      WorkerPool(const WorkerPool&) = delete;
+      WorkerPool& operator=(const WorkerPool&) = delete;
+
+      ~WorkerPool();
+
+      /// The amount of threads of the pool.
+      unsigned int size() const {return thread_count;}
+
+      /// Runs task on one of the threads of the pool, tasks are started in the order they were posted.
+      /** @param task a callable that must not throw.
+       */
+      void post(std::function<void()> task);
+
+      /// Calls task(0) to task(count - 1) on the calling thread and the threads of the pool, and returns once all of
+      /// them have returned.
+      /** The calling thread takes tasks as well, so all of them run even if every thread of the pool is busy.
+       *  @return the first exception thrown by a task is rethrown once every task is done.
+       */
+      void run(std::size_t count, const std::function<void(std::size_t)>& task);
+
+    private:
+      // Starts the threads, if they haven't been yet. Called with the queue locked.
+      void start();
+
+      // Runs the tasks of the queue until the pool is destroyed.
+      void work();
+
+      unsigned int thread_count;
+      std::mutex queue_mutex;
+      std::condition_variable queued;
+      std::deque<std::function<void()>> tasks;
+      std::vector<std::thread> threads;
+      bool stopping = false;
+  };
+
+}
+
+#endif
@@ -1,19 +1,44 @@
 #ifndef CBIRDPP_CBIRDPP_H
 #define CBIRDPP_CBIRDPP_H
 
+#include "ArenaRows.h"
+#include "ArrayStream.h"
+#include "Checked.h"
 #include "Checklist.h"
 #include "DataOptionalParameters.h"
+#include "JsonReader.h"
+#include "LatencyTracker.h"
 #include "Observation.h"
+#include "RateLimiter.h"
 #include "RegionalStats.h"
+#include "RequesterOptions.h"
+#include "SharedContext.h"
+#include "SingleFlight.h"
+#include "StringPool.h"
+#include "Timestamp.h"
 #include "Top100.h"
+#include "Transport.h"
+#include "ValidatorCache.h"
+#include "WorkerPool.h"
 
 #include "../nlohmann/json.hpp"
 
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
 #include <vector>
 
 namespace cbirdpp {
 
+class ResponseBuffer;
+
 enum SortType {obs_dt, creation_dt};
 
 extern DataOptionalParameters DATA_DEFAULT_PARAMS;
@@ -32,6 +57,18 @@ extern DataOptionalParameters DATA_DEFAULT_PARAMS;
 class Requester {
   private:
     std::string api_key;
+    RequesterOptions options;
+    std::shared_ptr<SharedContext> context;        // Keeps the context alive, null unless constructed with one.
+    std::shared_ptr<RateLimiter> limiter;          // Every request, blocking or async, passes through it.
+    std::shared_ptr<Transport> transport;          // Shared by copies of the Requester, so they reuse connections too.
+    std::shared_ptr<LatencyTracker> latencies;     // Recent latencies per endpoint, hedged requests fire after their p95.
+    std::shared_ptr<SingleFlight> flights;         // Identical requests in flight at the same time share one transfer.
+    std::shared_ptr<ValidatorCache> validators;    // ETags and decoded results of recent responses, for revalidation.
+    std::shared_ptr<InternedStrings> interned;     // The pool the intern_ requests store their text in.
+    std::shared_ptr<WorkerPool> workers;           // The threads large responses are decoded on.
+    std::shared_future<void> warmed;               // Ready once the connections asked for by the options are open.
+
+    struct AsyncAttempt;
 
     /// Processes DataOptionalParams into a vector of string arguments. 
     /** This version of the function takes all possible mandatory arguments as well as
@@ -101,73 +138,387 @@ class Requester {
      */
      std::string generate_date(int year, int month, int day) const;
 
-    /// Takes a request URL and returns the result as a JSON object.
-    /** This method assumes a JSON object will be returned and throws an exception if one is not.
+    /// The JSON body of a response along with the validators it came with.
+    /** The body stays in the buffer of the transfer, which is only valid until the transport's callback returns. A
+     *  response that has to outlive the callback takes the body over with own().
+     */
+    struct ParsedResponse
+    {
+      ResponseBuffer* buffer = nullptr;            // Holds the body until own() moves it out.
+      std::string body;                            // The body once it is owned.
+      std::string etag;
+      std::string last_modified;
+      bool not_modified = false;                   // A 304 answer to a conditional request, the body is null.
+
+      /// The body, wherever it is held.
+      std::string_view text() const { return buffer ? buffer->view() : std::string_view(body); }
+
+      /// Moves the body out of the buffer of the transfer, so the response can outlive it.
+      void own()
+      {
+        if(buffer) {body = buffer->release();}
+        buffer = nullptr;
+      }
+    };
+
+    /// Takes a request URL and hands the resulting JSON object to a callback on the calling thread.
+    /** This method assumes a JSON object will be returned and throws an exception if one is not. Failures worth
+     *  retrying are retried with backoff as the options allow, and with hedging enabled the request is submitted
+     *  asynchronously so a duplicate can be raced against it. Without hedging, received runs while the transfer still
+     *  holds its buffer and reads the body in place, an exception it throws is rethrown without a retry unless it is
+     *  one worth retrying.
+     *  @param request_url the url of the request to be made.
+     *  @param endpoint the group of endpoints the url belongs to, which selects the timeout.
+     *  @param conditions extra headers such as If-None-Match, a response may then be not_modified.
+     *  @param received the callback that receives the parsed json of the result and its validators.
+     */
+    void request_json(const std::string& request_url, const Endpoint& endpoint, const std::list<std::string>& conditions,
+                      const std::function<void(ParsedResponse&)>& received) const;
+
+    /// Performs a single blocking attempt of a request, without retries, and hands the response to received before
+    /// the transfer lets go of its buffer.
+    void request_once(const std::string& request_url, const Endpoint& endpoint, const std::list<std::string>& conditions,
+                      const std::function<void(ParsedResponse&)>& received) const;
+
+    /// Submits a request to the transport and hands the resulting JSON object to a callback.
+    /** The callback runs on the thread the transport completes the request on, the event loop thread for curl.
+     *  Failures worth retrying are resubmitted after a backoff, and with hedging enabled a duplicate is submitted once
+     *  the endpoint's p95 latency has passed. If the request still fails or the response isn't JSON, the callback
+     *  receives an empty response and the error instead.
      *  @param request_url the url of the request to be made.
-     *  @return a json object of the result.
+     *  @param endpoint the group of endpoints the url belongs to, which selects the timeout.
+     *  @param conditions extra headers such as If-None-Match, a response may then be not_modified.
+     *  @param done the callback that receives the parsed response, which owns its body, or the error that stopped the
+     *  request.
+     */
+    void request_json_async(const std::string& request_url, const Endpoint& endpoint, const std::list<std::string>& conditions,
+                            std::function<void(ParsedResponse, std::exception_ptr)> done) const;
+
+    /// Submits one round of an async request: the request itself and, if hedging, its delayed duplicate.
+    /** @param attempt the request and its state, shared by every round.
+     *  @param delay the backoff to wait before the round starts.
+     */
+    static void submit_round(std::shared_ptr<AsyncAttempt> attempt, std::chrono::milliseconds delay);
+
+    /// The random delay before retry number retry, exponential with full jitter.
+    static std::chrono::milliseconds backoff(const RequesterOptions& options, unsigned int retry);
+
+    /// True if the error is a timeout, transport failure, 429 or 5xx that is worth retrying.
+    /** A transfer aborted by the shutdown of the engine is not, the transport may be going away with it.
      */
-    nlohmann::json request_json(const std::string& request_url) const;
+    static bool retryable(std::exception_ptr error);
 
-     /// Takes some source JSON and converts it to a container of the given base type.
-     /** This method requires that from_json(const json& source, T& target has been defined in the cBirdpp namespace.
-      *  In addition, it is assumed Container is a sub class of std::vector and uses the push_back() method. If it isn't
-      *  a wrapper around a vector, then push_back(Base& b) must be defined on the Container class.
+    /// Checks that a response carries a JSON body, and points at the body where it is along with its validators.
+    /** Error statuses throw without touching the body: BadRequest for 400, RateLimited for 429 and HttpError for any
+     *  other status outside 2xx, except 304, which comes back as not_modified. A body that isn't declared as JSON
+     *  throws RequestFailed, one that doesn't parse throws RequestFailed once it is decoded.
+     */
+    static ParsedResponse parse_response(ResponseBuffer& response);
+
+    /// Turns a parsed response into the shared decoded result, and keeps it for revalidation if it has validators.
+    /** @param key the key of the request in the validator cache.
+     *  @param response the parsed response, its body is read in place unless decode takes a std::string of its own.
+     *  @param cached the entry the request was made conditional on, its result is reused if the response is a 304.
+     *  @param decode a callable taking the JSON text of the response and returning a Result.
+     *  @param validators the cache new validators are stored in.
+     */
+    template <typename Result, typename Decoder>
+    static std::shared_ptr<const void> decode_response(const std::string& key, ParsedResponse& response,
+                                                       const std::shared_ptr<const ValidatorCache::Entry>& cached,
+                                                       Decoder decode, ValidatorCache& validators)
+    {
+      // Only requests with a cached entry are conditional, so a 304 always has a result to fall back on.
+      if(response.not_modified && cached) {return cached->decoded;}
+      std::shared_ptr<const Result> decoded;
+      if constexpr(std::is_invocable_v<Decoder&, std::string_view>) {
+        decoded = std::make_shared<const Result>(decode(response.text()));
+      } else {
+        // A decoder that keeps the text, such as the one of ObservationViews, is given the body instead of a copy.
+        response.own();
+        decoded = std::make_shared<const Result>(decode(std::move(response.body)));
+      }
+      if(!response.etag.empty() || !response.last_modified.empty()) {
+        validators.store(key, ValidatorCache::Entry{std::move(response.etag), std::move(response.last_modified), decoded});
+      }
+      return decoded;
+    }
+
+     /// Takes the source JSON array and converts it to a container of the given base type.
+     /** The rows are read straight from the text, without building a document first. This method requires that
+      *  read_json(JsonReader& source, T& target) has been defined in the cBirdpp namespace. In addition, it is assumed
+      *  Container is a sub class of std::vector and uses the push_back() method. If it isn't a wrapper around a vector,
+      *  then push_back(Base& b) must be defined on the Container class.
       *  @param source the json to be converted
       *  @return A collection of the results as type Base, held in a Container
       */ 
     template <typename Container, typename Base>
-    Container json_to_object(const nlohmann::json& source) const
+    static Container json_to_object(std::string_view source)
     {
       Container result;
-      for(const auto& entry : source) {
-        result.push_back(entry.get<Base>());   
+      JsonReader reader(source);
+      reader.begin_array();
+      while(reader.next_element()) {
+        result.push_back(Base());
+        read_json(reader, result.back());
       }
+      reader.finish();
       return result;
     }
-    
-    /// Performs the common setup between the get recent notable observations in a region requests.
-    /** There is a simple and detailed variation of the get recent notable observations request. Both require basically
-     *  the same setup up to processing the resulting JSON. This method performs that setup.
-     *  @param regionCode any eBird locId or subnational2 code, or ISO/eBird subnational1 or country code.
+
+    /// Takes the source JSON array and reads it into the arena of an ArenaRows result.
+    /** Like json_to_object, this requires read_json(JsonReader& source, Row& target, extra...) to be defined in the
+     *  cBirdpp namespace for the Rows' value_type, which has to take its allocator from the vector it is constructed in.
+     *  @param source the json to be converted
+     *  @param extra further arguments to read_json, such as the fields to read
+     *  @return the results, with their vector and text in the arena of the Rows
+     */
+    template <typename Rows, typename... Extra>
+    static Rows json_to_arena(std::string_view source, Extra... extra)
+    {
+      Rows result;
+      JsonReader reader(source);
+      reader.begin_array();
+      while(reader.next_element()) {read_json(reader, result.decoded_rows().emplace_back(), extra...);}
+      reader.finish();
+      return result;
+    }
+
+    /// A decoder for the rows of an observation response into the arena of an ArenaRows result, reading only the
+    /// given fields of each row. The arena isn't thread safe, so these are always read on the calling thread.
+    template <typename Rows>
+    static auto json_to_arena_fields(unsigned long fields)
+    {
+      return [fields](std::string_view source) { return json_to_arena<Rows>(source, fields); };
+    }
+
+    /// The key identical requests are coalesced on: the api key, the url, and the type and fields the response is
+    /// decoded to.
+    template <typename Result>
+    std::string flight_key(const std::string& request_url, unsigned long fields) const
+    {
+      return api_key + '\n' + request_url + '\n' + typeid(Result).name() + '\n' + std::to_string(fields);
+    }
+
+    /// Performs a request and decodes the result, sharing both with identical requests from other threads.
+    /** If the same request is already in flight, the call waits for it and returns a copy of its result instead of
+     *  making a request of its own. A result that came with validators is revalidated on the next request, and kept
+     *  if the server answers that it is unchanged.
+     *  @param request_url the url of the request to be made.
+     *  @param decode a callable taking the JSON text of the response and returning a Result.
+     *  @param endpoint the group of endpoints the url belongs to, which selects the timeout.
+     *  @param fields the ObservationFields decode reads, requests for different fields are not shared.
+     *  @return the decoded Result, the exception thrown while requesting or decoding it is rethrown to every caller.
+     */
+    template <typename Result, typename Decoder>
+    Result request(const std::string& request_url, Decoder decode, const Endpoint& endpoint=Endpoint::observations,
+                   unsigned long fields=ObservationFields::all) const
+    {
+      std::string key = flight_key<Result>(request_url, fields);
+      auto promise = std::make_shared<std::promise<std::shared_ptr<const void>>>();
+      std::future<std::shared_ptr<const void>> outcome = promise->get_future();
+      bool leader = flights->join(key, [promise](std::shared_ptr<const void> result, std::exception_ptr error) {
+        if(error) {
+          promise->set_exception(error);
+        } else {
+          promise->set_value(std::move(result));
+        }
+      });
+      if(leader) {
+        std::shared_ptr<const void> result;
+        std::exception_ptr error;
+        try {
+          std::shared_ptr<const ValidatorCache::Entry> cached = validators->find(key);
+          request_json(request_url, endpoint, cached ? cached->conditions() : std::list<std::string>(),
+                       [&](ParsedResponse& response) { result = decode_response<Result>(key, response, cached, decode, *validators); });
+        } catch(...) {
+          error = std::current_exception();
+        }
+        flights->complete(key, std::move(result), error);
+      }
+      return *std::static_pointer_cast<const Result>(outcome.get());
+    }
+
+    /// Performs a request asynchronously and decodes the result on completion.
+    /** Like request(), identical requests in flight at the same time share one transfer and one decoded result, and
+     *  unchanged results are revalidated instead of downloaded again. The transport hands over the body and the
+     *  result is decoded on the WorkerPool, so a large response doesn't hold up the other transfers of the event loop.
+     *  @param request_url the url of the request to be made.
+     *  @param decode a callable taking the JSON text of the response and returning a Result.
+     *  @param endpoint the group of endpoints the url belongs to, which selects the timeout.
+     *  @param fields the ObservationFields decode reads, requests for different fields are not shared.
+     *  @return a future that holds the decoded Result, or the exception thrown while requesting or decoding it.
+     */
+    template <typename Result, typename Decoder>
+    std::future<Result> async_request(const std::string& request_url, Decoder decode, const Endpoint& endpoint=Endpoint::observations,
+                                      unsigned long fields=ObservationFields::all) const
+    {
+      std::string key = flight_key<Result>(request_url, fields);
+      auto promise = std::make_shared<std::promise<Result>>();
+      std::future<Result> result = promise->get_future();
+      bool leader = flights->join(key, [promise](std::shared_ptr<const void> shared, std::exception_ptr error) {
+        if(error) {
+          promise->set_exception(error);
+        } else {
+          promise->set_value(*std::static_pointer_cast<const Result>(shared));
+        }
+      });
+      if(!leader) {return result;}
+      std::shared_ptr<SingleFlight> coalescer = flights;
+      std::shared_ptr<ValidatorCache> cache = validators;
+      std::shared_ptr<const ValidatorCache::Entry> cached = validators->find(key);
+      // Only the completion keeps the pool alive, so a decode task never holds the last reference to its own pool.
+      std::shared_ptr<WorkerPool> pool = workers;
+      auto complete = [coalescer, cache, cached, key, decode, pool](ParsedResponse response, std::exception_ptr error) {
+        if(error) {
+          coalescer->complete(key, nullptr, error);
+          return;
+        }
+        pool->post([coalescer, cache, cached, key, decode, response = std::move(response)]() mutable {
+          std::shared_ptr<const void> shared;
+          std::exception_ptr failed;
+          try {
+            shared = decode_response<Result>(key, response, cached, decode, *cache);
+          } catch(...) {
+            failed = std::current_exception();
+          }
+          coalescer->complete(key, std::move(shared), failed);
+        });
+      };
+      try {
+        request_json_async(request_url, endpoint, cached ? cached->conditions() : std::list<std::string>(), complete);
+      } catch(...) {
+        flights->complete(key, nullptr, std::current_exception());
+      }
+      return result;
+    }
+
+    /// Performs a request for a JSON array and hands the text of each element to element as soon as it has arrived.
+    /** The body is never held as a whole, only the chunk being received and an element split across chunks. Failures
+     *  worth retrying are retried as the options allow, but only while no element has been handed out yet. Nothing
+     *  is left of the response afterwards, so it is neither shared with identical requests nor kept for revalidation.
+     *  @param request_url the url of the request to be made.
+     *  @param endpoint the group of endpoints the url belongs to, which selects the timeout.
+     *  @param element the callable receiving each element, an exception it throws aborts the transfer and is rethrown.
+     */
+    void request_stream(const std::string& request_url, const Endpoint& endpoint, const ArrayStream::Element& element) const;
+
+    /// Performs a request and hands each row of the response to each as soon as it has arrived and been read.
+    /** Every row reads each field it is asked for or fails, so one row is read into over and over, and the strings
+     *  of the row keep their capacity from one row to the next.
+     *  @param request_url the url of the request to be made.
+     *  @param endpoint the group of endpoints the url belongs to, which selects the timeout.
+     *  @param read_row a callable taking a JsonReader positioned on a row and the row to read it into.
+     *  @param each the callback receiving every row, the row is only valid until it returns.
+     */
+    template <typename Row, typename ReadRow>
+    void for_each_row(const std::string& request_url, const Endpoint& endpoint, ReadRow read_row,
+                      const std::function<void(const Row&)>& each) const
+    {
+      Row row{};
+      request_stream(request_url, endpoint, [&row, &read_row, &each](std::string_view element) {
+        JsonReader reader(element);
+        read_row(reader, row);
+        reader.finish();
+        each(row);
+      });
+    }
+
+    /// Builds the request URL for the "get recent observations in a region" request.
+    std::string recent_observations_in_region_url(const std::string& regionCode, const DataOptionalParameters& params) const;
+
+    /// Builds the request URL shared by the simple and detailed "get recent notable observations in a region" requests.
+    /** @param regionCode any eBird locId or subnational2 code, or ISO/eBird subnational1 or country code.
      *  @param params an optional DataOptionalParameters object with any desired optional parameters set.
      *  @param detailed a bool that should be set to true if the detail format of a request is needed and false otherwise.
-     *  @return the json of the resulting get recent notable observations in a region request.
+     *  @return the url of the get recent notable observations in a region request.
      */
-    nlohmann::json get_recent_notable_setup(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS, bool detailed=false) const;
+    std::string recent_notable_url(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS, bool detailed=false) const;
 
-    
-    /// Performs the common setup between the get recent nearby notable observations in a region requests.
-    /** There is a simple and detailed variation of the get recent nearby notable observations request. Both require basically
-     *  the same setup up to processing the resulting JSON. This method performs that setup.
-     *  @param lat a double representing the latitude for "nearby" requests.
+    /// Builds the request URL for the "get recent observations of a species in a region" request.
+    std::string recent_observations_of_species_in_region_url(const std::string& regionCode, const std::string& speciesCode, const DataOptionalParameters& params) const;
+
+    /// Builds the request URL for the "get recent nearby observations" request.
+    std::string recent_nearby_observations_url(double lat, double lng, const DataOptionalParameters& params) const;
+
+    /// Builds the request URL shared by the simple and detailed "get recent nearby notable observations" requests.
+    /** @param lat a double representing the latitude for "nearby" requests.
      *  @param lng a double representing the longitude for "nearby" requests.
      *  @param params an optional DataOptionalParameters object with any desired optional parameters set.
      *  @param detailed a bool that should be set to true if the detail format of a request is needed and false otherwise.
-     *  @return the json of the resulting get recent notable observations in a region request.
+     *  @return the url of the get recent nearby notable observations request.
      */
-    nlohmann::json get_recent_nearby_notable_setup(double lat, double lng, const DataOptionalParameters& params, bool detailed=false) const;
+    std::string recent_nearby_notable_url(double lat, double lng, const DataOptionalParameters& params, bool detailed=false) const;
+
+    /// Builds the request URL for the "get recent nearby observations of a species" request.
+    std::string recent_nearby_observations_of_species_url(const std::string& speciesCode, double lat, double lng, const DataOptionalParameters& params) const;
+
+    /// Builds the request URL for the "get nearest observations of a species" request.
+    std::string nearest_observations_of_species_url(const std::string& speciesCode, double lat, double lng, const DataOptionalParameters& params) const;
 
-    /// Performs the common setup between the get historic observations on a date request.
-    /** There is a simple and detailed variation of the get historic observations on a date request. Both require basically
-     *  the same setup up to processing the resulting JSON. This method performs that setup.
-     *  @param regionCode any eBird locId or subnational2 code, or ISO/eBird subnational1 or country code.
+    /// Builds the request URL shared by the simple and detailed "get historic observations on a date" requests.
+    /** @param regionCode any eBird locId or subnational2 code, or ISO/eBird subnational1 or country code.
      *  @param year, the year
      *  @param month, the month
      *  @param day, the day
      *  @param params an optional DataOptionalParameters object with any desired optional parameters set.
      *  @param detailed a bool that should be set to true if the detail format of a request is needed and false otherwise.
-     *  @return the json of the resulting get recent notable observations in a region request.
+     *  @return the url of the get historic observations on a date request.
      */
-    nlohmann::json get_historic_observations_on_date_setup(const std::string& regionCode, int year, int month, int day, const DataOptionalParameters& params, bool detailed=false) const;
+    std::string historic_observations_on_date_url(const std::string& regionCode, int year, int month, int day, const DataOptionalParameters& params, bool detailed=false) const;
+
+    /// Builds the request URL for the "get top 100" request.
+    std::string top_100_url(const std::string& regionCode, int year, int month, int day, bool checklistSort, unsigned int maxResults) const;
+
+    /// Builds the request URL for the "get checklist feed on a date" request.
+    std::string checklist_feed_on_date_url(const std::string& regionCode, int year, int month, int day, SortType sortKey, unsigned int maxResults) const;
+
+    /// Builds the request URL for the "get recent checklists feed" request.
+    std::string recent_checklists_feed_url(const std::string& regionCode, unsigned int maxResults) const;
+
+    /// Builds the request URL for the "get regional statistics on a date" request.
+    std::string regional_statistics_on_date_url(const std::string& regionCode, unsigned int year, unsigned int month, unsigned int day) const;
 
   public:
-    /** The only available constructor, takes an api key as a string.
+    /** Constructs a Requester with the default RequesterOptions, takes an api key as a string.
      *  @param key the api key the requester will use to formulate requests.
      */
-    Requester(const std::string& key)
-    {
-      api_key = key;
-    }
+    Requester(const std::string& key);
+
+    /** Constructs a Requester that uses the given options instead of the defaults.
+     *  @param key the api key the requester will use to formulate requests.
+     *  @param options a RequesterOptions object with any desired options set.
+     */
+    Requester(const std::string& key, const RequesterOptions& options);
+
+    /** Constructs a Requester that uses the connections, caches and options of a SharedContext.
+     *  Requesters on the same context can be used from different threads and skip the DNS lookup and TLS handshakes
+     *  the others already performed.
+     *  @param key the api key the requester will use to formulate requests.
+     *  @param context the SharedContext, the Requester and its copies keep it alive.
+     */
+    Requester(const std::string& key, std::shared_ptr<SharedContext> context);
+
+    /** Constructs a Requester that hands its requests to the given transport instead of libcurl, such as a
+     *  MemoryTransport serving canned responses.
+     *  @param key the api key the requester will use to formulate requests.
+     *  @param transport the transport performing the requests, the Requester and its copies keep it alive.
+     *  @param options a RequesterOptions object with any desired options set, the transport ignores the ones about
+     *  connections.
+     */
+    Requester(const std::string& key, std::shared_ptr<Transport> transport, const RequesterOptions& options=RequesterOptions());
+
+    /// The rate limiter the requests pass through, for reading the current rate, concurrency limit and in flight count.
+    const RateLimiter& rate_limiter() const;
+
+    /// Becomes ready once the connections the options ask to prewarm are open.
+    /** Waiting on it is optional, requests made before it is ready simply open connections of their own. It holds
+     *  TransferFailed if none of the connections could be opened, and is ready right away without prewarm.
+     *  Destroying the last copy of a Requester that is still warming up waits for the warm-up to end.
+     */
+    std::shared_future<void> ready() const;
+
+    /// Where identical requests in flight are coalesced, for reading how many calls were shared.
+    const SingleFlight& single_flight() const;
 
     /// Performs the "get recent observations in a region" request and returns the results.
     /** The only required argument is the region code as an eBird locId, subnational2 code, subnational1 code, or country code.
@@ -177,6 +528,70 @@ class Requester {
      */
     Observations get_recent_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
 
+    /// Asynchronous version of get_recent_observations_in_region, it takes the same arguments.
+    /** @return a future that holds the Observations, or the exception that stopped the request. */
+    std::future<Observations> async_get_recent_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Performs the "get recent observations in a region" request and returns the results as views into the response.
+    /** Takes the same arguments as get_recent_observations_in_region. The text fields of the rows point into the
+     *  response body, which the result keeps alive, so no text is copied. Convert a row to an Observation, or call
+     *  to_observations(), for copies that outlive the result.
+     *  @return any observations returned by the request are returned in an ObservationViews object.
+     */
+    ObservationViews view_recent_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Asynchronous version of view_recent_observations_in_region, it takes the same arguments.
+    /** @return a future that holds the ObservationViews, or the exception that stopped the request. */
+    std::future<ObservationViews> async_view_recent_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Performs the "get recent observations in a region" request and returns the results with their text interned.
+    /** Takes the same arguments as get_recent_observations_in_region. Every string is stored once in the Requester's
+     *  StringPool, shared with earlier results, and the rows hold pointer sized handles to it, so results kept for a
+     *  long time hold a single copy of each species, location and region name. Handles to the same text from the
+     *  same pool compare equal as pointers. The pool is replaced once it reaches RequesterOptions::string_pool().
+     *  @return any observations returned by the request are returned in an InternedObservations object.
+     */
+    InternedObservations intern_recent_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Asynchronous version of intern_recent_observations_in_region, it takes the same arguments.
+    /** @return a future that holds the InternedObservations, or the exception that stopped the request. */
+    std::future<InternedObservations> async_intern_recent_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Performs the "get recent observations in a region" request and returns the results in an arena.
+    /** Takes the same arguments as get_recent_observations_in_region. The rows and all of their text are allocated
+     *  from a monotonic arena owned by the result instead of one heap allocation per long string, so decoding
+     *  allocates a few large blocks and destroying the result releases them at once. Copies of the result share it.
+     *  @return any observations returned by the request are returned in an ArenaObservations object.
+     */
+    ArenaObservations arena_recent_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Asynchronous version of arena_recent_observations_in_region, it takes the same arguments.
+    /** @return a future that holds the ArenaObservations, or the exception that stopped the request. */
+    std::future<ArenaObservations> async_arena_recent_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Performs the "get recent observations in a region" request and decodes the results without throwing.
+    /** Takes the same arguments as get_recent_observations_in_region. A row that isn't JSON, holds a value of the wrong
+     *  type or lacks a required field is left out and recorded with its position and error, and the other rows are
+     *  kept, where the get_ version throws RequestFailed and loses them all. Errors of the request itself are thrown.
+     *  @return the observations that decoded and the failures of the others, in a Checked<Observations>.
+     */
+    Checked<Observations> checked_recent_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Asynchronous version of checked_recent_observations_in_region, it takes the same arguments.
+    /** @return a future that holds the Checked<Observations>, or the exception that stopped the request. */
+    std::future<Checked<Observations>> async_checked_recent_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Performs the "get recent observations in a region" request and hands each observation to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_recent_observations_in_region, with the callback after the region code. The
+     *  callback runs on the calling thread while the response is still being received, so the first rows are handled
+     *  before the last ones have arrived and only the row being read is ever held, however large the response is.
+     *  Failures worth retrying are retried as long as no row has been handed out yet. The response isn't shared with
+     *  identical requests or kept for revalidation.
+     *  @param each the callback receiving every observation in order, the observation is only valid until it returns.
+     *  An exception thrown by it aborts the transfer and is rethrown.
+     */
+    void for_each_recent_observations_in_region(const std::string& regionCode, const std::function<void(const Observation&)>& each, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
     /// Performs the "get recent notable observations in a region" request and returns the results.
     /** The only required argument is the region code as an eBird locId, subnational2 code, subnational1 code, or country code.
      *  @param regionCode a string containing either an eBird locId, subnational2 code, subnational1 code, or country code.
@@ -185,6 +600,16 @@ class Requester {
      */
     Observations get_recent_notable_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
 
+    /// Asynchronous version of get_recent_notable_observations_in_region, it takes the same arguments.
+    /** @return a future that holds the Observations, or the exception that stopped the request. */
+    std::future<Observations> async_get_recent_notable_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Streaming version of get_recent_notable_observations_in_region, each observation is handed to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_recent_notable_observations_in_region, with the callback after the required ones, and works like
+     *  for_each_recent_observations_in_region.
+     */
+    void for_each_recent_notable_observations_in_region(const std::string& regionCode, const std::function<void(const Observation&)>& each, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
     /// Performs the "get recent notable observations in a region" with the format parameter set to detail
     /** The only required argument is the region code as an eBird locId, subnational2 code, subnational1 code, or country code.
      *  @param regionCode a string containing either an eBird locId, subnational2 code, subnational1 code, or country code.
@@ -193,6 +618,49 @@ class Requester {
      */
     DetailedObservations get_detailed_recent_notable_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
 
+    /// Asynchronous version of get_detailed_recent_notable_observations_in_region, it takes the same arguments.
+    /** @return a future that holds the DetailedObservations, or the exception that stopped the request. */
+    std::future<DetailedObservations> async_get_detailed_recent_notable_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Performs the detailed "get recent notable observations in a region" request with the text of the results interned.
+    /** Takes the same arguments as get_detailed_recent_notable_observations_in_region, the rows hold handles to text
+     *  stored once in the Requester's StringPool like those of intern_recent_observations_in_region.
+     *  @return any observations returned by the request are returned in an InternedDetailedObservations object.
+     */
+    InternedDetailedObservations intern_detailed_recent_notable_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Asynchronous version of intern_detailed_recent_notable_observations_in_region, it takes the same arguments.
+    /** @return a future that holds the InternedDetailedObservations, or the exception that stopped the request. */
+    std::future<InternedDetailedObservations> async_intern_detailed_recent_notable_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Performs the detailed "get recent notable observations in a region" request and returns the results in an arena.
+    /** Takes the same arguments as get_detailed_recent_notable_observations_in_region, the rows and their text are
+     *  allocated from an arena owned by the result like those of arena_recent_observations_in_region.
+     *  @return any observations returned by the request are returned in an ArenaDetailedObservations object.
+     */
+    ArenaDetailedObservations arena_detailed_recent_notable_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Asynchronous version of arena_detailed_recent_notable_observations_in_region, it takes the same arguments.
+    /** @return a future that holds the ArenaDetailedObservations, or the exception that stopped the request. */
+    std::future<ArenaDetailedObservations> async_arena_detailed_recent_notable_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Performs the detailed "get recent notable observations in a region" request and decodes the results without throwing.
+    /** Takes the same arguments as get_detailed_recent_notable_observations_in_region, bad rows are left out and
+     *  recorded like by checked_recent_observations_in_region.
+     *  @return the observations that decoded and the failures of the others, in a Checked<DetailedObservations>.
+     */
+    Checked<DetailedObservations> checked_detailed_recent_notable_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Asynchronous version of checked_detailed_recent_notable_observations_in_region, it takes the same arguments.
+    /** @return a future that holds the Checked<DetailedObservations>, or the exception that stopped the request. */
+    std::future<Checked<DetailedObservations>> async_checked_detailed_recent_notable_observations_in_region(const std::string& regionCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Streaming version of get_detailed_recent_notable_observations_in_region, each observation is handed to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_detailed_recent_notable_observations_in_region, with the callback after the required ones, and works like
+     *  for_each_recent_observations_in_region.
+     */
+    void for_each_detailed_recent_notable_observations_in_region(const std::string& regionCode, const std::function<void(const DetailedObservation&)>& each, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
     /// Performs the "get recent observations of a species in a region" request and returns the results.
     /** The required arguments are the region code as an eBird locId, subnational2 code, subnational1 code, or country code
      *  and a species code in the current eBird taxonomy.
@@ -202,6 +670,16 @@ class Requester {
      *  @return any observations returned by the request are returned in an Observations object.
      */
     Observations get_recent_observations_of_species_in_region(const std::string& regionCode, const std::string& speciesCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Asynchronous version of get_recent_observations_of_species_in_region, it takes the same arguments.
+    /** @return a future that holds the Observations, or the exception that stopped the request. */
+    std::future<Observations> async_get_recent_observations_of_species_in_region(const std::string& regionCode, const std::string& speciesCode, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Streaming version of get_recent_observations_of_species_in_region, each observation is handed to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_recent_observations_of_species_in_region, with the callback after the required ones, and works like
+     *  for_each_recent_observations_in_region.
+     */
+    void for_each_recent_observations_of_species_in_region(const std::string& regionCode, const std::string& speciesCode, const std::function<void(const Observation&)>& each, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
      
     /// Performs the "get recent nearby observations" request and returns the results.
     /** The required arguments are the latitude and longitude of the area to check nearby.
@@ -212,6 +690,16 @@ class Requester {
      */
     Observations get_recent_nearby_observations(double lat, double lng, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
 
+    /// Asynchronous version of get_recent_nearby_observations, it takes the same arguments.
+    /** @return a future that holds the Observations, or the exception that stopped the request. */
+    std::future<Observations> async_get_recent_nearby_observations(double lat, double lng, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Streaming version of get_recent_nearby_observations, each observation is handed to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_recent_nearby_observations, with the callback after the required ones, and works like
+     *  for_each_recent_observations_in_region.
+     */
+    void for_each_recent_nearby_observations(double lat, double lng, const std::function<void(const Observation&)>& each, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
     /// Performs the "get recent nearby notable observations" request and returns the results.
     /** The required arguments are the latitude and longitude of the area to check nearby.
      *  @param lat the latitude of the target area as a double in the range [-90.0, 90.0], precision will be truncated/extended to 6 digits.
@@ -221,6 +709,16 @@ class Requester {
      */
     Observations get_recent_nearby_notable_observations(double lat, double lng, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
 
+    /// Asynchronous version of get_recent_nearby_notable_observations, it takes the same arguments.
+    /** @return a future that holds the Observations, or the exception that stopped the request. */
+    std::future<Observations> async_get_recent_nearby_notable_observations(double lat, double lng, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Streaming version of get_recent_nearby_notable_observations, each observation is handed to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_recent_nearby_notable_observations, with the callback after the required ones, and works like
+     *  for_each_recent_observations_in_region.
+     */
+    void for_each_recent_nearby_notable_observations(double lat, double lng, const std::function<void(const Observation&)>& each, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
     /// Performs the "get recent nearby notable observations" request with the format parameter set to detail.
     /** The required arguments are the latitude and longitude of the area to check nearby.
      *  @param lat the latitude of the target area as a double in the range [-90.0, 90.0], precision will be truncated/extended to 6 digits.
@@ -230,6 +728,16 @@ class Requester {
      */
     DetailedObservations get_detailed_recent_nearby_notable_observations(double lat, double lng, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
 
+    /// Asynchronous version of get_detailed_recent_nearby_notable_observations, it takes the same arguments.
+    /** @return a future that holds the DetailedObservations, or the exception that stopped the request. */
+    std::future<DetailedObservations> async_get_detailed_recent_nearby_notable_observations(double lat, double lng, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Streaming version of get_detailed_recent_nearby_notable_observations, each observation is handed to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_detailed_recent_nearby_notable_observations, with the callback after the required ones, and works like
+     *  for_each_recent_observations_in_region.
+     */
+    void for_each_detailed_recent_nearby_notable_observations(double lat, double lng, const std::function<void(const DetailedObservation&)>& each, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
     /// Performs the "get recent nearby observations of a species" request and returns the results.
     /** The required arguments are a species code in the current eBird taxonomy, and the latitude and longitude of the area to check nearby.
      *  @param speciesCode a string containing a species code in the current eBird taxonomy.
@@ -240,6 +748,16 @@ class Requester {
      */ 
     Observations get_recent_nearby_observations_of_species(const std::string& speciesCode, double lat, double lng, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
 
+    /// Asynchronous version of get_recent_nearby_observations_of_species, it takes the same arguments.
+    /** @return a future that holds the Observations, or the exception that stopped the request. */
+    std::future<Observations> async_get_recent_nearby_observations_of_species(const std::string& speciesCode, double lat, double lng, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Streaming version of get_recent_nearby_observations_of_species, each observation is handed to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_recent_nearby_observations_of_species, with the callback after the required ones, and works like
+     *  for_each_recent_observations_in_region.
+     */
+    void for_each_recent_nearby_observations_of_species(const std::string& speciesCode, double lat, double lng, const std::function<void(const Observation&)>& each, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
     /// Performs the "get nearest observations of a species" request and returns the results.
     /** The required arguments are a species code in the current eBird taxonomy, and the latitude and longitude of the area to check nearby.
      *  @param speciesCode a string containing a species code in the current eBird taxonomy.
@@ -250,6 +768,16 @@ class Requester {
      */
     Observations get_nearest_observations_of_species(const std::string& speciesCode, double lat, double lng, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
 
+    /// Asynchronous version of get_nearest_observations_of_species, it takes the same arguments.
+    /** @return a future that holds the Observations, or the exception that stopped the request. */
+    std::future<Observations> async_get_nearest_observations_of_species(const std::string& speciesCode, double lat, double lng, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Streaming version of get_nearest_observations_of_species, each observation is handed to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_nearest_observations_of_species, with the callback after the required ones, and works like
+     *  for_each_recent_observations_in_region.
+     */
+    void for_each_nearest_observations_of_species(const std::string& speciesCode, double lat, double lng, const std::function<void(const Observation&)>& each, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
     /// Performs the "get historic observations on a date" request and returns the results.
     /** The required arguments are a region code as an eBird locId, subnational2 code, subnational1 code, or country code
      *  and the year, month, and day of the desired date.
@@ -262,6 +790,16 @@ class Requester {
      */
     Observations get_historic_observations_on_date(const std::string& regionCode, int year, int month, int day, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
 
+    /// Asynchronous version of get_historic_observations_on_date, it takes the same arguments.
+    /** @return a future that holds the Observations, or the exception that stopped the request. */
+    std::future<Observations> async_get_historic_observations_on_date(const std::string& regionCode, int year, int month, int day, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Streaming version of get_historic_observations_on_date, each observation is handed to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_historic_observations_on_date, with the callback after the required ones, and works like
+     *  for_each_recent_observations_in_region.
+     */
+    void for_each_historic_observations_on_date(const std::string& regionCode, int year, int month, int day, const std::function<void(const Observation&)>& each, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
     /// Performs the "get historic observations on a date" request with the format argument set to detail and returns the results.
     /** The required arguments are a region code as an eBird locId, subnational2 code, subnational1 code, or country code
      *  and the year, month, and day of the desired date.
@@ -274,6 +812,16 @@ class Requester {
      */
     DetailedObservations get_detailed_historic_observations_on_date(const std::string& regionCode, int year, int month, int day, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
 
+    /// Asynchronous version of get_detailed_historic_observations_on_date, it takes the same arguments.
+    /** @return a future that holds the DetailedObservations, or the exception that stopped the request. */
+    std::future<DetailedObservations> async_get_detailed_historic_observations_on_date(const std::string& regionCode, int year, int month, int day, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
+    /// Streaming version of get_detailed_historic_observations_on_date, each observation is handed to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_detailed_historic_observations_on_date, with the callback after the required ones, and works like
+     *  for_each_recent_observations_in_region.
+     */
+    void for_each_detailed_historic_observations_on_date(const std::string& regionCode, int year, int month, int day, const std::function<void(const DetailedObservation&)>& each, const DataOptionalParameters& params=DATA_DEFAULT_PARAMS) const;
+
     /// Performs the "get top 100" request and returns the results.
     /** The required arguments are a region code as an eBird locId, subnational2 code, subnational1 code, or country code
      *  and the year, month, and day of the desired date.
@@ -287,6 +835,10 @@ class Requester {
      */
     Top100 get_top_100(const std::string& regionCode, int year, int month, int day, bool checklistSort=false, unsigned int maxResults=100) const;
 
+    /// Asynchronous version of get_top_100, it takes the same arguments.
+    /** @return a future that holds the Top100, or the exception that stopped the request. */
+    std::future<Top100> async_get_top_100(const std::string& regionCode, int year, int month, int day, bool checklistSort=false, unsigned int maxResults=100) const;
+
     /// Performs the "get top 100" request and returns the results.
     /** The required arguments are a region code as an eBird locId, subnational2 code, subnational1 code, or country code
      *  and the year, month, and day of the desired date.
@@ -299,6 +851,21 @@ class Requester {
      */
     Top100 get_top_100(const std::string& regionCode, int year, int month, int day, unsigned int maxResults) const;
 
+    /// Asynchronous version of get_top_100, it takes the same arguments.
+    /** @return a future that holds the Top100, or the exception that stopped the request. */
+    std::future<Top100> async_get_top_100(const std::string& regionCode, int year, int month, int day, unsigned int maxResults) const;
+
+    /// Performs the "get top 100" request and returns the results in an arena.
+    /** Takes the same arguments as get_top_100, the rows and their text are allocated from an arena owned by the
+     *  result like those of arena_recent_observations_in_region.
+     *  @returns a collection of the results as an ArenaTop100 object.
+     */
+    ArenaTop100 arena_top_100(const std::string& regionCode, int year, int month, int day, bool checklistSort=false, unsigned int maxResults=100) const;
+
+    /// Asynchronous version of arena_top_100, it takes the same arguments.
+    /** @return a future that holds the ArenaTop100, or the exception that stopped the request. */
+    std::future<ArenaTop100> async_arena_top_100(const std::string& regionCode, int year, int month, int day, bool checklistSort=false, unsigned int maxResults=100) const;
+
     /// Performs the "get checklist feed on a date" request and returns the result.
     /** The required arguments are a region code as an eBird locId, subnational2 code, subnational1 code, or country code
      *  and the year, month, and day of the desired date.
@@ -312,6 +879,38 @@ class Requester {
      */
     Checklists get_checklist_feed_on_date(const std::string& regionCode, int year, int month, int day, SortType sortKey=SortType::obs_dt, unsigned int maxResults=10);
 
+    /// Asynchronous version of get_checklist_feed_on_date, it takes the same arguments.
+    /** @return a future that holds the Checklists, or the exception that stopped the request. */
+    std::future<Checklists> async_get_checklist_feed_on_date(const std::string& regionCode, int year, int month, int day, SortType sortKey=SortType::obs_dt, unsigned int maxResults=10) const;
+
+    /// Performs the "get checklist feed on a date" request and returns the results in an arena.
+    /** Takes the same arguments as get_checklist_feed_on_date, the rows and their text are allocated from an arena
+     *  owned by the result like those of arena_recent_observations_in_region.
+     *  @return a collection of the results as an ArenaChecklists object.
+     */
+    ArenaChecklists arena_checklist_feed_on_date(const std::string& regionCode, int year, int month, int day, SortType sortKey=SortType::obs_dt, unsigned int maxResults=10) const;
+
+    /// Asynchronous version of arena_checklist_feed_on_date, it takes the same arguments.
+    /** @return a future that holds the ArenaChecklists, or the exception that stopped the request. */
+    std::future<ArenaChecklists> async_arena_checklist_feed_on_date(const std::string& regionCode, int year, int month, int day, SortType sortKey=SortType::obs_dt, unsigned int maxResults=10) const;
+
+    /// Performs the "get checklist feed on a date" request and decodes the results without throwing.
+    /** Takes the same arguments as get_checklist_feed_on_date, bad rows are left out and recorded like by
+     *  checked_recent_observations_in_region.
+     *  @return the checklists that decoded and the failures of the others, in a Checked<Checklists>.
+     */
+    Checked<Checklists> checked_checklist_feed_on_date(const std::string& regionCode, int year, int month, int day, SortType sortKey=SortType::obs_dt, unsigned int maxResults=10) const;
+
+    /// Asynchronous version of checked_checklist_feed_on_date, it takes the same arguments.
+    /** @return a future that holds the Checked<Checklists>, or the exception that stopped the request. */
+    std::future<Checked<Checklists>> async_checked_checklist_feed_on_date(const std::string& regionCode, int year, int month, int day, SortType sortKey=SortType::obs_dt, unsigned int maxResults=10) const;
+
+    /// Streaming version of get_checklist_feed_on_date, each checklist is handed to a callback as soon as it has arrived.
+    /** Takes the same arguments as get_checklist_feed_on_date, with the callback after the date, and works like
+     *  for_each_recent_observations_in_region.
+     */
+    void for_each_checklist_feed_on_date(const std::string& regionCode, int year, int month, int day, const std::function<void(const Checklist&)>& each, SortType sortKey=SortType::obs_dt, unsigned int maxResults=10) const;
+
     /// Performs the "get checklist feed on a date" request and returns the result.
     /** The required arguments are a region code as an eBird locId, subnational2 code, subnational1 code, or country code
      *  and the year, month, and day of the desired date.
@@ -324,6 +923,13 @@ class Requester {
      */
     Checklists get_checklist_feed_on_date(const std::string& regionCode, int year, int month, int day, unsigned int maxResults);
 
+    /// Asynchronous version of get_checklist_feed_on_date, it takes the same arguments.
+    /** @return a future that holds the Checklists, or the exception that stopped the request. */
+    std::future<Checklists> async_get_checklist_feed_on_date(const std::string& regionCode, int year, int month, int day, unsigned int maxResults) const;
+
+    /// Streaming version of get_checklist_feed_on_date, it takes the same arguments with the callback after the date.
+    void for_each_checklist_feed_on_date(const std::string& regionCode, int year, int month, int day, const std::function<void(const Checklist&)>& each, unsigned int maxResults) const;
+
     /// Performs the "get recent checklists feed" request and returns the results.
     /** The only required argument is the region code as an eBird locId, subnational2 code, subnational1 code, or country code.
      *  @param regionCode a string containing either an eBird locId, subnational2 code, subnational1 code, or country code.
@@ -332,6 +938,13 @@ class Requester {
      */
     Checklists get_recent_checklists_feed(const std::string& regionCode, unsigned int maxResults=10);
 
+    /// Asynchronous version of get_recent_checklists_feed, it takes the same arguments.
+    /** @return a future that holds the Checklists, or the exception that stopped the request. */
+    std::future<Checklists> async_get_recent_checklists_feed(const std::string& regionCode, unsigned int maxResults=10) const;
+
+    /// Streaming version of get_recent_checklists_feed, it takes the same arguments with the callback after the region code.
+    void for_each_recent_checklists_feed(const std::string& regionCode, const std::function<void(const Checklist&)>& each, unsigned int maxResults=10) const;
+
     /// Performs the "get regional statistics on a date" request and returns the results.
     /** The required arguments are a region code as an eBird locId, subnational2 code, subnational1 code, or country code
      *  and the year, month, and day of the desired date.
@@ -344,6 +957,10 @@ class Requester {
      */
     RegionalStats get_regional_statistics_on_date(const std::string& regionCode, unsigned int year, unsigned int month, unsigned int day);
 
+    /// Asynchronous version of get_regional_statistics_on_date, it takes the same arguments.
+    /** @return a future that holds the RegionalStats, or the exception that stopped the request. */
+    std::future<RegionalStats> async_get_regional_statistics_on_date(const std::string& regionCode, unsigned int year, unsigned int month, unsigned int day) const;
+
 };
 
 class RequestFailed: public std::exception
@@ -357,6 +974,78 @@ class RequestFailed: public std::exception
     }
 };
 
+/// Thrown when the transfer itself failed, for example because it timed out or the connection broke.
+class TransferFailed: public RequestFailed
+{
+  public:
+    TransferFailed() = default;
+
+    virtual const char* what() const throw()
+    {
+      return "The request to the API timed out or could not be completed";
+    }
+};
+
+/// Thrown when a transfer was cut off because the engine performing it shut down, it is not worth retrying.
+class TransferAborted: public RequestFailed
+{
+  public:
+    TransferAborted() = default;
+
+    virtual const char* what() const throw()
+    {
+      return "The request to the API was aborted because its Requester was shut down";
+    }
+};
+
+/// Thrown when the API answers with an HTTP error status, the body is not parsed.
+class HttpError: public RequestFailed
+{
+  private:
+    long status_code;
+
+  public:
+    explicit HttpError(long status_code) : status_code(status_code) {}
+
+    /// The HTTP status code of the response.
+    long status() const { return status_code; }
+
+    virtual const char* what() const throw()
+    {
+      return "The API responded with an HTTP error status";
+    }
+};
+
+/// Thrown for a 400 response, the API rejected one of the arguments.
+class BadRequest: public HttpError
+{
+  public:
+    BadRequest() : HttpError(400) {}
+
+    virtual const char* what() const throw()
+    {
+      return "The API rejected the request as invalid (400), an argument isn't valid";
+    }
+};
+
+/// Thrown for a 429 response, too many requests were made with the API key.
+class RateLimited: public HttpError
+{
+  private:
+    long retry_seconds;
+
+  public:
+    explicit RateLimited(long retry_after) : HttpError(429), retry_seconds(retry_after) {}
+
+    /// The seconds the API asked to wait before retrying, 0 if it didn't say.
+    long retry_after() const { return retry_seconds; }
+
+    virtual const char* what() const throw()
+    {
+      return "The API is rate limiting requests with this key (429)";
+    }
+};
+
 }
 
 #endif
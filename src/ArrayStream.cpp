@@ -0,0 +1,92 @@
+#include "../include/cbirdpp/ArrayStream.h"
+#include "../include/cbirdpp/cbirdpp.h"
+
+#include <string_view>
+using std::string_view;
+
+namespace cbirdpp
+{
+
+  static bool whitespace(char c)
+  {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+  }
+
+  bool ArrayStream::feed(string_view chunk, const Element& element)
+  {
+    std::size_t start = 0;      // Where the current element starts in this chunk, it may have started in an earlier one.
+    std::size_t i = 0;
+    while(i < chunk.size()) {
+      switch(state) {
+        case before_array:
+        case after_array:
+          if(!whitespace(chunk[i])) {
+            if(state == after_array || chunk[i] != '[') {
+              state = malformed;
+              partial.clear();
+              return false;
+            }
+            state = first_element;
+          }
+          ++i;
+          break;
+        case first_element:
+        case next_element:
+          if(whitespace(chunk[i])) {
+            ++i;
+          } else if(chunk[i] == ']' && state == first_element) {
+            state = after_array;
+            ++i;
+          } else {
+            // A separator here gives an empty element, which its reader rejects.
+            state = in_element;
+            start = i;
+          }
+          break;
+        case in_element: {
+          for(; i < chunk.size(); ++i) {
+            char c = chunk[i];
+            if(escaped) {
+              escaped = false;
+            } else if(in_string) {
+              escaped = c == '\\';
+              in_string = c != '"';
+            } else if(c == '"') {
+              in_string = true;
+            } else if(c == '[' || c == '{') {
+              ++depth;
+            } else if(depth > 0 && (c == ']' || c == '}')) {
+              --depth;
+            } else if(depth == 0 && (c == ',' || c == ']')) {
+              break;
+            }
+          }
+          if(i == chunk.size()) {
+            partial.append(chunk.substr(start));
+            break;
+          }
+          string_view text = chunk.substr(start, i - start);
+          if(!partial.empty()) {
+            partial.append(text);
+            text = partial;
+          }
+          ++handed_out;
+          element(text);
+          partial.clear();
+          state = chunk[i] == ']' ? after_array : next_element;
+          ++i;
+          break;
+        }
+        case malformed:
+          return false;
+      }
+    }
+    return state != malformed;
+  }
+
+  void ArrayStream::finish() const
+  {
+    if(!complete()) {throw RequestFailed();}
+  }
+
+}
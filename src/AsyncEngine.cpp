@@ -0,0 +1,224 @@
+#include "../include/cbirdpp/AsyncEngine.h"
+#include "../include/cbirdpp/cbirdpp.h"
+
+#include <curlpp/cURLpp.hpp>
+#include <curlpp/Easy.hpp>
+#include <curlpp/Options.hpp>
+
+#include <algorithm>
+using std::min;
+
+#include <exception>
+using std::exception_ptr;
+using std::make_exception_ptr;
+
+#include <list>
+using std::list;
+
+#include <memory>
+using std::unique_ptr;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <utility>
+using std::move;
+
+#include <vector>
+using std::vector;
+
+namespace cbirdpp
+{
+
+  // Upper bound on how long the loop sleeps in curl_multi_poll, submissions and shutdown wake it up earlier.
+  const int POLL_TIMEOUT_MS = 1000;
+
+  // How often the loop checks for a free slot while the rate limiter's concurrency limit is reached.
+  const int SLOT_POLL_MS = 10;
+
+  // Easy handles kept for reuse between bursts of transfers.
+  const std::size_t MAX_IDLE_HANDLES = 64;
+
+  AsyncEngine::AsyncEngine(const RequesterOptions& options/*=RequesterOptions()*/, CURLSH* share/*=nullptr*/,
+                           std::shared_ptr<RateLimiter> limiter/*=nullptr*/)
+    : multi(curl_multi_init()), handles(MAX_IDLE_HANDLES, options, share), limiter(move(limiter))
+  {
+    if(options.multiplexed()) {
+      curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+      curl_multi_setopt(multi, CURLMOPT_MAX_CONCURRENT_STREAMS, static_cast<long>(options.max_concurrent_streams()));
+    }
+    if(options.max_host_connections() > 0) {
+      curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(options.max_host_connections()));
+    }
+  }
+
+  AsyncEngine::~AsyncEngine()
+  {
+    {
+      // Taken so a submit() either queues its transfer before the loop drains the queue, or sees the engine stopping.
+      lock_guard<mutex> lock(queue_mutex);
+      stopping = true;
+    }
+    curl_multi_wakeup(multi);
+    if(loop.joinable()) {
+      loop.join();
+    }
+    curl_multi_cleanup(multi);
+  }
+
+  void AsyncEngine::submit(const string& request_url, const list<string>& headers, Completion done)
+  {
+    Request request;
+    request.url = request_url;
+    request.headers = headers;
+    submit(request, move(done));
+  }
+
+  void AsyncEngine::submit(const Request& request, Completion done)
+  {
+    auto transfer = std::make_unique<Transfer>(Transfer{handles.acquire(), move(done), RateLimiter::Ticket(),
+                                                        request.wanted});
+    transfer->handle->setOpt(cURLpp::Options::Url(request.url));
+    transfer->handle->setOpt(cURLpp::Options::HttpHeader(request.headers));
+    // Always set, so a timeout doesn't linger on the pooled handle for the next request.
+    transfer->handle->setOpt(cURLpp::Options::TimeoutMs(static_cast<long>(request.timeout.count())));
+    transfer->handle->setOpt(cURLpp::Options::NoBody(request.headers_only));
+    transfer->handle.buffer().attach(*transfer->handle);
+    ++pending;
+    {
+      lock_guard<mutex> lock(queue_mutex);
+      if(!stopping) {
+        if(request.delay.count() > 0) {
+          delayed.emplace(Clock::now() + request.delay, move(transfer));
+        } else {
+          queued.push_back(move(transfer));
+        }
+        if(!loop.joinable()) {
+          loop = std::thread([this] { run(); });
+        }
+        curl_multi_wakeup(multi);
+        return;
+      }
+    }
+    // Shutting down, the queue is not drained anymore. Completed outside the lock, as the completion may submit again.
+    abandon(move(transfer));
+  }
+
+  std::size_t AsyncEngine::in_flight() const
+  {
+    return pending;
+  }
+
+  void AsyncEngine::run()
+  {
+    while(!stopping) {
+      int timeout = start_queued();
+      int running = 0;
+      curl_multi_perform(multi, &running);
+      int remaining = 0;
+      while(CURLMsg* message = curl_multi_info_read(multi, &remaining)) {
+        if(message->msg == CURLMSG_DONE) {
+          finish(message->easy_handle, message->data.result);
+        }
+      }
+      curl_multi_poll(multi, nullptr, 0, timeout, nullptr);
+    }
+
+    // Shutting down, everything still outstanding fails without waiting for the limiter or a delay.
+    vector<unique_ptr<Transfer>> outstanding;
+    {
+      lock_guard<mutex> lock(queue_mutex);
+      for(unique_ptr<Transfer>& transfer : queued) {outstanding.push_back(move(transfer));}
+      for(auto& entry : delayed) {outstanding.push_back(move(entry.second));}
+      queued.clear();
+      delayed.clear();
+    }
+    for(unique_ptr<Transfer>& transfer : outstanding) {
+      abandon(move(transfer));
+    }
+    while(!active.empty()) {
+      finish(active.begin()->first, CURLE_ABORTED_BY_CALLBACK);
+    }
+  }
+
+  int AsyncEngine::start_queued()
+  {
+    int timeout = POLL_TIMEOUT_MS;
+    vector<unique_ptr<Transfer>> dropped;
+    {
+      lock_guard<mutex> lock(queue_mutex);
+      Clock::time_point now = Clock::now();
+      while(!delayed.empty() && delayed.begin()->first <= now) {
+        unique_ptr<Transfer> transfer = move(delayed.begin()->second);
+        delayed.erase(delayed.begin());
+        if(transfer->wanted && !transfer->wanted()) {
+          dropped.push_back(move(transfer));
+        } else {
+          queued.push_back(move(transfer));
+        }
+      }
+      if(!delayed.empty()) {
+        auto due = std::chrono::ceil<std::chrono::milliseconds>(delayed.begin()->first - now).count();
+        timeout = static_cast<int>(min<decltype(due)>(due, timeout));
+      }
+
+      while(!queued.empty()) {
+        unique_ptr<Transfer>& transfer = queued.front();
+        if(limiter && !limiter->try_acquire(transfer->ticket)) {
+          // Waiting for a token has a known end. A full slot is freed by a finishing transfer, which wakes the loop
+          // anyway, or by a blocking request on another thread, which doesn't.
+          int wait = static_cast<int>(limiter->next_available().count());
+          timeout = min(timeout, wait > 0 ? wait : SLOT_POLL_MS);
+          break;
+        }
+        CURL* easy = transfer->handle->getHandle();
+        curl_multi_add_handle(multi, easy);
+        active[easy] = move(transfer);
+        queued.pop_front();
+      }
+    }
+    for(unique_ptr<Transfer>& transfer : dropped) {
+      abandon(move(transfer));
+    }
+    return timeout;
+  }
+
+  void AsyncEngine::abandon(unique_ptr<Transfer> transfer)
+  {
+    --pending;
+    try {
+      exception_ptr error = stopping ? make_exception_ptr(TransferAborted()) : make_exception_ptr(RequestFailed());
+      transfer->done(transfer->handle.buffer(), error);
+    } catch(...) {
+      // Same as in finish(), the loop keeps running.
+    }
+  }
+
+  void AsyncEngine::finish(CURL* easy, CURLcode result)
+  {
+    auto found = active.find(easy);
+    if(found == active.end()) {return;}
+    unique_ptr<Transfer> transfer = move(found->second);
+    active.erase(found);
+    curl_multi_remove_handle(multi, easy);
+    --pending;
+
+    exception_ptr error;
+    if(result != CURLE_OK) {
+      // Transfers cut off by the shutdown must not be retried, the transport submitting the retry may be going away.
+      error = stopping ? make_exception_ptr(TransferAborted()) : make_exception_ptr(TransferFailed());
+    } else {
+      transfer->ticket.complete(transfer->handle.buffer().status(), transfer->handle.buffer().retry_after());
+    }
+    try {
+      transfer->done(transfer->handle.buffer(), error);
+    } catch(...) {
+      // A throwing callback must not take the event loop down with it.
+    }
+  }
+
+}
@@ -0,0 +1,92 @@
+#include "../include/cbirdpp/ConnectionPool.h"
+
+#include <curlpp/cURLpp.hpp>
+#include <curlpp/Easy.hpp>
+#include <curlpp/Options.hpp>
+
+#include <memory>
+using std::unique_ptr;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+
+#include <string>
+
+#include <utility>
+using std::move;
+
+namespace cbirdpp
+{
+
+  // Seconds a connection may sit idle before TCP keep-alive probes start, and the interval between probes.
+  const long KEEPALIVE_IDLE = 60;
+  const long KEEPALIVE_INTERVAL = 30;
+
+  ConnectionPool::Lease::Lease(ConnectionPool* owner, unique_ptr<Connection> leased) : pool(owner), connection(move(leased)) {}
+
+  ConnectionPool::Lease::~Lease()
+  {
+    if(pool != nullptr && connection) {
+      pool->release(move(connection));
+    }
+  }
+
+  ConnectionPool::ConnectionPool(std::size_t max_idle/*=8*/, const RequesterOptions& options/*=RequesterOptions()*/,
+                                 CURLSH* share/*=nullptr*/)
+    : max_idle(max_idle), options(options), share(share)
+  {
+    // curl_global_init is not thread safe, a function local static guarantees it only runs once.
+    static cURLpp::Cleanup cleaner;
+  }
+
+  ConnectionPool::Lease ConnectionPool::acquire()
+  {
+    {
+      lock_guard<mutex> lock(pool_mutex);
+      if(!handles.empty()) {
+        unique_ptr<Connection> connection = move(handles.back());
+        handles.pop_back();
+        return Lease(this, move(connection));
+      }
+    }
+    return Lease(this, make_handle());
+  }
+
+  std::size_t ConnectionPool::idle() const
+  {
+    lock_guard<mutex> lock(pool_mutex);
+    return handles.size();
+  }
+
+  void ConnectionPool::release(unique_ptr<Connection> connection)
+  {
+    connection->buffer.clear();
+    lock_guard<mutex> lock(pool_mutex);
+    if(handles.size() < max_idle) {
+      handles.push_back(move(connection));
+    }
+  }
+
+  unique_ptr<ConnectionPool::Connection> ConnectionPool::make_handle() const
+  {
+    auto connection = std::make_unique<Connection>();
+    cURLpp::Easy* handle = &connection->handle;
+    handle->setOpt(cURLpp::Options::NoSignal(true));
+    handle->setOpt(cURLpp::OptionTrait<long, CURLOPT_TCP_KEEPALIVE>(1L));
+    handle->setOpt(cURLpp::OptionTrait<long, CURLOPT_TCP_KEEPIDLE>(KEEPALIVE_IDLE));
+    handle->setOpt(cURLpp::OptionTrait<long, CURLOPT_TCP_KEEPINTVL>(KEEPALIVE_INTERVAL));
+    handle->setOpt(cURLpp::OptionTrait<long, CURLOPT_HTTP_VERSION>(options.curl_http_version()));
+    // Wait for the first connection to the host to confirm multiplexing instead of racing to open more of them.
+    handle->setOpt(cURLpp::OptionTrait<long, CURLOPT_PIPEWAIT>(options.multiplexed() ? 1L : 0L));
+    if(options.compression()) {
+      // An empty string offers every encoding libcurl supports, libcurl then inflates the body before the write callback.
+      handle->setOpt(cURLpp::Options::Encoding(""));
+    }
+    if(share != nullptr) {
+      curl_easy_setopt(handle->getHandle(), CURLOPT_SHARE, share);
+    }
+    return connection;
+  }
+
+}
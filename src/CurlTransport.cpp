@@ -0,0 +1,111 @@
+#include "../include/cbirdpp/CurlTransport.h"
+#include "../include/cbirdpp/cbirdpp.h"
+
+#include <curlpp/Exception.hpp>
+#include <curlpp/Options.hpp>
+
+#include <chrono>
+using std::chrono::milliseconds;
+
+#include <exception>
+using std::exception_ptr;
+
+#include <functional>
+using std::function;
+
+#include <future>
+using std::future;
+using std::promise;
+
+#include <memory>
+using std::make_shared;
+using std::shared_ptr;
+
+#include <string>
+using std::string;
+
+#include <utility>
+using std::move;
+
+#include <vector>
+using std::vector;
+
+namespace cbirdpp
+{
+
+  // Warm-up requests give up after this long, so a Requester never waits longer on its warm-up when destroyed.
+  const milliseconds WARMUP_TIMEOUT(10000);
+
+  CurlTransport::CurlTransport(shared_ptr<ConnectionPool> connections, shared_ptr<AsyncEngine> engine,
+                               shared_ptr<RateLimiter> limiter)
+    : connections(move(connections)), engine(move(engine)), limiter(move(limiter)) {}
+
+  void CurlTransport::perform(const Request& request, const function<void(ResponseBuffer&)>& received)
+  {
+    RateLimiter::Ticket ticket = limiter->acquire();
+    ConnectionPool::Lease handle = connections->acquire();
+    handle->setOpt(cURLpp::Options::Url(request.url));
+    handle->setOpt(cURLpp::Options::HttpHeader(request.headers));
+    // Always set, so a timeout doesn't linger on the pooled handle for the next request.
+    handle->setOpt(cURLpp::Options::TimeoutMs(static_cast<long>(request.timeout.count())));
+    handle->setOpt(cURLpp::Options::NoBody(request.headers_only));
+    ResponseBuffer& response = handle.buffer();
+    response.attach(*handle);
+    response.stream_to(request.stream);
+    try {
+      handle->perform();
+    } catch(const cURLpp::LibcurlRuntimeError&) {
+      throw TransferFailed();
+    }
+    ticket.complete(response.status(), response.retry_after());
+    received(response);
+  }
+
+  void CurlTransport::submit(const Request& request, Completion done)
+  {
+    engine->submit(request, move(done));
+  }
+
+  future<void> CurlTransport::prewarm(const string& url, unsigned int count)
+  {
+    if(count == 0) {return Transport::prewarm(url, count);}
+    shared_ptr<ConnectionPool> pool = connections;
+    shared_ptr<AsyncEngine> async = engine;
+    return std::async(std::launch::async, [pool, async, url, count] {
+      Request request;
+      request.url = url;
+      request.timeout = WARMUP_TIMEOUT;
+      request.headers_only = true;
+
+      // The engine keeps connections of its own, so it needs warming up as well.
+      vector<future<bool>> opened;
+      for(unsigned int i = 0; i < count; ++i) {
+        auto done = make_shared<promise<bool>>();
+        opened.push_back(done->get_future());
+        async->submit(request, [done](const ResponseBuffer&, exception_ptr error) { done->set_value(!error); });
+      }
+      // All handles are leased before any of them connects, so each one opens a connection of its own.
+      vector<ConnectionPool::Lease> handles;
+      for(unsigned int i = 0; i < count; ++i) {handles.push_back(pool->acquire());}
+      for(ConnectionPool::Lease& handle : handles) {
+        opened.push_back(std::async(std::launch::async, [&handle, &request] {
+          handle->setOpt(cURLpp::Options::Url(request.url));
+          handle->setOpt(cURLpp::Options::HttpHeader(request.headers));
+          handle->setOpt(cURLpp::Options::TimeoutMs(static_cast<long>(request.timeout.count())));
+          handle->setOpt(cURLpp::Options::NoBody(true));
+          handle.buffer().attach(*handle);
+          try {
+            handle->perform();
+            return true;
+          } catch(const cURLpp::LibcurlRuntimeError&) {
+            return false;
+          }
+        }));
+      }
+      bool any = false;
+      for(future<bool>& connection : opened) {any = connection.get() || any;}
+      if(!any) {throw TransferFailed();}
+    });
+  }
+
+}
@@ -124,6 +124,12 @@ namespace cbirdpp
     }
   }
 
+  void DataOptionalParameters::set_fields(const unsigned long fields)
+  {
+    if(fields == 0 || (fields & ~static_cast<unsigned long>(ObservationFields::all)) != 0) {throw ArgumentOutOfRange(fields);}
+    _fields = fields;
+  }
+
   void DataOptionalParameters::reset()
   {
     _back.reset();
@@ -135,6 +141,7 @@ namespace cbirdpp
     _sort.reset();
     _dist.reset();
     _rank.reset();
+    _fields = ObservationFields::all;
   }
 
   const optional<unsigned int>& DataOptionalParameters::back() const
@@ -180,6 +187,11 @@ namespace cbirdpp
     return _rank;
   }
 
+  unsigned long DataOptionalParameters::fields() const
+  {
+    return _fields;
+  }
+
   string DataOptionalParameters::format_back() const
   {
     if(!_back) {return "";}
@@ -0,0 +1,515 @@
+#include "../include/cbirdpp/JsonReader.h"
+#include "../include/cbirdpp/cbirdpp.h"
+
+#include <charconv>
+using std::from_chars;
+using std::from_chars_result;
+
+#include <cmath>
+
+#include <cstdint>
+using std::uint32_t;
+using std::uint64_t;
+
+#include <cstring>
+
+#include <string>
+using std::string;
+
+#include <string_view>
+using std::string_view;
+
+#include <system_error>
+using std::errc;
+
+#include <vector>
+using std::vector;
+
+namespace cbirdpp
+{
+
+  // The longest number text accepted, far beyond anything the API sends.
+  const std::size_t MAX_NUMBER_LENGTH = 64;
+
+  // Containers nested deeper than this are refused instead of skipped.
+  const unsigned int MAX_SKIP_DEPTH = 512;
+
+  static bool is_whitespace(char c)
+  {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+  }
+
+  static int hex_digit(char c)
+  {
+    if(c >= '0' && c <= '9') {return c - '0';}
+    if(c >= 'a' && c <= 'f') {return c - 'a' + 10;}
+    if(c >= 'A' && c <= 'F') {return c - 'A' + 10;}
+    return -1;
+  }
+
+  static void append_utf8(string& target, uint32_t code_point)
+  {
+    if(code_point < 0x80) {
+      target += static_cast<char>(code_point);
+    } else if(code_point < 0x800) {
+      target += static_cast<char>(0xC0 | (code_point >> 6));
+      target += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if(code_point < 0x10000) {
+      target += static_cast<char>(0xE0 | (code_point >> 12));
+      target += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      target += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+      target += static_cast<char>(0xF0 | (code_point >> 18));
+      target += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      target += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      target += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+  }
+
+  JsonReader::JsonReader(string_view text, std::size_t index_threshold/*=INDEX_THRESHOLD*/,
+                         ErrorHandling errors/*=throw_errors*/)
+  : text(text), indexed(text.size() >= index_threshold && errors == throw_errors), throws(errors == throw_errors)
+  {
+    if(indexed) {index = StructuralIndex::recycled(text);}
+  }
+
+  JsonReader::~JsonReader()
+  {
+    StructuralIndex::retire(std::move(index));
+  }
+
+  std::size_t JsonReader::indexed_from(std::size_t from)
+  {
+    const vector<uint32_t>& positions = index.positions();
+    while(cursor < positions.size() && positions[cursor] < from) {++cursor;}
+    return cursor;
+  }
+
+  void JsonReader::malformed()
+  {
+    if(throws) {throw RequestFailed();}
+    error = true;
+    position = text.size();
+    first = false;
+  }
+
+  char JsonReader::peek()
+  {
+    while(position < text.size() && is_whitespace(text[position])) {++position;}
+    return position < text.size() ? text[position] : '\0';
+  }
+
+  void JsonReader::expect(char expected)
+  {
+    if(peek() != expected) {
+      malformed();
+      return;
+    }
+    consume();
+  }
+
+  void JsonReader::consume()
+  {
+    // Keeps the cursor on the next structural character, so strings find their quotes without a search.
+    if(indexed && cursor < index.positions().size() && index.positions()[cursor] == position) {++cursor;}
+    ++position;
+  }
+
+  void JsonReader::begin_array()
+  {
+    expect('[');
+    first = true;
+  }
+
+  bool JsonReader::next_element()
+  {
+    if(error || (run && peek() == '\0')) {return false;}
+    if(peek() == ']') {
+      consume();
+      first = false;   // The array itself was an element of the container around it.
+      return false;
+    }
+    if(!first) {expect(',');}
+    first = false;
+    return !error;
+  }
+
+  void JsonReader::begin_run()
+  {
+    if(peek() != '[' && peek() != ',') {
+      malformed();
+      return;
+    }
+    consume();
+    first = true;
+    run = true;
+  }
+
+  vector<string_view> JsonReader::split_array(string_view text, std::size_t parts)
+  {
+    vector<string_view> runs;
+    JsonReader whole(text, 0);
+    const vector<uint32_t>& positions = whole.index.positions();
+    if(positions.empty() || text[positions[0]] != '[' ||
+       text.substr(0, positions[0]).find_first_not_of(" \n\r\t") != string_view::npos) {
+      return runs;
+    }
+    std::size_t target = text.size() / parts + 1;
+    std::size_t start = positions[0];
+    unsigned int depth = 0;
+    // Quotes come as pairs in the index and are passed over, only the separators between elements are cut at.
+    for(uint32_t position : positions) {
+      switch(text[position]) {
+        case '[':
+        case '{':
+          ++depth;
+          break;
+        case ']':
+        case '}':
+          if(--depth == 0) {
+            if(text.substr(position + 1).find_first_not_of(" \n\r\t") != string_view::npos) {return {};}
+            runs.push_back(text.substr(start, position - start));
+            return runs;
+          }
+          break;
+        case ',':
+          if(depth == 1 && position - start >= target) {
+            runs.push_back(text.substr(start, position - start));
+            start = position;
+          }
+          break;
+      }
+    }
+    return {};
+  }
+
+  void JsonReader::begin_object()
+  {
+    expect('{');
+    first = true;
+  }
+
+  bool JsonReader::next_key(string_view& key)
+  {
+    if(error) {return false;}
+    if(peek() == '}') {
+      consume();
+      first = false;
+      return false;
+    }
+    if(!first) {expect(',');}
+    first = false;
+    if(peek() != '"') {
+      malformed();
+      return false;
+    }
+    key_buffer.clear();
+    scan_string(key, key_buffer);
+    expect(':');
+    return !error;
+  }
+
+  void JsonReader::scan_string(string_view& view, string& decoded)
+  {
+    if(indexed) {
+      // The entry after an opening quote is always its closing quote, and the index has checked what lies between.
+      const vector<uint32_t>& positions = index.positions();
+      std::size_t opening = indexed_from(position);
+      if(opening + 1 >= positions.size() || positions[opening] != position) {
+        malformed();
+        return;
+      }
+      std::size_t start = position + 1;
+      std::size_t end = positions[opening + 1];
+      cursor = opening + 2;
+      if(!index.escapes() || std::memchr(text.data() + start, '\\', end - start) == nullptr) {
+        view = text.substr(start, end - start);
+        position = end + 1;
+        return;
+      }
+    }
+
+    ++position;   // The opening quote.
+    std::size_t start = position;
+    while(position < text.size() && text[position] != '"' && text[position] != '\\') {
+      if(static_cast<unsigned char>(text[position]) < 0x20) {
+        malformed();
+        return;
+      }
+      ++position;
+    }
+    if(position >= text.size()) {
+      malformed();
+      return;
+    }
+    if(text[position] == '"') {
+      view = text.substr(start, position - start);
+      ++position;
+      return;
+    }
+
+    // Only strings with escapes are copied and decoded.
+    decoded.assign(text.data() + start, position - start);
+    while(true) {
+      if(position >= text.size()) {
+        malformed();
+        return;
+      }
+      char c = text[position++];
+      if(c == '"') {break;}
+      if(static_cast<unsigned char>(c) < 0x20) {
+        malformed();
+        return;
+      }
+      if(c != '\\') {
+        decoded += c;
+        continue;
+      }
+      if(position >= text.size()) {
+        malformed();
+        return;
+      }
+      switch(text[position++]) {
+        case '"': decoded += '"'; break;
+        case '\\': decoded += '\\'; break;
+        case '/': decoded += '/'; break;
+        case 'b': decoded += '\b'; break;
+        case 'f': decoded += '\f'; break;
+        case 'n': decoded += '\n'; break;
+        case 'r': decoded += '\r'; break;
+        case 't': decoded += '\t'; break;
+        case 'u': {
+          // The four hex digits of a UTF-16 code unit, above 0xFFFF if they aren't.
+          auto code_unit = [this]() {
+            if(text.size() - position < 4) {return uint32_t(0x10000);}
+            uint32_t value = 0;
+            for(int i = 0; i < 4; ++i) {
+              int digit = hex_digit(text[position++]);
+              if(digit < 0) {return uint32_t(0x10000);}
+              value = (value << 4) | static_cast<uint32_t>(digit);
+            }
+            return value;
+          };
+          uint32_t code_point = code_unit();
+          if(code_point >= 0xD800 && code_point < 0xDC00) {
+            // A high surrogate has to be followed by the escaped low surrogate of the pair.
+            uint32_t low = text.substr(position, 2) == "\\u" ? (position += 2, code_unit()) : 0;
+            if(low < 0xDC00 || low >= 0xE000) {
+              malformed();
+              return;
+            }
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+          } else if(code_point > 0xFFFF || (code_point >= 0xDC00 && code_point < 0xE000)) {
+            malformed();
+            return;
+          }
+          append_utf8(decoded, code_point);
+          break;
+        }
+        default:
+          malformed();
+          return;
+      }
+    }
+    view = decoded;
+  }
+
+  void JsonReader::read_string(string& target)
+  {
+    if(peek() != '"') {
+      malformed();
+      return;
+    }
+    string_view view;
+    scan_string(view, target);
+    // Without escapes the text was only viewed, with escapes it was decoded into target already.
+    if(view.data() != target.data()) {target.assign(view.data(), view.size());}
+  }
+
+  string_view JsonReader::read_string_view(string& decoded)
+  {
+    if(peek() != '"') {
+      malformed();
+      return string_view();
+    }
+    string_view view;
+    scan_string(view, decoded);
+    return view;
+  }
+
+  string_view JsonReader::number_token()
+  {
+    char c = peek();
+    if(c != '-' && (c < '0' || c > '9')) {
+      malformed();
+      return string_view();
+    }
+    std::size_t start = position;
+    while(position < text.size()) {
+      c = text[position];
+      if((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+        ++position;
+      } else {
+        break;
+      }
+    }
+    if(position - start > MAX_NUMBER_LENGTH) {
+      malformed();
+      return string_view();
+    }
+    return text.substr(start, position - start);
+  }
+
+  uint64_t JsonReader::read_unsigned()
+  {
+    string_view token = number_token();
+    if(error) {return 0;}
+    uint64_t value = 0;
+    from_chars_result result = from_chars(token.data(), token.data() + token.size(), value);
+    if(result.ec == errc() && result.ptr == token.data() + token.size()) {return value;}
+
+    // Integers written with a fraction or exponent, such as 1.0 or 1e3, are accepted too.
+    double number = 0;
+    result = from_chars(token.data(), token.data() + token.size(), number);
+    if(result.ec != errc() || result.ptr != token.data() + token.size() || number < 0 ||
+       number != std::floor(number) || number >= 18446744073709551616.0) {
+      malformed();
+      return 0;
+    }
+    return static_cast<uint64_t>(number);
+  }
+
+  double JsonReader::read_double()
+  {
+    string_view token = number_token();
+    if(error) {return 0;}
+    double value = 0;
+    from_chars_result result = from_chars(token.data(), token.data() + token.size(), value);
+    if(result.ec != errc() || result.ptr != token.data() + token.size()) {
+      malformed();
+      return 0;
+    }
+    return value;
+  }
+
+  bool JsonReader::read_bool()
+  {
+    peek();
+    if(text.substr(position, 4) == "true") {
+      position += 4;
+      return true;
+    }
+    if(text.substr(position, 5) == "false") {
+      position += 5;
+      return false;
+    }
+    malformed();
+    return false;
+  }
+
+  bool JsonReader::read_null()
+  {
+    peek();
+    if(text.substr(position, 4) != "null") {return false;}
+    position += 4;
+    return true;
+  }
+
+  void JsonReader::skip_value()
+  {
+    char opening = peek();
+    if(indexed && (opening == '[' || opening == '{')) {
+      // Strings come as pairs of quotes in the index, so only the brackets between them need counting.
+      const vector<uint32_t>& positions = index.positions();
+      unsigned int depth = 0;
+      for(std::size_t entry = indexed_from(position); entry < positions.size(); ++entry) {
+        switch(text[positions[entry]]) {
+          case '"':
+            ++entry;
+            break;
+          case '[':
+          case '{':
+            ++depth;
+            break;
+          case ']':
+          case '}':
+            if(--depth == 0) {
+              position = positions[entry] + 1;
+              cursor = entry + 1;
+              first = false;
+              return;
+            }
+            break;
+          default:
+            break;
+        }
+      }
+      malformed();
+      return;
+    }
+
+    // Containers are skipped by counting brackets outside of strings, without looking at the values inside.
+    unsigned int depth = 0;
+    do {
+      char c = peek();
+      switch(c) {
+        case '[':
+        case '{':
+          if(++depth > MAX_SKIP_DEPTH) {
+            malformed();
+            return;
+          }
+          ++position;
+          break;
+        case ']':
+        case '}':
+          if(depth == 0) {
+            malformed();
+            return;
+          }
+          --depth;
+          ++position;
+          break;
+        case ',':
+        case ':':
+          if(depth == 0) {
+            malformed();
+            return;
+          }
+          ++position;
+          break;
+        case '"': {
+          string_view ignored;
+          key_buffer.clear();
+          scan_string(ignored, key_buffer);
+          break;
+        }
+        case 't':
+        case 'f':
+          read_bool();
+          break;
+        case 'n':
+          if(!read_null()) {
+            malformed();
+            return;
+          }
+          break;
+        default:
+          number_token();
+      }
+    } while(depth > 0 && !error);
+    first = false;
+  }
+
+  void JsonReader::finish()
+  {
+    if(peek() != '\0' || position != text.size()) {malformed();}
+  }
+
+  string& decode_buffer()
+  {
+    thread_local string decoded;
+    return decoded;
+  }
+
+}
@@ -0,0 +1,44 @@
+#include "../include/cbirdpp/LatencyTracker.h"
+
+#include <algorithm>
+using std::nth_element;
+
+#include <chrono>
+using std::chrono::milliseconds;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+
+#include <vector>
+using std::vector;
+
+namespace cbirdpp
+{
+
+  void LatencyTracker::record(const Endpoint& endpoint, milliseconds latency)
+  {
+    lock_guard<mutex> lock(tracker_mutex);
+    Window& window = windows[endpoint];
+    if(window.samples.size() < WINDOW) {
+      window.samples.push_back(latency);
+    } else {
+      window.samples[window.next] = latency;
+    }
+    window.next = (window.next + 1) % WINDOW;
+  }
+
+  milliseconds LatencyTracker::percentile(const Endpoint& endpoint, double share) const
+  {
+    vector<milliseconds> samples;
+    {
+      lock_guard<mutex> lock(tracker_mutex);
+      samples = windows[endpoint].samples;
+    }
+    if(samples.size() < MIN_SAMPLES) {return milliseconds(0);}
+    auto nth = samples.begin() + static_cast<std::ptrdiff_t>(share * static_cast<double>(samples.size() - 1));
+    nth_element(samples.begin(), nth, samples.end());
+    return *nth;
+  }
+
+}
@@ -0,0 +1,139 @@
+#include "../include/cbirdpp/MemoryTransport.h"
+#include "../include/cbirdpp/cbirdpp.h"
+
+#include <algorithm>
+using std::min;
+
+#include <exception>
+using std::make_exception_ptr;
+
+#include <fstream>
+using std::ifstream;
+
+#include <functional>
+using std::function;
+using std::hash;
+
+#include <memory>
+using std::make_shared;
+
+#include <mutex>
+using std::lock_guard;
+
+#include <sstream>
+using std::ostringstream;
+
+#include <stdexcept>
+using std::runtime_error;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <utility>
+using std::move;
+
+#include <vector>
+using std::vector;
+
+namespace cbirdpp
+{
+
+  void MemoryTransport::serve(const string& url_prefix, string body, long status/*=200*/,
+                              const string& content_type/*=application/json*/)
+  {
+    ostringstream etag;
+    etag << '"' << std::hex << hash<string>()(body) << '"';
+    Route served{url_prefix, status, content_type, make_shared<const string>(move(body)), etag.str()};
+    lock_guard<std::mutex> lock(routes_mutex);
+    for(Route& route : routes) {
+      if(route.prefix == url_prefix) {
+        route = move(served);
+        return;
+      }
+    }
+    routes.push_back(move(served));
+  }
+
+  void MemoryTransport::serve_file(const string& url_prefix, const string& path)
+  {
+    ifstream file(path, std::ios::binary);
+    if(!file) {throw runtime_error("MemoryTransport could not read " + path);}
+    ostringstream contents;
+    contents << file.rdbuf();
+    serve(url_prefix, contents.str());
+  }
+
+  std::size_t MemoryTransport::requests() const
+  {
+    return answered;
+  }
+
+  std::size_t MemoryTransport::bytes_sent() const
+  {
+    return sent;
+  }
+
+  void MemoryTransport::perform(const Request& request, const function<void(ResponseBuffer&)>& received)
+  {
+    ResponseBuffer response;
+    response.stream_to(request.stream);
+    respond(request, response);
+    received(response);
+  }
+
+  void MemoryTransport::submit(const Request& request, Completion done)
+  {
+    ResponseBuffer response;
+    // Requests complete at once, so a delayed hedge finds the original settled and is dropped like with curl.
+    if(request.delay.count() > 0 && request.wanted && !request.wanted()) {
+      done(response, make_exception_ptr(RequestFailed()));
+      return;
+    }
+    respond(request, response);
+    done(response, nullptr);
+  }
+
+  void MemoryTransport::respond(const Request& request, ResponseBuffer& response)
+  {
+    Route match;
+    bool found = false;
+    {
+      lock_guard<std::mutex> lock(routes_mutex);
+      const Route* longest = nullptr;
+      for(const Route& route : routes) {
+        if(request.url.compare(0, route.prefix.size(), route.prefix) == 0 && (!longest || route.prefix.size() > longest->prefix.size())) {
+          longest = &route;
+        }
+      }
+      if(longest) {
+        match = *longest;
+        found = true;
+      }
+    }
+    long status = found ? match.status : 404;
+    bool unchanged = false;
+    if(found && status == 200) {
+      for(const string& header : request.headers) {
+        unchanged = unchanged || header == "If-None-Match: " + match.etag;
+      }
+    }
+    vector<string> headers = {"HTTP/1.1 " + to_string(unchanged ? 304 : status) + "\r\n"};
+    if(found) {
+      headers.push_back("Content-Type: " + match.content_type + "\r\n");
+      headers.push_back("ETag: " + match.etag + "\r\n");
+      if(!unchanged) {headers.push_back("Content-Length: " + to_string(match.body->size()) + "\r\n");}
+    }
+    for(const string& line : headers) {response.header(line.data(), line.size());}
+    ++answered;
+    if(!found || unchanged) {return;}
+    const string& body = *match.body;
+    for(std::size_t sent_so_far = 0; sent_so_far < body.size(); sent_so_far += CHUNK) {
+      std::size_t size = min(CHUNK, body.size() - sent_so_far);
+      // Like curl, a chunk the response doesn't take aborts the transfer.
+      if(response.append(body.data() + sent_so_far, size) != size) {throw TransferFailed();}
+      sent += size;
+    }
+  }
+
+}
@@ -0,0 +1,170 @@
+#include "../include/cbirdpp/RateLimiter.h"
+
+#include <algorithm>
+using std::max;
+using std::min;
+
+#include <chrono>
+using std::chrono::duration;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+#include <limits>
+using std::numeric_limits;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+namespace cbirdpp
+{
+
+  // The rate never backs off below this many requests per second.
+  const double MIN_RATE = 0.5;
+
+  // Factor the rate and the concurrency limit are multiplied with on a 429 or 5xx.
+  const double DECREASE = 0.7;
+
+  // Share of the maximum rate regained per second of successes at the current rate.
+  const double RATE_INCREASE = 0.05;
+
+  RateLimiter::Ticket::Ticket(RateLimiter* owner, unsigned long epoch) : limiter(owner), epoch(epoch) {}
+
+  RateLimiter::Ticket::Ticket(Ticket&& other) noexcept : limiter(other.limiter), epoch(other.epoch)
+  {
+    other.limiter = nullptr;
+  }
+
+  RateLimiter::Ticket& RateLimiter::Ticket::operator=(Ticket&& other) noexcept
+  {
+    if(this != &other) {
+      if(limiter != nullptr) {limiter->release();}
+      limiter = other.limiter;
+      epoch = other.epoch;
+      other.limiter = nullptr;
+    }
+    return *this;
+  }
+
+  RateLimiter::Ticket::~Ticket()
+  {
+    if(limiter != nullptr) {limiter->release();}
+  }
+
+  void RateLimiter::Ticket::complete(long status, long retry_after/*=0*/)
+  {
+    if(limiter != nullptr) {limiter->record(epoch, status, retry_after);}
+  }
+
+  RateLimiter::RateLimiter(double max_rate/*=0*/, unsigned int max_concurrency/*=0*/)
+    : max_rate(max_rate), current_rate(max_rate), tokens(max(1.0, max_rate)), refilled(Clock::now()),
+      paused_until(Clock::now()),
+      max_concurrency(max_concurrency == 0 ? numeric_limits<double>::infinity() : max_concurrency),
+      limit(max_concurrency == 0 ? numeric_limits<double>::infinity() : max_concurrency) {}
+
+  RateLimiter::Ticket RateLimiter::acquire()
+  {
+    unique_lock<mutex> lock(limiter_mutex);
+    while(true) {
+      Clock::time_point now = Clock::now();
+      if(admit(now)) {return Ticket(this, epoch);}
+      if(static_cast<double>(active) >= limit) {
+        released.wait(lock);
+      } else {
+        released.wait_for(lock, token_wait(now));
+      }
+    }
+  }
+
+  bool RateLimiter::try_acquire(Ticket& ticket)
+  {
+    lock_guard<mutex> lock(limiter_mutex);
+    if(!admit(Clock::now())) {return false;}
+    ticket = Ticket(this, epoch);
+    return true;
+  }
+
+  milliseconds RateLimiter::next_available() const
+  {
+    lock_guard<mutex> lock(limiter_mutex);
+    // Rounded up, so a caller sleeping this long finds the token there.
+    return std::chrono::ceil<milliseconds>(token_wait(Clock::now()));
+  }
+
+  double RateLimiter::rate() const
+  {
+    lock_guard<mutex> lock(limiter_mutex);
+    return current_rate;
+  }
+
+  double RateLimiter::concurrency_limit() const
+  {
+    lock_guard<mutex> lock(limiter_mutex);
+    return limit == numeric_limits<double>::infinity() ? 0 : limit;
+  }
+
+  std::size_t RateLimiter::in_flight() const
+  {
+    lock_guard<mutex> lock(limiter_mutex);
+    return active;
+  }
+
+  bool RateLimiter::admit(Clock::time_point now)
+  {
+    if(static_cast<double>(active) >= limit || now < paused_until) {return false;}
+    if(max_rate > 0) {
+      double elapsed = duration<double>(now - refilled).count();
+      tokens = min(max(1.0, current_rate), tokens + elapsed * current_rate);
+      refilled = now;
+      if(tokens < 1.0) {return false;}
+      tokens -= 1.0;
+    }
+    ++active;
+    return true;
+  }
+
+  RateLimiter::Clock::duration RateLimiter::token_wait(Clock::time_point now) const
+  {
+    Clock::duration wait = Clock::duration::zero();
+    if(now < paused_until) {wait = paused_until - now;}
+    if(max_rate > 0) {
+      double elapsed = duration<double>(now - refilled).count();
+      double missing = 1.0 - min(max(1.0, current_rate), tokens + elapsed * current_rate);
+      if(missing > 0) {
+        wait = max(wait, duration_cast<Clock::duration>(duration<double>(missing / current_rate)));
+      }
+    }
+    return wait;
+  }
+
+  void RateLimiter::record(unsigned long ticket_epoch, long status, long retry_after)
+  {
+    lock_guard<mutex> lock(limiter_mutex);
+    if(status == 429 || status >= 500) {
+      if(retry_after > 0) {paused_until = max(paused_until, Clock::now() + seconds(retry_after));}
+      // Requests sent before the last decrease saw the old limits, their failures don't count a second time.
+      if(ticket_epoch != epoch) {return;}
+      ++epoch;
+      limit = max(1.0, min(limit, static_cast<double>(active)) * DECREASE);
+      if(max_rate > 0) {
+        current_rate = max(MIN_RATE, current_rate * DECREASE);
+        tokens = min(tokens, 1.0);
+      }
+    } else if(status >= 200 && status < 300) {
+      if(limit != numeric_limits<double>::infinity()) {limit = min(max_concurrency, limit + 1 / limit);}
+      if(max_rate > 0) {current_rate = min(max_rate, current_rate + RATE_INCREASE * max_rate / current_rate);}
+    }
+  }
+
+  void RateLimiter::release()
+  {
+    {
+      lock_guard<mutex> lock(limiter_mutex);
+      --active;
+    }
+    released.notify_all();
+  }
+
+}
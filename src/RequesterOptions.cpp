@@ -0,0 +1,208 @@
+#include "../include/cbirdpp/RequesterOptions.h"
+
+#include <curl/curl.h>
+
+namespace cbirdpp
+{
+
+  RequesterOptions::RequesterOptions() = default;
+
+  void RequesterOptions::set_http_version(const HttpVersion& http_version)
+  {
+    _http_version = http_version;
+  }
+
+  void RequesterOptions::set_max_concurrent_streams(const unsigned int max_concurrent_streams)
+  {
+    if(max_concurrent_streams < 1 || max_concurrent_streams > 1000) {throw ArgumentOutOfRange(max_concurrent_streams);}
+    _max_concurrent_streams = max_concurrent_streams;
+  }
+
+  void RequesterOptions::set_max_host_connections(const unsigned int max_host_connections)
+  {
+    if(max_host_connections > 1000) {throw ArgumentOutOfRange(max_host_connections);}
+    _max_host_connections = max_host_connections;
+  }
+
+  void RequesterOptions::set_compression(const bool compression)
+  {
+    _compression = compression;
+  }
+
+  void RequesterOptions::set_rate_limit(const double rate_limit)
+  {
+    if(rate_limit < 0 || rate_limit > 1000) {throw ArgumentOutOfRange(rate_limit);}
+    _rate_limit = rate_limit;
+  }
+
+  void RequesterOptions::set_max_concurrency(const unsigned int max_concurrency)
+  {
+    if(max_concurrency > 1000) {throw ArgumentOutOfRange(max_concurrency);}
+    _max_concurrency = max_concurrency;
+  }
+
+  void RequesterOptions::set_timeout(const Endpoint& endpoint, const unsigned int timeout)
+  {
+    if(timeout > 600000) {throw ArgumentOutOfRange(timeout);}
+    _timeouts[endpoint] = timeout;
+  }
+
+  void RequesterOptions::set_max_retries(const unsigned int max_retries)
+  {
+    if(max_retries > 10) {throw ArgumentOutOfRange(max_retries);}
+    _max_retries = max_retries;
+  }
+
+  void RequesterOptions::set_backoff(const unsigned int backoff_base, const unsigned int backoff_cap)
+  {
+    if(backoff_base < 1 || backoff_base > 60000) {throw ArgumentOutOfRange(backoff_base);}
+    if(backoff_cap < 1 || backoff_cap > 600000) {throw ArgumentOutOfRange(backoff_cap);}
+    _backoff_base = backoff_base;
+    _backoff_cap = backoff_cap;
+  }
+
+  void RequesterOptions::set_hedging(const bool hedging)
+  {
+    _hedging = hedging;
+  }
+
+  void RequesterOptions::set_revalidation_cache(const unsigned int revalidation_cache)
+  {
+    if(revalidation_cache > 100000) {throw ArgumentOutOfRange(revalidation_cache);}
+    _revalidation_cache = revalidation_cache;
+  }
+
+  void RequesterOptions::set_prewarm(const unsigned int prewarm)
+  {
+    if(prewarm > 16) {throw ArgumentOutOfRange(prewarm);}
+    _prewarm = prewarm;
+  }
+
+  void RequesterOptions::set_string_pool(const unsigned int string_pool)
+  {
+    if(string_pool < 1 || string_pool > 4096) {throw ArgumentOutOfRange(string_pool);}
+    _string_pool = string_pool;
+  }
+
+  void RequesterOptions::set_parallel_decode(const unsigned int parallel_decode, const unsigned int decode_threads)
+  {
+    if(parallel_decode < 64 || parallel_decode > 1048576) {throw ArgumentOutOfRange(parallel_decode);}
+    if(decode_threads > 64) {throw ArgumentOutOfRange(decode_threads);}
+    _parallel_decode = parallel_decode;
+    _decode_threads = decode_threads;
+  }
+
+  void RequesterOptions::set_api_url(const std::string& api_url)
+  {
+    if(api_url.empty()) {throw ArgumentOutOfRange(api_url);}
+    _api_url = api_url.back() == '/' ? api_url : api_url + "/";
+  }
+
+  void RequesterOptions::reset()
+  {
+    *this = RequesterOptions();
+  }
+
+  const HttpVersion& RequesterOptions::http_version() const
+  {
+    return _http_version;
+  }
+
+  unsigned int RequesterOptions::max_concurrent_streams() const
+  {
+    return _max_concurrent_streams;
+  }
+
+  unsigned int RequesterOptions::max_host_connections() const
+  {
+    return _max_host_connections;
+  }
+
+  bool RequesterOptions::compression() const
+  {
+    return _compression;
+  }
+
+  double RequesterOptions::rate_limit() const
+  {
+    return _rate_limit;
+  }
+
+  unsigned int RequesterOptions::max_concurrency() const
+  {
+    return _max_concurrency;
+  }
+
+  unsigned int RequesterOptions::timeout(const Endpoint& endpoint) const
+  {
+    return _timeouts[endpoint];
+  }
+
+  unsigned int RequesterOptions::max_retries() const
+  {
+    return _max_retries;
+  }
+
+  unsigned int RequesterOptions::backoff_base() const
+  {
+    return _backoff_base;
+  }
+
+  unsigned int RequesterOptions::backoff_cap() const
+  {
+    return _backoff_cap;
+  }
+
+  bool RequesterOptions::hedging() const
+  {
+    return _hedging;
+  }
+
+  unsigned int RequesterOptions::revalidation_cache() const
+  {
+    return _revalidation_cache;
+  }
+
+  unsigned int RequesterOptions::prewarm() const
+  {
+    return _prewarm;
+  }
+
+  unsigned int RequesterOptions::string_pool() const
+  {
+    return _string_pool;
+  }
+
+  unsigned int RequesterOptions::parallel_decode() const
+  {
+    return _parallel_decode;
+  }
+
+  unsigned int RequesterOptions::decode_threads() const
+  {
+    return _decode_threads;
+  }
+
+  const std::string& RequesterOptions::api_url() const
+  {
+    return _api_url;
+  }
+
+  long RequesterOptions::curl_http_version() const
+  {
+    switch(_http_version) {
+      case HttpVersion::http2:
+        return CURL_HTTP_VERSION_2TLS;
+      case HttpVersion::http2_prior_knowledge:
+        return CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+      default:
+        return CURL_HTTP_VERSION_1_1;
+    }
+  }
+
+  bool RequesterOptions::multiplexed() const
+  {
+    return _http_version != HttpVersion::http1_1;
+  }
+
+}
@@ -0,0 +1,154 @@
+#include "../include/cbirdpp/ResponseBuffer.h"
+
+#include <curlpp/Options.hpp>
+
+#include <cctype>
+using std::isspace;
+using std::tolower;
+
+#include <cstdlib>
+using std::strtol;
+using std::strtoull;
+
+#include <string>
+using std::string;
+
+#include <string_view>
+using std::string_view;
+
+#include <utility>
+using std::move;
+
+namespace cbirdpp
+{
+
+  // Capacity above which clear() frees the buffer instead of keeping it for the next response.
+  const size_t MAX_RETAINED_BYTES = 16 * 1024 * 1024;
+
+  // Content-Length values beyond this are not trusted as a reservation size.
+  const size_t MAX_RESERVATION = 512 * 1024 * 1024;
+
+  /// If line is the header called name (lower case, without the colon), stores its trimmed value and returns true.
+  static bool match_header(string_view line, string_view name, string_view& value)
+  {
+    if(line.size() <= name.size() || line[name.size()] != ':') {return false;}
+    for(size_t i = 0; i < name.size(); ++i) {
+      if(tolower(static_cast<unsigned char>(line[i])) != name[i]) {return false;}
+    }
+    value = line.substr(name.size() + 1);
+    while(!value.empty() && isspace(static_cast<unsigned char>(value.front()))) {value.remove_prefix(1);}
+    while(!value.empty() && isspace(static_cast<unsigned char>(value.back()))) {value.remove_suffix(1);}
+    return true;
+  }
+
+  void ResponseBuffer::attach(cURLpp::Easy& handle)
+  {
+    clear();
+    handle.setOpt(cURLpp::Options::WriteFunction([this](char* data, size_t size, size_t count) {
+      return append(data, size * count);
+    }));
+    handle.setOpt(cURLpp::Options::HeaderFunction([this](char* data, size_t size, size_t count) {
+      return header(data, size * count);
+    }));
+  }
+
+  void ResponseBuffer::stream_to(Sink sink)
+  {
+    this->sink = move(sink);
+  }
+
+  void ResponseBuffer::clear()
+  {
+    if(bytes.capacity() > MAX_RETAINED_BYTES) {
+      string().swap(bytes);
+    } else {
+      bytes.clear();
+    }
+    status_code = 0;
+    type.clear();
+    retry_seconds = 0;
+    entity_tag.clear();
+    modified.clear();
+    sink = nullptr;
+  }
+
+  string_view ResponseBuffer::view() const
+  {
+    return bytes;
+  }
+
+  string ResponseBuffer::release()
+  {
+    string released = move(bytes);
+    bytes = string();
+    return released;
+  }
+
+  size_t ResponseBuffer::capacity() const
+  {
+    return bytes.capacity();
+  }
+
+  long ResponseBuffer::status() const
+  {
+    return status_code;
+  }
+
+  string_view ResponseBuffer::content_type() const
+  {
+    return type;
+  }
+
+  long ResponseBuffer::retry_after() const
+  {
+    return retry_seconds;
+  }
+
+  string_view ResponseBuffer::etag() const
+  {
+    return entity_tag;
+  }
+
+  string_view ResponseBuffer::last_modified() const
+  {
+    return modified;
+  }
+
+  size_t ResponseBuffer::append(const char* data, size_t size)
+  {
+    // Anything but size makes curl abort the transfer.
+    if(sink) {return sink(*this, string_view(data, size)) ? size : 0;}
+    bytes.append(data, size);
+    return size;
+  }
+
+  size_t ResponseBuffer::header(const char* data, size_t size)
+  {
+    string_view line(data, size);
+    string_view value;
+    if(line.substr(0, 5) == "HTTP/") {
+      // A new status line starts a new response, e.g. after a 100 Continue, so forget the previous headers.
+      size_t space = line.find(' ');
+      status_code = space == string_view::npos ? 0 : strtol(string(line.substr(space + 1, 3)).c_str(), nullptr, 10);
+      type.clear();
+      retry_seconds = 0;
+      entity_tag.clear();
+      modified.clear();
+    } else if(match_header(line, "content-length", value)) {
+      size_t length = strtoull(string(value).c_str(), nullptr, 10);
+      if(length > 0 && length <= MAX_RESERVATION && !sink) {
+        bytes.reserve(length);
+      }
+    } else if(match_header(line, "content-type", value)) {
+      type.assign(value.data(), value.size());
+    } else if(match_header(line, "retry-after", value)) {
+      retry_seconds = strtol(string(value).c_str(), nullptr, 10);
+    } else if(match_header(line, "etag", value)) {
+      entity_tag.assign(value.data(), value.size());
+    } else if(match_header(line, "last-modified", value)) {
+      modified.assign(value.data(), value.size());
+    }
+    return size;
+  }
+
+}
@@ -0,0 +1,113 @@
+#include "../include/cbirdpp/SharedContext.h"
+#include "../include/cbirdpp/AsyncEngine.h"
+#include "../include/cbirdpp/ConnectionPool.h"
+#include "../include/cbirdpp/CurlTransport.h"
+#include "../include/cbirdpp/RateLimiter.h"
+#include "../include/cbirdpp/SingleFlight.h"
+#include "../include/cbirdpp/StringPool.h"
+#include "../include/cbirdpp/ValidatorCache.h"
+#include "../include/cbirdpp/WorkerPool.h"
+
+#include <future>
+using std::shared_future;
+
+#include <memory>
+using std::make_shared;
+using std::shared_ptr;
+
+namespace cbirdpp
+{
+
+  // Idle handles, and with them open connections, the context keeps for all of its Requesters together.
+  const size_t MAX_SHARED_CONNECTIONS = 32;
+
+  SharedContext::SharedContext(const RequesterOptions& options/*=RequesterOptions()*/)
+    : share(curl_share_init()), shared_options(options)
+  {
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, &SharedContext::lock);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, &SharedContext::unlock);
+    curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    rate_limiter = make_shared<RateLimiter>(options.rate_limit(), options.max_concurrency());
+    pool = make_shared<ConnectionPool>(MAX_SHARED_CONNECTIONS, options, share);
+    async_engine = make_shared<AsyncEngine>(options, share, rate_limiter);
+    curl_transport = make_shared<CurlTransport>(pool, async_engine, rate_limiter);
+    single_flight = make_shared<SingleFlight>();
+    validator_cache = make_shared<ValidatorCache>(options.revalidation_cache());
+    interned_strings = make_shared<InternedStrings>(std::size_t(options.string_pool()) << 20);
+    worker_pool = make_shared<WorkerPool>(options.decode_threads());
+    warmed = curl_transport->prewarm(options.api_url(), options.prewarm()).share();
+  }
+
+  SharedContext::~SharedContext()
+  {
+    // Requesters hold on to the context, so only the warm-up can still be using the pool or the engine at this point.
+    warmed.wait();
+    curl_transport.reset();
+    async_engine.reset();
+    pool.reset();
+    curl_share_cleanup(share);
+  }
+
+  const RequesterOptions& SharedContext::options() const
+  {
+    return shared_options;
+  }
+
+  shared_ptr<ConnectionPool> SharedContext::connections() const
+  {
+    return pool;
+  }
+
+  shared_ptr<AsyncEngine> SharedContext::engine() const
+  {
+    return async_engine;
+  }
+
+  shared_ptr<Transport> SharedContext::transport() const
+  {
+    return curl_transport;
+  }
+
+  shared_ptr<RateLimiter> SharedContext::limiter() const
+  {
+    return rate_limiter;
+  }
+
+  shared_ptr<SingleFlight> SharedContext::flights() const
+  {
+    return single_flight;
+  }
+
+  shared_future<void> SharedContext::ready() const
+  {
+    return warmed;
+  }
+
+  shared_ptr<ValidatorCache> SharedContext::validators() const
+  {
+    return validator_cache;
+  }
+
+  shared_ptr<InternedStrings> SharedContext::strings() const
+  {
+    return interned_strings;
+  }
+
+  shared_ptr<WorkerPool> SharedContext::workers() const
+  {
+    return worker_pool;
+  }
+
+  void SharedContext::lock(CURL* /*handle*/, curl_lock_data data, curl_lock_access /*access*/, void* context)
+  {
+    static_cast<SharedContext*>(context)->locks[data].lock();
+  }
+
+  void SharedContext::unlock(CURL* /*handle*/, curl_lock_data data, void* context)
+  {
+    static_cast<SharedContext*>(context)->locks[data].unlock();
+  }
+
+}
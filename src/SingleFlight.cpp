@@ -0,0 +1,60 @@
+#include "../include/cbirdpp/SingleFlight.h"
+
+#include <exception>
+using std::exception_ptr;
+
+#include <memory>
+using std::shared_ptr;
+
+#include <mutex>
+using std::lock_guard;
+
+#include <string>
+using std::string;
+
+#include <utility>
+using std::move;
+
+#include <vector>
+using std::vector;
+
+namespace cbirdpp
+{
+
+  bool SingleFlight::join(const string& key, Completion done)
+  {
+    lock_guard<std::mutex> lock(flight_mutex);
+    vector<Completion>& waiters = calls[key];
+    waiters.push_back(move(done));
+    if(waiters.size() == 1) {return true;}
+    ++joined;
+    return false;
+  }
+
+  void SingleFlight::complete(const string& key, shared_ptr<const void> result, exception_ptr error)
+  {
+    vector<Completion> waiters;
+    {
+      lock_guard<std::mutex> lock(flight_mutex);
+      auto call = calls.find(key);
+      if(call == calls.end()) {return;}
+      waiters = move(call->second);
+      calls.erase(call);
+    }
+    // Outside the lock, a waiter may well start the next call for the same key.
+    for(Completion& done : waiters) {done(result, error);}
+  }
+
+  std::size_t SingleFlight::in_flight() const
+  {
+    lock_guard<std::mutex> lock(flight_mutex);
+    return calls.size();
+  }
+
+  std::size_t SingleFlight::coalesced() const
+  {
+    lock_guard<std::mutex> lock(flight_mutex);
+    return joined;
+  }
+
+}
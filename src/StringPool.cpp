@@ -0,0 +1,106 @@
+#include "../include/cbirdpp/StringPool.h"
+
+#include <algorithm>
+using std::max;
+
+#include <cstdint>
+using std::uint32_t;
+
+#include <cstring>
+using std::memcpy;
+
+#include <functional>
+using std::hash;
+
+#include <memory>
+using std::make_shared;
+using std::shared_ptr;
+
+#include <mutex>
+using std::lock_guard;
+
+#include <string_view>
+using std::string_view;
+
+#include <vector>
+using std::vector;
+
+namespace cbirdpp
+{
+
+  // The slots a pool starts out with.
+  const std::size_t INITIAL_SLOTS = 1024;
+
+  StringPool::StringPool() : slots(INITIAL_SLOTS, nullptr) {}
+
+  // The characters of a stored string are preceded by their size.
+  static string_view stored_text(const char* characters)
+  {
+    uint32_t size;
+    memcpy(&size, characters - sizeof(size), sizeof(size));
+    return string_view(characters, size);
+  }
+
+  const char** StringPool::slot(string_view text)
+  {
+    std::size_t mask = slots.size() - 1;
+    std::size_t position = hash<string_view>()(text) & mask;
+    while(slots[position] != nullptr && stored_text(slots[position]) != text) {position = (position + 1) & mask;}
+    return &slots[position];
+  }
+
+  void StringPool::grow()
+  {
+    vector<const char*> old(2 * slots.size(), nullptr);
+    old.swap(slots);
+    for(const char* characters : old) {
+      if(characters != nullptr) {*slot(stored_text(characters)) = characters;}
+    }
+  }
+
+  InternedString StringPool::intern(string_view text)
+  {
+    if(text.empty()) {return InternedString();}
+    lock_guard<std::mutex> lock(pool_mutex);
+    const char** found = slot(text);
+    if(*found != nullptr) {return InternedString(*found);}
+    uint32_t size = static_cast<uint32_t>(text.size());
+    std::size_t entry = sizeof(size) + text.size();
+    if(chunks.empty() || chunk_used + entry > CHUNK) {
+      // The rest of the current chunk is left unused, pooled strings are short compared to a chunk.
+      std::size_t chunk = max(CHUNK, entry);
+      chunks.emplace_back(new char[chunk]);
+      allocated += chunk;
+      chunk_used = 0;
+    }
+    char* copy = chunks.back().get() + chunk_used;
+    memcpy(copy, &size, sizeof(size));
+    memcpy(copy + sizeof(size), text.data(), text.size());
+    chunk_used += entry;
+    *found = copy + sizeof(size);
+    if(++stored * 2 > slots.size()) {grow();}
+    return InternedString(copy + sizeof(size));
+  }
+
+  std::size_t StringPool::size() const
+  {
+    lock_guard<std::mutex> lock(pool_mutex);
+    return stored;
+  }
+
+  std::size_t StringPool::bytes() const
+  {
+    lock_guard<std::mutex> lock(pool_mutex);
+    return allocated + slots.size() * sizeof(const char*);
+  }
+
+  InternedStrings::InternedStrings(std::size_t limit) : limit(limit), current(make_shared<StringPool>()) {}
+
+  shared_ptr<StringPool> InternedStrings::pool()
+  {
+    lock_guard<std::mutex> lock(current_mutex);
+    if(current->bytes() >= limit) {current = make_shared<StringPool>();}
+    return current;
+  }
+
+}
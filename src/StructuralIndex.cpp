@@ -0,0 +1,280 @@
+#include "../include/cbirdpp/StructuralIndex.h"
+#include "../include/cbirdpp/cbirdpp.h"
+
+#include <cstdint>
+using std::uint32_t;
+using std::uint64_t;
+
+#include <cstring>
+
+#include <limits>
+
+#include <string_view>
+using std::string_view;
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace cbirdpp
+{
+
+  // The text is classified this many bytes at a time, one bit per byte.
+  const std::size_t BLOCK = 64;
+
+  /*
+   * One bit per byte of a block for each class of character the index cares about.
+   */
+  struct BlockMasks
+  {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t structural;       // {}[]:,
+    uint64_t control;          // Below 0x20, not allowed inside strings.
+  };
+
+#if defined(__x86_64__) || defined(__i386__)
+
+  // One bit per byte of the two halves of a block where the comparison holds.
+  __attribute__((target("avx2"))) static uint64_t bits(__m256i low, __m256i high)
+  {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(low)) | static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(high))) << 32;
+  }
+
+  __attribute__((target("avx2"))) static __m256i structural_bytes(__m256i chunk)
+  {
+    __m256i brackets = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('{')),
+                                                       _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('}'))),
+                                       _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('[')),
+                                                       _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(']'))));
+    __m256i separators = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')),
+                                         _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(',')));
+    return _mm256_or_si256(brackets, separators);
+  }
+
+  // A byte is below 0x20 exactly when the unsigned maximum of it and 0x1F is 0x1F.
+  __attribute__((target("avx2"))) static __m256i control_bytes(__m256i chunk)
+  {
+    __m256i limit = _mm256_set1_epi8(0x1F);
+    return _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, limit), limit);
+  }
+
+  __attribute__((target("avx2"))) static BlockMasks classify_avx2(const char* block)
+  {
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    __m256i quote = _mm256_set1_epi8('"');
+    __m256i backslash = _mm256_set1_epi8('\\');
+    BlockMasks masks;
+    masks.quote = bits(_mm256_cmpeq_epi8(low, quote), _mm256_cmpeq_epi8(high, quote));
+    masks.backslash = bits(_mm256_cmpeq_epi8(low, backslash), _mm256_cmpeq_epi8(high, backslash));
+    masks.structural = bits(structural_bytes(low), structural_bytes(high));
+    masks.control = bits(control_bytes(low), control_bytes(high));
+    return masks;
+  }
+
+#endif
+
+#if defined(__SSE2__)
+
+  static __m128i structural_bytes(__m128i chunk)
+  {
+    __m128i brackets = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('{')),
+                                                 _mm_cmpeq_epi8(chunk, _mm_set1_epi8('}'))),
+                                    _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('[')),
+                                                 _mm_cmpeq_epi8(chunk, _mm_set1_epi8(']'))));
+    __m128i separators = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')),
+                                      _mm_cmpeq_epi8(chunk, _mm_set1_epi8(',')));
+    return _mm_or_si128(brackets, separators);
+  }
+
+  // A byte is below 0x20 exactly when the unsigned maximum of it and 0x1F is 0x1F.
+  static __m128i control_bytes(__m128i chunk)
+  {
+    __m128i limit = _mm_set1_epi8(0x1F);
+    return _mm_cmpeq_epi8(_mm_max_epu8(chunk, limit), limit);
+  }
+
+  static BlockMasks classify_sse2(const char* block)
+  {
+    BlockMasks masks{0, 0, 0, 0};
+    __m128i quote = _mm_set1_epi8('"');
+    __m128i backslash = _mm_set1_epi8('\\');
+    for(int i = 0; i < 4; ++i) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+      int shift = 16 * i;
+      masks.quote |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)))) << shift;
+      masks.backslash |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)))) << shift;
+      masks.structural |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(structural_bytes(chunk)))) << shift;
+      masks.control |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(control_bytes(chunk)))) << shift;
+    }
+    return masks;
+  }
+
+#else
+
+  static BlockMasks classify_scalar(const char* block)
+  {
+    BlockMasks masks{0, 0, 0, 0};
+    for(std::size_t i = 0; i < BLOCK; ++i) {
+      uint64_t bit = uint64_t(1) << i;
+      switch(block[i]) {
+        case '"': masks.quote |= bit; break;
+        case '\\': masks.backslash |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',': masks.structural |= bit; break;
+        default:
+          if(static_cast<unsigned char>(block[i]) < 0x20) {masks.control |= bit;}
+      }
+    }
+    return masks;
+  }
+
+#endif
+
+  // The bits of the characters escaped by a backslash. escaped_carry is set when the last byte of the previous block
+  // was an unescaped backslash, and is updated for the next block.
+  static uint64_t escaped_mask(uint64_t backslash, bool& escaped_carry)
+  {
+    uint64_t escaped = escaped_carry ? 1 : 0;
+    escaped_carry = false;
+    // Backslashes are rare in the API's responses, so they are simply walked in order.
+    while(backslash != 0) {
+      int bit = __builtin_ctzll(backslash);
+      backslash &= backslash - 1;
+      if(escaped & (uint64_t(1) << bit)) {continue;}
+      if(bit == 63) {
+        escaped_carry = true;
+      } else {
+        escaped |= uint64_t(1) << (bit + 1);
+      }
+    }
+    return escaped;
+  }
+
+  // Each bit set if an odd number of bits at or below it are set in quotes: the inside of strings and their opening
+  // quotes.
+  static uint64_t prefix_xor(uint64_t quotes)
+  {
+    quotes ^= quotes << 1;
+    quotes ^= quotes << 2;
+    quotes ^= quotes << 4;
+    quotes ^= quotes << 8;
+    quotes ^= quotes << 16;
+    quotes ^= quotes << 32;
+    return quotes;
+  }
+
+  // Fills offsets with the structural positions of text, classifying its blocks with Classify. It is inlined into
+  // each kernel, so the classifier is inlined as well, even where it needs an instruction set the build doesn't target.
+  template <BlockMasks (*Classify)(const char*)>
+  __attribute__((always_inline)) inline static bool index_blocks(string_view text, std::vector<uint32_t>& offsets)
+  {
+    bool backslashes = false;
+    bool escaped_carry = false;
+    uint64_t in_string_carry = 0;
+    char padded[BLOCK];
+    for(std::size_t start = 0; start < text.size(); start += BLOCK) {
+      const char* block = text.data() + start;
+      if(text.size() - start < BLOCK) {
+        // The last block is padded with whitespace, which is not indexed.
+        std::memset(padded, ' ', BLOCK);
+        std::memcpy(padded, block, text.size() - start);
+        block = padded;
+      }
+      BlockMasks masks = Classify(block);
+      backslashes = backslashes || masks.backslash != 0;
+      uint64_t quote = masks.quote & ~escaped_mask(masks.backslash, escaped_carry);
+      uint64_t in_string = prefix_xor(quote) ^ in_string_carry;
+      in_string_carry = (in_string >> 63) ? ~uint64_t(0) : 0;
+      if(masks.control & in_string) {throw RequestFailed();}
+
+      for(uint64_t found = quote | (masks.structural & ~in_string); found != 0; found &= found - 1) {
+        offsets.push_back(static_cast<uint32_t>(start + __builtin_ctzll(found)));
+      }
+    }
+    if(in_string_carry != 0) {throw RequestFailed();}
+    return backslashes;
+  }
+
+#if defined(__x86_64__) || defined(__i386__)
+  __attribute__((target("avx2"))) static bool index_avx2(string_view text, std::vector<uint32_t>& offsets)
+  {
+    return index_blocks<classify_avx2>(text, offsets);
+  }
+#endif
+
+  static bool index_baseline(string_view text, std::vector<uint32_t>& offsets)
+  {
+#if defined(__SSE2__)
+    return index_blocks<classify_sse2>(text, offsets);
+#else
+    return index_blocks<classify_scalar>(text, offsets);
+#endif
+  }
+
+  using IndexKernel = bool (*)(string_view, std::vector<uint32_t>&);
+
+  // The kernel for this CPU, chosen on first use: AVX2 if the CPU has it, whatever the build targets, and SSE2 or
+  // plain loops otherwise.
+  static IndexKernel index_kernel()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    static const IndexKernel kernel = __builtin_cpu_supports("avx2") ? index_avx2 : index_baseline;
+    return kernel;
+#else
+    return index_baseline;
+#endif
+  }
+
+  const char* StructuralIndex::implementation()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    if(index_kernel() == index_avx2) {return "avx2";}
+#endif
+#if defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+  }
+
+  StructuralIndex::StructuralIndex(string_view text)
+  {
+    assign(text);
+  }
+
+  void StructuralIndex::assign(string_view text)
+  {
+    offsets.clear();
+    backslashes = false;
+    if(text.size() > std::numeric_limits<uint32_t>::max()) {throw RequestFailed();}
+    // Compact API responses have about one entry for every four bytes, growing the index as it fills costs far more
+    // than sizing it for the common case up front. Reserving leaves the memory untouched until entries are added.
+    offsets.reserve(text.size() / 3 + BLOCK);
+    try {
+      backslashes = index_kernel()(text, offsets);
+    } catch(...) {
+      offsets.clear();
+      throw;
+    }
+  }
+
+  // The memory of the largest index retired on this thread, which the next recycled index takes over.
+  static thread_local std::vector<uint32_t> spare_offsets;
+
+  StructuralIndex StructuralIndex::recycled(string_view text)
+  {
+    StructuralIndex index;
+    index.offsets.swap(spare_offsets);
+    index.assign(text);
+    return index;
+  }
+
+  void StructuralIndex::retire(StructuralIndex&& index)
+  {
+    if(index.offsets.capacity() > spare_offsets.capacity()) {spare_offsets.swap(index.offsets);}
+    index.offsets.clear();
+    index.backslashes = false;
+  }
+
+}
@@ -0,0 +1,184 @@
+#include "../include/cbirdpp/Timestamp.h"
+#include "../include/cbirdpp/ParameterExceptions.h"
+
+#include <cstdint>
+using std::int16_t;
+using std::int32_t;
+
+#include <string>
+using std::string;
+
+#include <string_view>
+using std::string_view;
+
+namespace cbirdpp
+{
+
+  static const char* const MONTH_NAMES[12] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                              "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+  static bool leap_year(int year)
+  {
+    return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+  }
+
+  static unsigned int days_in_month(int year, unsigned int month)
+  {
+    static const unsigned int DAYS[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return month == 2 && leap_year(year) ? 29 : DAYS[month - 1];
+  }
+
+  static bool valid_date(int year, unsigned int month, unsigned int day)
+  {
+    return year >= 1 && year <= 9999 && month >= 1 && month <= 12 && day >= 1 && day <= days_in_month(year, month);
+  }
+
+  // Days since 1970-01-01 of a date in the proleptic Gregorian calendar, counted in 400 year eras of 146097 days that
+  // start on the 1st of March, so the leap day is the last day of an era's year.
+  static int32_t days_from_civil(int year, unsigned int month, unsigned int day)
+  {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    unsigned int year_of_era = static_cast<unsigned int>(year - era * 400);
+    unsigned int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<int32_t>(day_of_era) - 719468;
+  }
+
+  // The inverse of days_from_civil.
+  static void civil_from_days(int32_t days, int& year, unsigned int& month, unsigned int& day)
+  {
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned int day_of_era = static_cast<unsigned int>(days - era * 146097);
+    unsigned int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    unsigned int day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    unsigned int shifted_month = (5 * day_of_year + 2) / 153;
+    day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    year = static_cast<int>(year_of_era) + era * 400 + (month <= 2);
+  }
+
+  // Reads count decimal digits of text from position into value, false if one of them isn't a digit.
+  static bool read_digits(string_view text, std::size_t position, std::size_t count, unsigned int& value)
+  {
+    value = 0;
+    for(std::size_t i = position; i < position + count; ++i) {
+      if(text[i] < '0' || text[i] > '9') {return false;}
+      value = value * 10 + static_cast<unsigned int>(text[i] - '0');
+    }
+    return true;
+  }
+
+  // "2018-01-01" into days.
+  static bool parse_iso_date(string_view text, int32_t& days)
+  {
+    unsigned int year, month, day;
+    if(text.size() != 10 || text[4] != '-' || text[7] != '-' || !read_digits(text, 0, 4, year) ||
+       !read_digits(text, 5, 2, month) || !read_digits(text, 8, 2, day) || !valid_date(static_cast<int>(year), month, day)) {
+      return false;
+    }
+    days = days_from_civil(static_cast<int>(year), month, day);
+    return true;
+  }
+
+  // "23:51", or "8:00", into minutes since midnight.
+  static bool parse_clock(string_view text, int16_t& minutes)
+  {
+    std::size_t colon = text.size() - 3;
+    unsigned int hour, minute;
+    if(text.size() < 4 || text.size() > 5 || text[colon] != ':' || !read_digits(text, 0, colon, hour) ||
+       !read_digits(text, colon + 1, 2, minute) || hour > 23 || minute > 59) {
+      return false;
+    }
+    minutes = static_cast<int16_t>(hour * 60 + minute);
+    return true;
+  }
+
+  Timestamp::Timestamp(int year, unsigned int month, unsigned int day)
+  {
+    if(year < 1 || year > 9999) {throw ArgumentOutOfRange<int>(year);}
+    if(month < 1 || month > 12) {throw ArgumentOutOfRange<unsigned int>(month);}
+    if(!valid_date(year, month, day)) {throw ArgumentOutOfRange<unsigned int>(day);}
+    day_number = days_from_civil(year, month, day);
+  }
+
+  Timestamp::Timestamp(int year, unsigned int month, unsigned int day, unsigned int hour, unsigned int minute)
+    : Timestamp(year, month, day)
+  {
+    if(hour > 23) {throw ArgumentOutOfRange<unsigned int>(hour);}
+    if(minute > 59) {throw ArgumentOutOfRange<unsigned int>(minute);}
+    minute_number = static_cast<int16_t>(hour * 60 + minute);
+  }
+
+  bool Timestamp::parse(string_view text, Timestamp& target)
+  {
+    int32_t days;
+    int16_t minutes = -1;
+    if(!parse_iso_date(text.substr(0, 10), days)) {return false;}
+    if(text.size() > 10 && (text[10] != ' ' || !parse_clock(text.substr(11), minutes))) {return false;}
+    target.day_number = days;
+    target.minute_number = minutes;
+    return true;
+  }
+
+  bool Timestamp::parse_date(string_view text, Timestamp& target)
+  {
+    if(text.size() == 10 && text[4] == '-') {return parse_iso_date(text, target.day_number);}
+    // "1 Jan 2018", the day has one or two digits.
+    std::size_t space = text.find(' ');
+    unsigned int day, year;
+    if(space == string_view::npos || space == 0 || space > 2 || text.size() != space + 9 || text[space + 4] != ' ' ||
+       !read_digits(text, 0, space, day) || !read_digits(text, space + 5, 4, year)) {
+      return false;
+    }
+    string_view name = text.substr(space + 1, 3);
+    unsigned int month = 0;
+    while(month < 12 && name != MONTH_NAMES[month]) {++month;}
+    if(month == 12 || !valid_date(static_cast<int>(year), month + 1, day)) {return false;}
+    target.day_number = days_from_civil(static_cast<int>(year), month + 1, day);
+    return true;
+  }
+
+  bool Timestamp::parse_time(string_view text, Timestamp& target)
+  {
+    return parse_clock(text, target.minute_number);
+  }
+
+  int Timestamp::year() const
+  {
+    int year;
+    unsigned int month, day;
+    civil_from_days(day_number, year, month, day);
+    return year;
+  }
+
+  unsigned int Timestamp::month() const
+  {
+    int year;
+    unsigned int month, day;
+    civil_from_days(day_number, year, month, day);
+    return month;
+  }
+
+  unsigned int Timestamp::day() const
+  {
+    int year;
+    unsigned int month, day;
+    civil_from_days(day_number, year, month, day);
+    return day;
+  }
+
+  string Timestamp::to_string() const
+  {
+    int year;
+    unsigned int month, day;
+    civil_from_days(day_number, year, month, day);
+    char text[16] = {char('0' + year / 1000 % 10), char('0' + year / 100 % 10), char('0' + year / 10 % 10),
+                     char('0' + year % 10), '-', char('0' + month / 10), char('0' + month % 10), '-',
+                     char('0' + day / 10), char('0' + day % 10), ' ', char('0' + hour() / 10), char('0' + hour() % 10),
+                     ':', char('0' + minute() / 10), char('0' + minute() % 10)};
+    return string(text, has_time() ? 16 : 10);
+  }
+
+}
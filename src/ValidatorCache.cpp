@@ -0,0 +1,66 @@
+#include "../include/cbirdpp/ValidatorCache.h"
+
+#include <list>
+using std::list;
+
+#include <memory>
+using std::make_shared;
+using std::shared_ptr;
+
+#include <mutex>
+using std::lock_guard;
+
+#include <string>
+using std::string;
+
+#include <utility>
+using std::move;
+
+namespace cbirdpp
+{
+
+  list<string> ValidatorCache::Entry::conditions() const
+  {
+    list<string> headers;
+    if(!etag.empty()) {headers.push_back("If-None-Match: " + etag);}
+    if(!last_modified.empty()) {headers.push_back("If-Modified-Since: " + last_modified);}
+    return headers;
+  }
+
+  ValidatorCache::ValidatorCache(std::size_t capacity) : capacity(capacity) {}
+
+  shared_ptr<const ValidatorCache::Entry> ValidatorCache::find(const string& key)
+  {
+    lock_guard<std::mutex> lock(cache_mutex);
+    auto found = index.find(key);
+    if(found == index.end()) {return nullptr;}
+    recent.splice(recent.begin(), recent, found->second);
+    return found->second->second;
+  }
+
+  void ValidatorCache::store(const string& key, Entry entry)
+  {
+    if(capacity == 0) {return;}
+    auto stored = make_shared<const Entry>(move(entry));
+    lock_guard<std::mutex> lock(cache_mutex);
+    auto found = index.find(key);
+    if(found != index.end()) {
+      found->second->second = move(stored);
+      recent.splice(recent.begin(), recent, found->second);
+      return;
+    }
+    recent.emplace_front(key, move(stored));
+    index[key] = recent.begin();
+    if(recent.size() > capacity) {
+      index.erase(recent.back().first);
+      recent.pop_back();
+    }
+  }
+
+  std::size_t ValidatorCache::size() const
+  {
+    lock_guard<std::mutex> lock(cache_mutex);
+    return recent.size();
+  }
+
+}
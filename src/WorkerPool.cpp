@@ -0,0 +1,122 @@
+#include "../include/cbirdpp/WorkerPool.h"
+
+#include <algorithm>
+
+#include <atomic>
+using std::atomic;
+
+#include <condition_variable>
+
+#include <exception>
+using std::exception_ptr;
+
+#include <functional>
+using std::function;
+
+#include <memory>
+using std::make_shared;
+
+#include <mutex>
+using std::lock_guard;
+using std::unique_lock;
+
+#include <thread>
+using std::thread;
+
+#include <utility>
+using std::move;
+
+namespace cbirdpp
+{
+
+  WorkerPool::WorkerPool(unsigned int threads)
+  : thread_count(threads != 0 ? threads : std::max(1u, thread::hardware_concurrency())) {}
+
+  WorkerPool::~WorkerPool()
+  {
+    {
+      lock_guard<std::mutex> lock(queue_mutex);
+      stopping = true;
+    }
+    queued.notify_all();
+    for(thread& worker : threads) {worker.join();}
+  }
+
+  void WorkerPool::post(function<void()> task)
+  {
+    {
+      lock_guard<std::mutex> lock(queue_mutex);
+      start();
+      tasks.push_back(move(task));
+    }
+    queued.notify_one();
+  }
+
+  /*
+   * The tasks of one call to run(), taken by index by whichever thread gets to them first. A thread of the pool may
+   * only get to the batch after run() has returned, so the batch is shared with them.
+   */
+  struct RunBatch
+  {
+    atomic<std::size_t> next{0};
+    std::size_t count = 0;
+    const function<void(std::size_t)>* task = nullptr;     // Only used for an index below count, while run() waits.
+    std::mutex done_mutex;
+    std::condition_variable all_done;
+    std::size_t finished = 0;
+    exception_ptr error;
+  };
+
+  // Takes tasks of the batch until none are left.
+  static void take_tasks(RunBatch& batch)
+  {
+    for(std::size_t i = batch.next++; i < batch.count; i = batch.next++) {
+      exception_ptr error;
+      try {
+        (*batch.task)(i);
+      } catch(...) {
+        error = std::current_exception();
+      }
+      lock_guard<std::mutex> lock(batch.done_mutex);
+      if(error && !batch.error) {batch.error = error;}
+      if(++batch.finished == batch.count) {batch.all_done.notify_all();}
+    }
+  }
+
+  void WorkerPool::run(std::size_t count, const function<void(std::size_t)>& task)
+  {
+    if(count == 0) {return;}
+    auto batch = make_shared<RunBatch>();
+    batch->count = count;
+    batch->task = &task;
+    for(std::size_t helpers = std::min<std::size_t>(count - 1, thread_count); helpers > 0; --helpers) {
+      post([batch] { take_tasks(*batch); });
+    }
+    take_tasks(*batch);
+    unique_lock<std::mutex> lock(batch->done_mutex);
+    batch->all_done.wait(lock, [&batch] { return batch->finished == batch->count; });
+    if(batch->error) {std::rethrow_exception(batch->error);}
+  }
+
+  void WorkerPool::start()
+  {
+    if(!threads.empty()) {return;}
+    for(unsigned int i = 0; i < thread_count; ++i) {threads.emplace_back(&WorkerPool::work, this);}
+  }
+
+  void WorkerPool::work()
+  {
+    for(;;) {
+      function<void()> task;
+      {
+        unique_lock<std::mutex> lock(queue_mutex);
+        queued.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if(tasks.empty()) {return;}
+        task = move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+}
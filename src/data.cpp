@@ -1,21 +1,42 @@
 #include "../include/cbirdpp/cbirdpp.h"
+#include "../include/cbirdpp/FieldTable.h"
 using cbirdpp::Observation;
 using cbirdpp::DetailedObservation;
+using cbirdpp::ObservationView;
+using cbirdpp::ObservationViews;
+using cbirdpp::InternedDetailedObservation;
+using cbirdpp::InternedDetailedObservations;
+using cbirdpp::InternedObservation;
+using cbirdpp::InternedObservations;
+using cbirdpp::ArenaDetailedObservation;
+using cbirdpp::ArenaDetailedObservations;
+using cbirdpp::ArenaObservation;
+using cbirdpp::ArenaObservations;
 
 #include <curlpp/cURLpp.hpp>
 #include <curlpp/Easy.hpp>
 #include <curlpp/Options.hpp>
 
-#include "../include/nlohmann/json.hpp"
-using nlohmann::json;
-
 #include <iostream> //NOLINT
 using std::cout; //NOLINT
 using std::endl; //NOLINT
 
+#include <functional>
+using std::function;
+
+#include <future>
+using std::future;
+
+#include <memory>
+using std::make_shared;
+using std::shared_ptr;
+
 #include <string>
 using std::string;
 
+#include <string_view>
+using std::string_view;
+
 #include <sstream>
 using std::ostringstream;
 using std::stringstream;
@@ -23,175 +44,459 @@ using std::stringstream;
 #include <vector>
 using std::vector;
 
-const string OBSURL = "https://ebird.org/ws2.0/data/obs/";
+const string OBSURL = "data/obs/";
 
-using nlohmann::json;
+using cbirdpp::JsonReader;
+using cbirdpp::Fields;
 
 namespace cbirdpp
 {
 
-  void from_json(const json& source, Observation& target)
-  {
-    target.speciesCode = source.at("speciesCode").get<string>();
-    target.comName = source.at("comName").get<string>();
-    target.sciName = source.at("sciName").get<string>();
-    target.locId = source.at("locId").get<string>();
-    target.locName = source.at("locName").get<string>();
-    target.obsDt = source.at("obsDt").get<string>();
-    if(source.find("howMany") == source.end()) {
-      target.howMany = 0;   // Represents an 'x' input for the observation
-    } else {
-      target.howMany = source.at("howMany").get<unsigned int>();
-    }
-    target.lat = source.at("lat").get<double>();
-    target.lng = source.at("lng").get<double>();
-    target.obsValid = source.at("obsValid").get<bool>();
-    target.obsReviewed = source.at("obsReviewed").get<bool>();
-    target.locationPrivate = source.at("locationPrivate").get<bool>();
-  }
-
-  void from_json(const json& source, DetailedObservation& target)
-  {
-    Observation *downcast = &target;
-    from_json(source, *downcast);
-    target.checklistId = source.at("checklistId").get<string>();
-    target.countryCode = source.at("countryCode").get<string>();
-    target.countryName = source.at("countryName").get<string>();
-    if(source.find("firstName") == source.end()) {
-      target.firstName = "N/A";
-    } else {
-      target.firstName = source.at("firstName").get<string>();
-    }
-    target.hasComments = source.at("hasComments").get<bool>();
-    target.hasRichMedia = source.at("hasRichMedia").get<bool>();
-    if(source.find("firstName") == source.end()) {
-      target.lastName = "N/A";
-    } else {
-      target.lastName = source.at("lastName").get<string>();
-    }
-    target.hasComments = source.at("hasComments").get<bool>();
-    target.locID = source.at("locID").get<string>();
-    target.obsId = source.at("obsId").get<string>();
-    target.presenceNoted = source.at("presenceNoted").get<bool>();
-    target.subId = source.at("subId").get<string>();
-    target.subnational1Code = source.at("subnational1Code").get<string>();
-    target.subnational1Name = source.at("subnational1Name").get<string>();
-    target.subnational2Code = source.at("subnational2Code").get<string>();
-    target.subnational2Name = source.at("subnational2Name").get<string>();
-    if(source.find("userDisplayName") == source.end()) {
-      target.userDisplayName = "N/A";
-    } else {
-      target.userDisplayName = source.at("userDisplayName").get<string>();
-    }
+  // The fields of an Observation, or of an ObservationView or InternedObservation with their kind of Text, followed by
+  // extra. Positions are the bits of ObservationFields.
+  template <typename Row, typename Text, typename... Extra>
+  static constexpr auto observation_table(const Extra&... extra)
+  {
+    using F = Fields<Row, Text>;
+    return make_field_table(F::field("speciesCode", &Row::speciesCode), F::field("comName", &Row::comName),
+                            F::field("sciName", &Row::sciName), F::field("locId", &Row::locId),
+                            F::field("locName", &Row::locName), F::field("obsDt", &Row::obsDt),
+                            F::optional("howMany", &Row::howMany, 0),   // Missing for an 'x' input.
+                            F::field("lat", &Row::lat), F::field("lng", &Row::lng),
+                            F::field("obsValid", &Row::obsValid), F::field("obsReviewed", &Row::obsReviewed),
+                            F::field("locationPrivate", &Row::locationPrivate), extra...);
+  }
+
+  // The fields of a DetailedObservation, or of an InternedDetailedObservation when Text is an InternedString.
+  template <typename Row, typename Text>
+  static constexpr auto detailed_observation_table()
+  {
+    using F = Fields<Row, Text>;
+    return observation_table<Row, Text>(F::field("checklistId", &Row::checklistId), F::field("countryCode", &Row::countryCode),
+                                        F::field("countryName", &Row::countryName),
+                                        F::optional("firstName", &Row::firstName, "N/A"),
+                                        F::field("hasComments", &Row::hasComments), F::field("hasRichMedia", &Row::hasRichMedia),
+                                        F::optional("lastName", &Row::lastName, "N/A"), F::field("locID", &Row::locID),
+                                        F::field("obsId", &Row::obsId), F::field("presenceNoted", &Row::presenceNoted),
+                                        F::field("subId", &Row::subId), F::field("subnational1Code", &Row::subnational1Code),
+                                        F::field("subnational1Name", &Row::subnational1Name),
+                                        F::field("subnational2Code", &Row::subnational2Code),
+                                        F::field("subnational2Name", &Row::subnational2Name),
+                                        F::optional("userDisplayName", &Row::userDisplayName, "N/A"));
   }
 
-  Observations Requester::get_recent_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  static constexpr auto OBSERVATION_TABLE = observation_table<Observation, string>();
+  static constexpr auto OBSERVATION_VIEW_TABLE = observation_table<ObservationView, string_view>();
+  static constexpr auto DETAILED_OBSERVATION_TABLE = detailed_observation_table<DetailedObservation, string>();
+  static constexpr auto INTERNED_OBSERVATION_TABLE = observation_table<InternedObservation, InternedString>();
+  static constexpr auto INTERNED_DETAILED_OBSERVATION_TABLE = detailed_observation_table<InternedDetailedObservation, InternedString>();
+  static constexpr auto ARENA_OBSERVATION_TABLE = observation_table<ArenaObservation, std::pmr::string>();
+  static constexpr auto ARENA_DETAILED_OBSERVATION_TABLE = detailed_observation_table<ArenaDetailedObservation, std::pmr::string>();
+
+  static_assert(OBSERVATION_TABLE.size() == 12 && 1ul << OBSERVATION_TABLE.find("locationPrivate") == ObservationFields::locationPrivate);
+  static_assert(DETAILED_OBSERVATION_TABLE.size() == 28 && 1ul << DETAILED_OBSERVATION_TABLE.find("userDisplayName") == ObservationFields::userDisplayName);
+
+  // Reads a string value into an owned field.
+  static auto owned_text(JsonReader& source)
+  {
+    return [&source](string& field) { source.read_string(field); };
+  }
+
+  void read_json(JsonReader& source, Observation& target, unsigned long fields)
+  {
+    if(!read_fields(source, target, OBSERVATION_TABLE, fields, owned_text(source))) {throw RequestFailed();}
+  }
+
+  void read_json(JsonReader& source, Observation& target)
+  {
+    read_json(source, target, ObservationFields::all);
+  }
+
+  void read_json(JsonReader& source, DetailedObservation& target, unsigned long fields)
+  {
+    if(!read_fields(source, target, DETAILED_OBSERVATION_TABLE, fields, owned_text(source))) {throw RequestFailed();}
+  }
+
+  void read_json(JsonReader& source, DetailedObservation& target)
+  {
+    read_json(source, target, ObservationFields::all);
+  }
+
+  void read_json(JsonReader& source, ArenaObservation& target, unsigned long fields)
+  {
+    if(!read_fields(source, target, ARENA_OBSERVATION_TABLE, fields)) {throw RequestFailed();}
+  }
+
+  void read_json(JsonReader& source, ArenaDetailedObservation& target, unsigned long fields)
+  {
+    if(!read_fields(source, target, ARENA_DETAILED_OBSERVATION_TABLE, fields)) {throw RequestFailed();}
+  }
+
+  // A decoder for the rows of a response that reads only the given fields of each row, large responses are read on
+  // the threads of workers as the options allow. Decoders run on the Requester's thread or on workers itself, so the
+  // pool outlives them.
+  template <typename Container, typename Base>
+  static auto projected(unsigned long fields, const RequesterOptions& options, WorkerPool* workers)
+  {
+    std::size_t threshold = std::size_t(options.parallel_decode()) * 1024;
+    return [fields, threshold, workers](string_view body) {
+      auto read_row = [fields](JsonReader& source, Base& row) { read_json(source, row, fields); };
+      return read_rows<Container>(body, read_row, threshold, workers);
+    };
+  }
+
+  // Reads only the given fields of a row, for the rows of a response that are handed out one by one.
+  template <typename Row>
+  static auto row_reader(unsigned long fields)
+  {
+    return [fields](JsonReader& source, Row& row) { read_json(source, row, fields); };
+  }
+
+  // A decoder for the rows of an observation response that reads only the given fields of each row and leaves out the
+  // rows that don't read, without throwing.
+  template <typename Rows, typename Table>
+  static auto checked_projected(const Table& table, unsigned long fields)
+  {
+    return [&table, fields](string_view body) {
+      auto read_row = [&table, fields](JsonReader& source, typename Rows::value_type& row) {
+        return read_fields(source, row, table, fields, owned_text(source));
+      };
+      return read_checked_rows<Rows>(body, read_row);
+    };
+  }
+
+  // A decoder for the rows of an observation response as views into the body, which the result keeps alive.
+  static auto projected_views(unsigned long fields)
+  {
+    return [fields](string body) {
+      auto text = make_shared<ObservationViews::Text>();
+      text->body = std::move(body);
+      ObservationViews result;
+      JsonReader source(text->body);
+      string decoded;
+      // Strings without escapes are viewed where they are, only the others are kept in decoded copies.
+      auto view_text = [&source, &text, &decoded](string_view& field) {
+        field = source.read_string_view(decoded);
+        if(!decoded.empty() && field.data() == decoded.data()) {
+          text->unescaped.push_back(std::move(decoded));
+          field = text->unescaped.back();
+          decoded.clear();
+        }
+      };
+      source.begin_array();
+      while(source.next_element()) {
+        if(!read_fields(source, result.emplace_back(), OBSERVATION_VIEW_TABLE, fields, view_text)) {throw RequestFailed();}
+      }
+      source.finish();
+      result.text = std::move(text);
+      return result;
+    };
+  }
+
+  // A decoder for the rows of an observation response with their text interned into the current pool of strings,
+  // which the result keeps alive instead of the body. The pool is shared by the threads reading a large response.
+  template <typename Rows, typename Table>
+  static auto interned_rows(shared_ptr<InternedStrings> strings, const Table& table, unsigned long fields,
+                            const RequesterOptions& options, WorkerPool* workers)
+  {
+    std::size_t threshold = std::size_t(options.parallel_decode()) * 1024;
+    return [strings, &table, fields, threshold, workers](string_view body) {
+      shared_ptr<StringPool> pool = strings->pool();
+      auto fallback = [&pool](string_view text) { return pool->intern(text); };
+      auto read_row = [&pool, &table, fields, &fallback](JsonReader& source, typename Rows::value_type& row) {
+        auto intern_text = [&source, &pool](InternedString& field) {
+          field = pool->intern(source.read_string_view(decode_buffer()));
+        };
+        if(!read_fields(source, row, table, fields, intern_text, fallback)) {throw RequestFailed();}
+      };
+      Rows result = read_rows<Rows>(body, read_row, threshold, workers);
+      result.pool = std::move(pool);
+      return result;
+    };
+  }
+
+  string Requester::recent_observations_in_region_url(const string& regionCode, const DataOptionalParameters& params) const
   {
     vector<string> args = process_args({DataParams::back, DataParams::cat, DataParams::maxResults, DataParams::includeProvisional, DataParams::hotspot}, params);
-    string request_url = OBSURL + regionCode + "/recent" + generate_argument_string(args);
-    json response = request_json(request_url);
-    auto observs = json_to_object<Observations, Observation>(response);
-    return observs;
+    return options.api_url() + OBSURL + regionCode + "/recent" + generate_argument_string(args);
+  }
+
+  Observations Requester::get_recent_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return request<Observations>(recent_observations_in_region_url(regionCode, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  future<Observations> Requester::async_get_recent_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<Observations>(recent_observations_in_region_url(regionCode, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  ObservationViews Requester::view_recent_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return request<ObservationViews>(recent_observations_in_region_url(regionCode, params), projected_views(params.fields()), Endpoint::observations, params.fields());
+  }
+
+  future<ObservationViews> Requester::async_view_recent_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<ObservationViews>(recent_observations_in_region_url(regionCode, params), projected_views(params.fields()), Endpoint::observations, params.fields());
+  }
+
+  InternedObservations Requester::intern_recent_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return request<InternedObservations>(recent_observations_in_region_url(regionCode, params), interned_rows<InternedObservations>(interned, INTERNED_OBSERVATION_TABLE, params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  future<InternedObservations> Requester::async_intern_recent_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<InternedObservations>(recent_observations_in_region_url(regionCode, params), interned_rows<InternedObservations>(interned, INTERNED_OBSERVATION_TABLE, params.fields(), options, workers.get()), Endpoint::observations, params.fields());
   }
 
-  json Requester::get_recent_notable_setup(const string& regionCode, const DataOptionalParameters& params, bool detailed/*=false*/) const
+  ArenaObservations Requester::arena_recent_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return request<ArenaObservations>(recent_observations_in_region_url(regionCode, params), json_to_arena_fields<ArenaObservations>(params.fields()), Endpoint::observations, params.fields());
+  }
+
+  future<ArenaObservations> Requester::async_arena_recent_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<ArenaObservations>(recent_observations_in_region_url(regionCode, params), json_to_arena_fields<ArenaObservations>(params.fields()), Endpoint::observations, params.fields());
+  }
+
+  Checked<Observations> Requester::checked_recent_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return request<Checked<Observations>>(recent_observations_in_region_url(regionCode, params), checked_projected<Observations>(OBSERVATION_TABLE, params.fields()), Endpoint::observations, params.fields());
+  }
+
+  future<Checked<Observations>> Requester::async_checked_recent_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<Checked<Observations>>(recent_observations_in_region_url(regionCode, params), checked_projected<Observations>(OBSERVATION_TABLE, params.fields()), Endpoint::observations, params.fields());
+  }
+
+  void Requester::for_each_recent_observations_in_region(const string& regionCode, const function<void(const Observation&)>& each, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    for_each_row<Observation>(recent_observations_in_region_url(regionCode, params), Endpoint::observations, row_reader<Observation>(params.fields()), each);
+  }
+
+  string Requester::recent_notable_url(const string& regionCode, const DataOptionalParameters& params, bool detailed/*=false*/) const
   {
     vector<string> args = process_args({DataParams::back, DataParams::maxResults, DataParams::hotspot}, params, detailed);
-    string request_url = OBSURL + regionCode + "/recent/notable" + generate_argument_string(args);
-    return request_json(request_url);
+    return options.api_url() + OBSURL + regionCode + "/recent/notable" + generate_argument_string(args);
   }
 
   Observations Requester::get_recent_notable_observations_in_region(const string& regionCode, const DataOptionalParameters& params) const
   {
-    json response = get_recent_notable_setup(regionCode, params);
-    auto observs = json_to_object<Observations, Observation>(response);
-    return observs;
+    return request<Observations>(recent_notable_url(regionCode, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  future<Observations> Requester::async_get_recent_notable_observations_in_region(const string& regionCode, const DataOptionalParameters& params) const
+  {
+    return async_request<Observations>(recent_notable_url(regionCode, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  void Requester::for_each_recent_notable_observations_in_region(const string& regionCode, const function<void(const Observation&)>& each, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    for_each_row<Observation>(recent_notable_url(regionCode, params), Endpoint::observations, row_reader<Observation>(params.fields()), each);
   }
   
   DetailedObservations Requester::get_detailed_recent_notable_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
   {
-    json response = get_recent_notable_setup(regionCode, params, true);
-    auto observs = json_to_object<DetailedObservations, DetailedObservation>(response);
-    return observs;
+    return request<DetailedObservations>(recent_notable_url(regionCode, params, true), projected<DetailedObservations, DetailedObservation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
   }
 
-  Observations Requester::get_recent_observations_of_species_in_region(const std::string& regionCode, const std::string& speciesCode, const DataOptionalParameters& params/*defaults*/) const
+  future<DetailedObservations> Requester::async_get_detailed_recent_notable_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<DetailedObservations>(recent_notable_url(regionCode, params, true), projected<DetailedObservations, DetailedObservation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  InternedDetailedObservations Requester::intern_detailed_recent_notable_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return request<InternedDetailedObservations>(recent_notable_url(regionCode, params, true), interned_rows<InternedDetailedObservations>(interned, INTERNED_DETAILED_OBSERVATION_TABLE, params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  future<InternedDetailedObservations> Requester::async_intern_detailed_recent_notable_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<InternedDetailedObservations>(recent_notable_url(regionCode, params, true), interned_rows<InternedDetailedObservations>(interned, INTERNED_DETAILED_OBSERVATION_TABLE, params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  ArenaDetailedObservations Requester::arena_detailed_recent_notable_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return request<ArenaDetailedObservations>(recent_notable_url(regionCode, params, true), json_to_arena_fields<ArenaDetailedObservations>(params.fields()), Endpoint::observations, params.fields());
+  }
+
+  future<ArenaDetailedObservations> Requester::async_arena_detailed_recent_notable_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<ArenaDetailedObservations>(recent_notable_url(regionCode, params, true), json_to_arena_fields<ArenaDetailedObservations>(params.fields()), Endpoint::observations, params.fields());
+  }
+
+  Checked<DetailedObservations> Requester::checked_detailed_recent_notable_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return request<Checked<DetailedObservations>>(recent_notable_url(regionCode, params, true), checked_projected<DetailedObservations>(DETAILED_OBSERVATION_TABLE, params.fields()), Endpoint::observations, params.fields());
+  }
+
+  future<Checked<DetailedObservations>> Requester::async_checked_detailed_recent_notable_observations_in_region(const string& regionCode, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<Checked<DetailedObservations>>(recent_notable_url(regionCode, params, true), checked_projected<DetailedObservations>(DETAILED_OBSERVATION_TABLE, params.fields()), Endpoint::observations, params.fields());
+  }
+
+  void Requester::for_each_detailed_recent_notable_observations_in_region(const string& regionCode, const function<void(const DetailedObservation&)>& each, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    for_each_row<DetailedObservation>(recent_notable_url(regionCode, params, true), Endpoint::observations, row_reader<DetailedObservation>(params.fields()), each);
+  }
+
+  string Requester::recent_observations_of_species_in_region_url(const string& regionCode, const string& speciesCode, const DataOptionalParameters& params) const
   {
     vector<string> args = process_args({DataParams::back, DataParams::maxResults, DataParams::includeProvisional, DataParams::hotspot}, params);
-    string request_url = OBSURL + regionCode + "/recent/" + speciesCode + generate_argument_string(args);
-    json response = request_json(request_url);
-    auto observs = json_to_object<Observations, Observation>(response);
-    return observs;
+    return options.api_url() + OBSURL + regionCode + "/recent/" + speciesCode + generate_argument_string(args);
   }
 
-  Observations Requester::get_recent_nearby_observations(const double lat, const double lng, const DataOptionalParameters& params) const
+  Observations Requester::get_recent_observations_of_species_in_region(const std::string& regionCode, const std::string& speciesCode, const DataOptionalParameters& params/*defaults*/) const
+  {
+    return request<Observations>(recent_observations_of_species_in_region_url(regionCode, speciesCode, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  future<Observations> Requester::async_get_recent_observations_of_species_in_region(const std::string& regionCode, const std::string& speciesCode, const DataOptionalParameters& params/*defaults*/) const
+  {
+    return async_request<Observations>(recent_observations_of_species_in_region_url(regionCode, speciesCode, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  void Requester::for_each_recent_observations_of_species_in_region(const string& regionCode, const string& speciesCode, const function<void(const Observation&)>& each, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    for_each_row<Observation>(recent_observations_of_species_in_region_url(regionCode, speciesCode, params), Endpoint::observations, row_reader<Observation>(params.fields()), each);
+  }
+
+  string Requester::recent_nearby_observations_url(const double lat, const double lng, const DataOptionalParameters& params) const
   {
     vector<string> args = process_args({DataParams::dist, DataParams::back, DataParams::cat, DataParams::maxResults, DataParams::includeProvisional, DataParams::hotspot, DataParams::sort}, params, lat, lng);
-    string request_url = OBSURL + "geo/recent" + generate_argument_string(args);
-    json response = request_json(request_url);
-    auto observs = json_to_object<Observations, Observation>(response);
-    return observs;
+    return options.api_url() + OBSURL + "geo/recent" + generate_argument_string(args);
+  }
+
+  Observations Requester::get_recent_nearby_observations(const double lat, const double lng, const DataOptionalParameters& params) const
+  {
+    return request<Observations>(recent_nearby_observations_url(lat, lng, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  future<Observations> Requester::async_get_recent_nearby_observations(const double lat, const double lng, const DataOptionalParameters& params) const
+  {
+    return async_request<Observations>(recent_nearby_observations_url(lat, lng, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  void Requester::for_each_recent_nearby_observations(const double lat, const double lng, const function<void(const Observation&)>& each, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    for_each_row<Observation>(recent_nearby_observations_url(lat, lng, params), Endpoint::observations, row_reader<Observation>(params.fields()), each);
   }
 
-  json Requester::get_recent_nearby_notable_setup(const double lat, const double lng, const DataOptionalParameters& params, bool detailed/*=false*/) const
+  string Requester::recent_nearby_notable_url(const double lat, const double lng, const DataOptionalParameters& params, bool detailed/*=false*/) const
   {
     vector<string> args = process_args({DataParams::dist, DataParams::back, DataParams::maxResults, DataParams::hotspot}, params, lat, lng, detailed);
-    string request_url = OBSURL + "geo/recent/notable" + generate_argument_string(args);
-    return request_json(request_url);
+    return options.api_url() + OBSURL + "geo/recent/notable" + generate_argument_string(args);
   }
 
   Observations Requester::get_recent_nearby_notable_observations(const double lat, const double lng, const DataOptionalParameters& params/*=defaults*/) const
   {
-    json response = get_recent_nearby_notable_setup(lat, lng, params);
-    auto observs = json_to_object<Observations, Observation>(response);
-    return observs;
+    return request<Observations>(recent_nearby_notable_url(lat, lng, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  future<Observations> Requester::async_get_recent_nearby_notable_observations(const double lat, const double lng, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<Observations>(recent_nearby_notable_url(lat, lng, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  void Requester::for_each_recent_nearby_notable_observations(const double lat, const double lng, const function<void(const Observation&)>& each, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    for_each_row<Observation>(recent_nearby_notable_url(lat, lng, params), Endpoint::observations, row_reader<Observation>(params.fields()), each);
   }
 
   DetailedObservations Requester::get_detailed_recent_nearby_notable_observations(const double lat, const double lng, const DataOptionalParameters& params/*=defaults*/) const
   {
-    json response = get_recent_nearby_notable_setup(lat, lng, params, true);
-    auto observs = json_to_object<DetailedObservations, DetailedObservation>(response);
-    return observs;
+    return request<DetailedObservations>(recent_nearby_notable_url(lat, lng, params, true), projected<DetailedObservations, DetailedObservation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  future<DetailedObservations> Requester::async_get_detailed_recent_nearby_notable_observations(const double lat, const double lng, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<DetailedObservations>(recent_nearby_notable_url(lat, lng, params, true), projected<DetailedObservations, DetailedObservation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  void Requester::for_each_detailed_recent_nearby_notable_observations(const double lat, const double lng, const function<void(const DetailedObservation&)>& each, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    for_each_row<DetailedObservation>(recent_nearby_notable_url(lat, lng, params, true), Endpoint::observations, row_reader<DetailedObservation>(params.fields()), each);
+  }
+
+  string Requester::recent_nearby_observations_of_species_url(const string& speciesCode, double lat, double lng, const DataOptionalParameters& params) const
+  {
+    vector<string> args = process_args({DataParams::dist, DataParams::back, DataParams::maxResults, DataParams::includeProvisional, DataParams::hotspot}, params, lat, lng);
+    return options.api_url() + OBSURL + "geo/recent/" + speciesCode + generate_argument_string(args);
   }
 
   Observations Requester::get_recent_nearby_observations_of_species(const string& speciesCode, double lat, double lng, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return request<Observations>(recent_nearby_observations_of_species_url(speciesCode, lat, lng, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  future<Observations> Requester::async_get_recent_nearby_observations_of_species(const string& speciesCode, double lat, double lng, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<Observations>(recent_nearby_observations_of_species_url(speciesCode, lat, lng, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
+
+  void Requester::for_each_recent_nearby_observations_of_species(const string& speciesCode, double lat, double lng, const function<void(const Observation&)>& each, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    for_each_row<Observation>(recent_nearby_observations_of_species_url(speciesCode, lat, lng, params), Endpoint::observations, row_reader<Observation>(params.fields()), each);
+  }
+
+  string Requester::nearest_observations_of_species_url(const string& speciesCode, const double lat, const double lng, const DataOptionalParameters& params) const
   {
     vector<string> args = process_args({DataParams::dist, DataParams::back, DataParams::maxResults, DataParams::includeProvisional, DataParams::hotspot}, params, lat, lng);
-    string request_url = OBSURL + "geo/recent/" + speciesCode + generate_argument_string(args);
-    json response = request_json(request_url);
-    auto observs = json_to_object<Observations, Observation>(response);
-    return observs;
+    return options.api_url() + OBSURL + "geo/recent/" + speciesCode + generate_argument_string(args);
   }
 
   Observations Requester::get_nearest_observations_of_species(const string& speciesCode, const double lat, const double lng, const DataOptionalParameters& params/*=defaults*/) const
   {
-    vector<string> args = process_args({DataParams::dist, DataParams::back, DataParams::maxResults, DataParams::includeProvisional, DataParams::hotspot}, params, lat, lng);
-    string request_url = OBSURL + "geo/recent/" + speciesCode + generate_argument_string(args);
-    json response = request_json(request_url);
-    auto observs = json_to_object<Observations, Observation>(response);
-    return observs;
+    return request<Observations>(nearest_observations_of_species_url(speciesCode, lat, lng, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
   }
 
+  future<Observations> Requester::async_get_nearest_observations_of_species(const string& speciesCode, const double lat, const double lng, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<Observations>(nearest_observations_of_species_url(speciesCode, lat, lng, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::observations, params.fields());
+  }
 
-  json Requester::get_historic_observations_on_date_setup(const string& regionCode, int year, int month, int day, const DataOptionalParameters& params, bool detailed) const
+  void Requester::for_each_nearest_observations_of_species(const string& speciesCode, const double lat, const double lng, const function<void(const Observation&)>& each, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    for_each_row<Observation>(nearest_observations_of_species_url(speciesCode, lat, lng, params), Endpoint::observations, row_reader<Observation>(params.fields()), each);
+  }
+
+
+  string Requester::historic_observations_on_date_url(const string& regionCode, int year, int month, int day, const DataOptionalParameters& params, bool detailed) const
   {
     vector<string> args = process_args({DataParams::rank, DataParams::cat, DataParams::maxResults, DataParams::includeProvisional, DataParams::hotspot}, params, detailed);
-    string request_url = OBSURL + regionCode + "/historic/" + generate_date(year, month, day) + generate_argument_string(args);
-    return request_json(request_url);
+    return options.api_url() + OBSURL + regionCode + "/historic/" + generate_date(year, month, day) + generate_argument_string(args);
   }
 
   Observations Requester::get_historic_observations_on_date(const string& regionCode, int year, int month, int day, const DataOptionalParameters& params/*=defaults*/) const
   {
-    json response = get_historic_observations_on_date_setup(regionCode, year, month, day, params);
-    auto observs = json_to_object<Observations, Observation>(response);
-    return observs;
+    return request<Observations>(historic_observations_on_date_url(regionCode, year, month, day, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::historic_observations, params.fields());
+  }
+
+  future<Observations> Requester::async_get_historic_observations_on_date(const string& regionCode, int year, int month, int day, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<Observations>(historic_observations_on_date_url(regionCode, year, month, day, params), projected<Observations, Observation>(params.fields(), options, workers.get()), Endpoint::historic_observations, params.fields());
+  }
+
+  void Requester::for_each_historic_observations_on_date(const string& regionCode, int year, int month, int day, const function<void(const Observation&)>& each, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    for_each_row<Observation>(historic_observations_on_date_url(regionCode, year, month, day, params), Endpoint::historic_observations, row_reader<Observation>(params.fields()), each);
   }
 
   DetailedObservations Requester::get_detailed_historic_observations_on_date(const string& regionCode, int year, int month, int day, const DataOptionalParameters& params/*=defaults*/) const
   {
-    json response = get_historic_observations_on_date_setup(regionCode, year, month, day, params, true);
-    auto observs = json_to_object<DetailedObservations, DetailedObservation>(response);
-    return observs;
+    return request<DetailedObservations>(historic_observations_on_date_url(regionCode, year, month, day, params, true), projected<DetailedObservations, DetailedObservation>(params.fields(), options, workers.get()), Endpoint::historic_observations, params.fields());
+  }
+
+  future<DetailedObservations> Requester::async_get_detailed_historic_observations_on_date(const string& regionCode, int year, int month, int day, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    return async_request<DetailedObservations>(historic_observations_on_date_url(regionCode, year, month, day, params, true), projected<DetailedObservations, DetailedObservation>(params.fields(), options, workers.get()), Endpoint::historic_observations, params.fields());
+  }
+
+  void Requester::for_each_detailed_historic_observations_on_date(const string& regionCode, int year, int month, int day, const function<void(const DetailedObservation&)>& each, const DataOptionalParameters& params/*=defaults*/) const
+  {
+    for_each_row<DetailedObservation>(historic_observations_on_date_url(regionCode, year, month, day, params, true), Endpoint::historic_observations, row_reader<DetailedObservation>(params.fields()), each);
   }
 
 }
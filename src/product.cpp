@@ -1,83 +1,149 @@
 #include "../include/cbirdpp/cbirdpp.h"
+#include "../include/cbirdpp/FieldTable.h"
 using cbirdpp::Top100;
 using cbirdpp::Checklist;
 using cbirdpp::RegionalStats;
+using cbirdpp::ArenaChecklist;
+using cbirdpp::ArenaChecklists;
+using cbirdpp::ArenaTop100;
+using cbirdpp::ArenaTop100Base;
 
 #include <curlpp/cURLpp.hpp>
 #include <curlpp/Easy.hpp>
 #include <curlpp/Options.hpp>
 
-#include "../include/nlohmann/json.hpp"
-using nlohmann::json;
-
 #include <iostream> //NOLINT
 using std::cout; //NOLINT
 using std::endl; //NOLINT
 
+#include <functional>
+using std::function;
+
+#include <future>
+using std::future;
+
 #include <string>
 using std::string;
 using std::to_string;
 
+#include <string_view>
+using std::string_view;
 
 #include <sstream>
 using std::ostringstream;
 using std::stringstream;
 
-const string PRODURL = "https://ebird.org/ws2.0/product/";
+const string PRODURL = "product/";
 
-using nlohmann::json;
+using cbirdpp::Fields;
+using cbirdpp::JsonReader;
 
 namespace cbirdpp
 {
 
-  void from_json(const json& source, Top100Base& target)
+  using RegionalStatsFields = Fields<RegionalStats>;
+
+  // The fields of a Top 100 row, or of an ArenaTop100Base with its kind of Text.
+  template <typename Row, typename Text>
+  static constexpr auto top100_table()
   {
-    if(source.find("profileHandle") == source.end()) {
-      target.profileHandle = "N/A"; 
-    } else {
-      target.profileHandle = source.at("profileHandle").get<string>();
-    }
-    target.userDisplayName = source.at("userDisplayName").get<string>();
-    target.numSpecies = source.at("numSpecies").get<unsigned int>();
-    target.numCompleteChecklists = source.at("numCompleteChecklists").get<unsigned int>();
-    target.rowNum = source.at("rowNum").get<unsigned int>();
-    target.userId = source.at("userId").get<string>();
-  }
-
-  void from_json(const json& source, Checklist& target)
-  {
-    target.locId = source.at("locId").get<string>();
-    target.subID = source.at("subID").get<string>();
-    target.userDisplayName = source.at("userDisplayName").get<string>();
-    target.numSpecies = source.at("numSpecies").get<unsigned int>();
-    target.obsDt = source.at("obsDt").get<string>();
-    target.obsTime = source.at("obsTime").get<string>();
-    target.obsMonth = source.at("obsMonth").get<string>();
-    target.obsDay = source.at("obsDay").get<unsigned int>();
-    target.obsYear = source.at("obsYear").get<unsigned int>();
-    target.name = source.at("loc").at("name").get<string>();
-    target.latitude = source.at("loc").at("latitude").get<double>();
-    target.longitude = source.at("loc").at("longitude").get<double>();
-    target.countryCode = source.at("loc").at("countryCode").get<string>();
-    target.countryName = source.at("loc").at("countryName").get<string>();
-    target.subnational1Name = source.at("loc").at("subnational1Name").get<string>();
-    target.subnational1Code = source.at("loc").at("subnational1Code").get<string>();
-    target.subnational2Name = source.at("loc").at("subnational2Name").get<string>();
-    target.subnational2Code = source.at("loc").at("subnational2Code").get<string>();
-    target.isHotspot = source.at("loc").at("isHotspot").get<bool>();
-    target.hierarchicalName = source.at("loc").at("hierarchicalName").get<string>();
-  }
-
-  void from_json(const json& source, RegionalStats& target)
-  {
-    target.numChecklists = source.at("numChecklists").get<unsigned int>();
-    target.numContributors = source.at("numContributors").get<unsigned int>();
-    target.numSpecies = source.at("numSpecies").get<unsigned int>();
+    using F = Fields<Row, Text>;
+    return make_field_table(F::optional("profileHandle", &Row::profileHandle, "N/A"),
+                            F::field("userDisplayName", &Row::userDisplayName), F::field("numSpecies", &Row::numSpecies),
+                            F::field("numCompleteChecklists", &Row::numCompleteChecklists),
+                            F::field("rowNum", &Row::rowNum), F::field("userId", &Row::userId));
   }
 
-  Top100 Requester::get_top_100(const string& regionCode, int year, int month, int day, bool checklistSort/*=false*/, unsigned int maxResults/*=100*/) const
+  // The fields of a checklist that are read from its "loc" object.
+  template <typename Row, typename Text>
+  static constexpr auto location_table()
+  {
+    using F = Fields<Row, Text>;
+    return make_field_table(F::field("name", &Row::name), F::field("latitude", &Row::latitude),
+                            F::field("longitude", &Row::longitude), F::field("countryCode", &Row::countryCode),
+                            F::field("countryName", &Row::countryName),
+                            F::field("subnational1Name", &Row::subnational1Name),
+                            F::field("subnational1Code", &Row::subnational1Code),
+                            F::field("subnational2Name", &Row::subnational2Name),
+                            F::field("subnational2Code", &Row::subnational2Code),
+                            F::field("isHotspot", &Row::isHotspot), F::field("hierarchicalName", &Row::hierarchicalName));
+  }
+
+  template <typename Row, typename Text>
+  static bool read_location(JsonReader& source, Row& target)
+  {
+    static constexpr auto LOCATION_TABLE = location_table<Row, Text>();
+    return read_fields(source, target, LOCATION_TABLE);
+  }
+
+  // The fields of a Checklist or ArenaChecklist, the date and time of day are both read into obsDt.
+  template <typename Row, typename Text>
+  static constexpr auto checklist_table()
+  {
+    using F = Fields<Row, Text>;
+    return make_field_table(F::field("locId", &Row::locId), F::field("subID", &Row::subID),
+                            F::field("userDisplayName", &Row::userDisplayName), F::field("numSpecies", &Row::numSpecies),
+                            F::field("obsDt", &Row::obsDt, Timestamp::parse_date),
+                            F::field("obsTime", &Row::obsDt, Timestamp::parse_time),
+                            F::object("loc", read_location<Row, Text>));
+  }
+
+  static constexpr auto TOP100_TABLE = top100_table<Top100Base, string>();
+  static constexpr auto ARENA_TOP100_TABLE = top100_table<ArenaTop100Base, std::pmr::string>();
+  static constexpr auto CHECKLIST_TABLE = checklist_table<Checklist, string>();
+  static constexpr auto ARENA_CHECKLIST_TABLE = checklist_table<ArenaChecklist, std::pmr::string>();
+
+  static constexpr auto REGIONAL_STATS_TABLE = make_field_table(
+    RegionalStatsFields::field("numChecklists", &RegionalStats::numChecklists),
+    RegionalStatsFields::field("numContributors", &RegionalStats::numContributors),
+    RegionalStatsFields::field("numSpecies", &RegionalStats::numSpecies));
+
+  void read_json(JsonReader& source, Top100Base& target)
+  {
+    if(!read_fields(source, target, TOP100_TABLE)) {throw RequestFailed();}
+  }
+
+  void read_json(JsonReader& source, Checklist& target)
+  {
+    if(!read_fields(source, target, CHECKLIST_TABLE)) {throw RequestFailed();}
+  }
+
+  // Decodes the checklists of a feed that read and records the others, without throwing.
+  static Checked<Checklists> checked_checklists(string_view body)
+  {
+    auto read_row = [](JsonReader& source, Checklist& row) { return read_fields(source, row, CHECKLIST_TABLE); };
+    return read_checked_rows<Checklists>(body, read_row);
+  }
+
+  // The read_json of a Checklist, for the rows of a feed that are handed out one by one.
+  static void read_checklist(JsonReader& source, Checklist& target)
   {
-    string request_url = PRODURL + "top100/" + regionCode + "/" + generate_date(year, month, day);
+    read_json(source, target);
+  }
+
+  void read_json(JsonReader& source, ArenaTop100Base& target)
+  {
+    if(!read_fields(source, target, ARENA_TOP100_TABLE)) {throw RequestFailed();}
+  }
+
+  void read_json(JsonReader& source, ArenaChecklist& target)
+  {
+    if(!read_fields(source, target, ARENA_CHECKLIST_TABLE)) {throw RequestFailed();}
+  }
+
+  // Regional statistics are a single object rather than an array of rows.
+  static RegionalStats read_regional_stats(string_view response)
+  {
+    RegionalStats result{};
+    JsonReader source(response);
+    if(!read_fields(source, result, REGIONAL_STATS_TABLE)) {throw RequestFailed();}
+    source.finish();
+    return result;
+  }
+
+  string Requester::top_100_url(const string& regionCode, int year, int month, int day, bool checklistSort, unsigned int maxResults) const
+  {
+    string request_url = options.api_url() + PRODURL + "top100/" + regionCode + "/" + generate_date(year, month, day);
     if(checklistSort || maxResults != 100) {
       request_url += "?";
       if(checklistSort) {
@@ -89,20 +155,42 @@ namespace cbirdpp
         request_url += "maxResults=" + to_string(maxResults);
       }
     }
+    return request_url;
+  }
 
-    json response = request_json(request_url);
-    auto result = json_to_object<Top100, Top100Base>(response);
-    return result;
+  Top100 Requester::get_top_100(const string& regionCode, int year, int month, int day, bool checklistSort/*=false*/, unsigned int maxResults/*=100*/) const
+  {
+    return request<Top100>(top_100_url(regionCode, year, month, day, checklistSort, maxResults), json_to_object<Top100, Top100Base>, Endpoint::top_100);
+  }
+
+  future<Top100> Requester::async_get_top_100(const string& regionCode, int year, int month, int day, bool checklistSort/*=false*/, unsigned int maxResults/*=100*/) const
+  {
+    return async_request<Top100>(top_100_url(regionCode, year, month, day, checklistSort, maxResults), json_to_object<Top100, Top100Base>, Endpoint::top_100);
+  }
+
+  ArenaTop100 Requester::arena_top_100(const string& regionCode, int year, int month, int day, bool checklistSort/*=false*/, unsigned int maxResults/*=100*/) const
+  {
+    return request<ArenaTop100>(top_100_url(regionCode, year, month, day, checklistSort, maxResults), json_to_arena<ArenaTop100>, Endpoint::top_100);
+  }
+
+  future<ArenaTop100> Requester::async_arena_top_100(const string& regionCode, int year, int month, int day, bool checklistSort/*=false*/, unsigned int maxResults/*=100*/) const
+  {
+    return async_request<ArenaTop100>(top_100_url(regionCode, year, month, day, checklistSort, maxResults), json_to_arena<ArenaTop100>, Endpoint::top_100);
   }
 
   Top100 Requester::get_top_100(const string& regionCode, int year, int month, int day, unsigned int maxResults) const
   {
     return get_top_100(regionCode, year, month, day, false, maxResults);
   }
-  
-  Checklists Requester::get_checklist_feed_on_date(const string& regionCode, int year, int month, int day, SortType sortKey, unsigned int maxResults)
+
+  future<Top100> Requester::async_get_top_100(const string& regionCode, int year, int month, int day, unsigned int maxResults) const
   {
-    string request_url = PRODURL + "lists/" + regionCode + "/" + generate_date(year, month, day);    
+    return async_get_top_100(regionCode, year, month, day, false, maxResults);
+  }
+
+  string Requester::checklist_feed_on_date_url(const string& regionCode, int year, int month, int day, SortType sortKey, unsigned int maxResults) const
+  {
+    string request_url = options.api_url() + PRODURL + "lists/" + regionCode + "/" + generate_date(year, month, day);    
     if(sortKey != SortType::obs_dt || maxResults != 10) {
       request_url += "?";
       if(sortKey != SortType::obs_dt) {
@@ -114,10 +202,42 @@ namespace cbirdpp
         }
       } 
     } 
+    return request_url;
+  }
+  
+  Checklists Requester::get_checklist_feed_on_date(const string& regionCode, int year, int month, int day, SortType sortKey, unsigned int maxResults)
+  {
+    return request<Checklists>(checklist_feed_on_date_url(regionCode, year, month, day, sortKey, maxResults), json_to_object<Checklists, Checklist>, Endpoint::checklist_feed);
+  }
 
-    json response = request_json(request_url);
-    auto result = json_to_object<Checklists, Checklist>(response);
-    return result;
+  future<Checklists> Requester::async_get_checklist_feed_on_date(const string& regionCode, int year, int month, int day, SortType sortKey, unsigned int maxResults) const
+  {
+    return async_request<Checklists>(checklist_feed_on_date_url(regionCode, year, month, day, sortKey, maxResults), json_to_object<Checklists, Checklist>, Endpoint::checklist_feed);
+  }
+
+  ArenaChecklists Requester::arena_checklist_feed_on_date(const string& regionCode, int year, int month, int day, SortType sortKey/*=obs_dt*/, unsigned int maxResults/*=10*/) const
+  {
+    return request<ArenaChecklists>(checklist_feed_on_date_url(regionCode, year, month, day, sortKey, maxResults), json_to_arena<ArenaChecklists>, Endpoint::checklist_feed);
+  }
+
+  future<ArenaChecklists> Requester::async_arena_checklist_feed_on_date(const string& regionCode, int year, int month, int day, SortType sortKey/*=obs_dt*/, unsigned int maxResults/*=10*/) const
+  {
+    return async_request<ArenaChecklists>(checklist_feed_on_date_url(regionCode, year, month, day, sortKey, maxResults), json_to_arena<ArenaChecklists>, Endpoint::checklist_feed);
+  }
+
+  Checked<Checklists> Requester::checked_checklist_feed_on_date(const string& regionCode, int year, int month, int day, SortType sortKey/*=obs_dt*/, unsigned int maxResults/*=10*/) const
+  {
+    return request<Checked<Checklists>>(checklist_feed_on_date_url(regionCode, year, month, day, sortKey, maxResults), checked_checklists, Endpoint::checklist_feed);
+  }
+
+  future<Checked<Checklists>> Requester::async_checked_checklist_feed_on_date(const string& regionCode, int year, int month, int day, SortType sortKey/*=obs_dt*/, unsigned int maxResults/*=10*/) const
+  {
+    return async_request<Checked<Checklists>>(checklist_feed_on_date_url(regionCode, year, month, day, sortKey, maxResults), checked_checklists, Endpoint::checklist_feed);
+  }
+
+  void Requester::for_each_checklist_feed_on_date(const string& regionCode, int year, int month, int day, const function<void(const Checklist&)>& each, SortType sortKey/*=obs_dt*/, unsigned int maxResults/*=10*/) const
+  {
+    for_each_row<Checklist>(checklist_feed_on_date_url(regionCode, year, month, day, sortKey, maxResults), Endpoint::checklist_feed, read_checklist, each);
   }
 
   Checklists Requester::get_checklist_feed_on_date(const string& regionCode, int year, int month, int day, unsigned int maxResults)
@@ -125,24 +245,52 @@ namespace cbirdpp
     return get_checklist_feed_on_date(regionCode, year, month, day, SortType::obs_dt, maxResults);
   }
 
-  Checklists Requester::get_recent_checklists_feed(const string& regionCode, unsigned int maxResults)
+  future<Checklists> Requester::async_get_checklist_feed_on_date(const string& regionCode, int year, int month, int day, unsigned int maxResults) const
   {
-    string request_url = PRODURL + "lists/" + regionCode;
+    return async_get_checklist_feed_on_date(regionCode, year, month, day, SortType::obs_dt, maxResults);
+  }
+
+  void Requester::for_each_checklist_feed_on_date(const string& regionCode, int year, int month, int day, const function<void(const Checklist&)>& each, unsigned int maxResults) const
+  {
+    for_each_checklist_feed_on_date(regionCode, year, month, day, each, SortType::obs_dt, maxResults);
+  }
+
+  string Requester::recent_checklists_feed_url(const string& regionCode, unsigned int maxResults) const
+  {
+    string request_url = options.api_url() + PRODURL + "lists/" + regionCode;
     if(maxResults != 10) {
       request_url += "?maxResults=" + to_string(maxResults);
     }
+    return request_url;
+  }
 
-    json response = request_json(request_url);
-    auto result = json_to_object<Checklists, Checklist>(response);
-    return result;
+  Checklists Requester::get_recent_checklists_feed(const string& regionCode, unsigned int maxResults)
+  {
+    return request<Checklists>(recent_checklists_feed_url(regionCode, maxResults), json_to_object<Checklists, Checklist>, Endpoint::checklist_feed);
+  }
+
+  future<Checklists> Requester::async_get_recent_checklists_feed(const string& regionCode, unsigned int maxResults) const
+  {
+    return async_request<Checklists>(recent_checklists_feed_url(regionCode, maxResults), json_to_object<Checklists, Checklist>, Endpoint::checklist_feed);
+  }
+
+  void Requester::for_each_recent_checklists_feed(const string& regionCode, const function<void(const Checklist&)>& each, unsigned int maxResults/*=10*/) const
+  {
+    for_each_row<Checklist>(recent_checklists_feed_url(regionCode, maxResults), Endpoint::checklist_feed, read_checklist, each);
+  }
+
+  string Requester::regional_statistics_on_date_url(const string& regionCode, unsigned int year, unsigned int month, unsigned int day) const
+  {
+    return options.api_url() + PRODURL + "stats/" + regionCode + "/" + generate_date(year, month, day);
   }
 
   RegionalStats Requester::get_regional_statistics_on_date(const string& regionCode, unsigned int year, unsigned int month, unsigned int day)
   {
-    string request_url = PRODURL + "stats/" + regionCode + "/" + generate_date(year, month, day);
+    return request<RegionalStats>(regional_statistics_on_date_url(regionCode, year, month, day), read_regional_stats, Endpoint::regional_statistics);
+  }
 
-    json response = request_json(request_url);
-    auto result = response.get<RegionalStats>();
-    return result;
+  future<RegionalStats> Requester::async_get_regional_statistics_on_date(const string& regionCode, unsigned int year, unsigned int month, unsigned int day) const
+  {
+    return async_request<RegionalStats>(regional_statistics_on_date_url(regionCode, year, month, day), read_regional_stats, Endpoint::regional_statistics);
   }
 }
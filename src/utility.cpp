@@ -1,10 +1,27 @@
 #include "../include/cbirdpp/cbirdpp.h"
-#include "../include/nlohmann/json.hpp"
-using nlohmann::json;
+#include "../include/cbirdpp/AsyncEngine.h"
+#include "../include/cbirdpp/ConnectionPool.h"
+#include "../include/cbirdpp/CurlTransport.h"
+#include "../include/cbirdpp/ResponseBuffer.h"
+#include "../include/cbirdpp/SharedContext.h"
 
-#include <curlpp/cURLpp.hpp>
-#include <curlpp/Easy.hpp>
-#include <curlpp/Options.hpp>
+#include <algorithm>
+
+#include <atomic>
+using std::atomic;
+
+#include <chrono>
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+#include <exception>
+using std::exception_ptr;
+
+#include <functional>
+using std::function;
+
+#include <future>
 
 #include <iostream>
 
@@ -12,14 +29,23 @@ using nlohmann::json;
 using std::string;
 using std::to_string;
 
+#include <string_view>
+using std::string_view;
+
 #include <list>
 using std::list;
 
-#include <sstream>
-using std::ostringstream;
+#include <memory>
+using std::make_shared;
+using std::shared_ptr;
+
+#include <random>
+
+#include <thread>
 
 #include <utility>
 using std::initializer_list;
+using std::move;
 
 #include <vector>
 using std::vector;
@@ -27,6 +53,54 @@ using std::vector;
 namespace cbirdpp
 {  
 
+  // Easy handles, and with them open connections, each Requester keeps around for reuse.
+  const size_t MAX_IDLE_CONNECTIONS = 8;
+
+  // Hedged requests send their duplicate once this share of recent requests to the endpoint would have completed.
+  const double HEDGE_PERCENTILE = 0.95;
+
+  Requester::Requester(const string& key) : Requester(key, RequesterOptions()) {}
+
+  Requester::Requester(const string& key, const RequesterOptions& options)
+    : api_key(key), options(options),
+      limiter(make_shared<RateLimiter>(options.rate_limit(), options.max_concurrency())),
+      transport(make_shared<CurlTransport>(make_shared<ConnectionPool>(MAX_IDLE_CONNECTIONS, options),
+                                           make_shared<AsyncEngine>(options, nullptr, limiter), limiter)),
+      latencies(make_shared<LatencyTracker>()), flights(make_shared<SingleFlight>()),
+      validators(make_shared<ValidatorCache>(options.revalidation_cache())),
+      interned(make_shared<InternedStrings>(std::size_t(options.string_pool()) << 20)),
+      workers(make_shared<WorkerPool>(options.decode_threads())),
+      warmed(transport->prewarm(options.api_url(), options.prewarm()).share()) {}
+
+  Requester::Requester(const string& key, shared_ptr<SharedContext> context)
+    : api_key(key), options(context->options()), context(context), limiter(context->limiter()),
+      transport(context->transport()), latencies(make_shared<LatencyTracker>()), flights(context->flights()),
+      validators(context->validators()), interned(context->strings()), workers(context->workers()),
+      warmed(context->ready()) {}
+
+  Requester::Requester(const string& key, shared_ptr<Transport> transport, const RequesterOptions& options/*=RequesterOptions()*/)
+    : api_key(key), options(options), limiter(make_shared<RateLimiter>(options.rate_limit(), options.max_concurrency())),
+      transport(move(transport)), latencies(make_shared<LatencyTracker>()), flights(make_shared<SingleFlight>()),
+      validators(make_shared<ValidatorCache>(options.revalidation_cache())),
+      interned(make_shared<InternedStrings>(std::size_t(options.string_pool()) << 20)),
+      workers(make_shared<WorkerPool>(options.decode_threads())),
+      warmed(this->transport->prewarm(options.api_url(), options.prewarm()).share()) {}
+
+  const RateLimiter& Requester::rate_limiter() const
+  {
+    return *limiter;
+  }
+
+  std::shared_future<void> Requester::ready() const
+  {
+    return warmed;
+  }
+
+  const SingleFlight& Requester::single_flight() const
+  {
+    return *flights;
+  }
+
   vector<string> Requester::process_args(const initializer_list<DataParams>& optional_params, const DataOptionalParameters& params, double lat, double lng, bool detailed, bool nearby_args/*=false*/) const
   {
     vector<string> args;
@@ -105,31 +179,232 @@ namespace cbirdpp
     return to_string(year) + "/" + to_string(month) + "/" + to_string(day);
   }
 
-  json Requester::request_json(const std::string& request_url) const
+  void Requester::request_json(const std::string& request_url, const Endpoint& endpoint, const list<string>& conditions,
+                               const function<void(ParsedResponse&)>& received) const
   {
-    cURLpp::Cleanup cleaner;
-    cURLpp::Easy request_handle;
-    request_handle.setOpt(cURLpp::Options::Url(request_url));
-    request_handle.setOpt(cURLpp::Options::Header(true));
-    request_handle.setOpt(cURLpp::Options::HttpHeader(list<string>({"X-eBirdApiToken: " + api_key})));
-    ostringstream out_stream;
-    request_handle.setOpt(new cURLpp::Options::WriteStream(&out_stream));
-    request_handle.perform();
+    if(options.hedging()) {
+      std::promise<ParsedResponse> result;
+      std::future<ParsedResponse> response = result.get_future();
+      request_json_async(request_url, endpoint, conditions, [&result](ParsedResponse parsed, exception_ptr error) {
+        if(error) {
+          result.set_exception(error);
+        } else {
+          result.set_value(move(parsed));
+        }
+      });
+      ParsedResponse parsed = response.get();
+      received(parsed);
+      return;
+    }
 
-    size_t json_start = out_stream.str().find('[');
-    if(json_start == string::npos) {
-      json_start = out_stream.str().find('{');
+    for(unsigned int retry = 0; ; ++retry) {
+      try {
+        request_once(request_url, endpoint, conditions, received);
+        return;
+      } catch(...) {
+        if(retry >= options.max_retries() || !retryable(std::current_exception())) {throw;}
+      }
+      std::this_thread::sleep_for(backoff(options, retry));
     }
-    if(json_start == string::npos) {throw RequestFailed();}
+  }
+
+  void Requester::request_once(const std::string& request_url, const Endpoint& endpoint, const list<string>& conditions,
+                               const function<void(ParsedResponse&)>& received) const
+  {
+    Transport::Request request;
+    request.url = request_url;
+    request.headers = {"X-eBirdApiToken: " + api_key};
+    request.headers.insert(request.headers.end(), conditions.begin(), conditions.end());
+    request.timeout = milliseconds(options.timeout(endpoint));
+    auto start = steady_clock::now();
+    transport->perform(request, [this, &endpoint, &received, start](ResponseBuffer& response) {
+      ParsedResponse parsed = parse_response(response);
+      // Recorded before the decode, which is no part of the latency of the endpoint.
+      latencies->record(endpoint, duration_cast<milliseconds>(steady_clock::now() - start));
+      received(parsed);
+    });
+  }
+
+  // True for a successful response declared as JSON, whose body can be read as it arrives.
+  static bool streamable(const ResponseBuffer& response)
+  {
+    string_view type = response.content_type();
+    return response.status() >= 200 && response.status() < 300 && (type.empty() || type.find("json") != string_view::npos);
+  }
 
+  void Requester::request_stream(const string& request_url, const Endpoint& endpoint, const ArrayStream::Element& element) const
+  {
+    Transport::Request request;
+    request.url = request_url;
+    request.headers = {"X-eBirdApiToken: " + api_key};
+    request.timeout = milliseconds(options.timeout(endpoint));
+    for(unsigned int retry = 0; ; ++retry) {
+      ArrayStream rows;
+      exception_ptr stopped;      // What the stream aborted the transfer with.
+      request.stream = [&rows, &stopped, &element](const ResponseBuffer& response, string_view chunk) {
+        // Any other body is dropped, parse_response reports the error once the transfer is over.
+        if(!streamable(response)) {return true;}
+        try {
+          if(!rows.feed(chunk, element)) {throw RequestFailed();}
+          return true;
+        } catch(...) {
+          stopped = std::current_exception();
+          return false;
+        }
+      };
+      exception_ptr error;
+      try {
+        auto start = steady_clock::now();
+        transport->perform(request, [](ResponseBuffer& response) { parse_response(response); });
+        rows.finish();
+        latencies->record(endpoint, duration_cast<milliseconds>(steady_clock::now() - start));
+        return;
+      } catch(...) {
+        error = stopped ? stopped : std::current_exception();
+      }
+      // Rows already handed out can't be taken back, so a failure after the first one is final.
+      if(rows.elements() > 0 || retry >= options.max_retries() || !retryable(error)) {std::rethrow_exception(error);}
+      std::this_thread::sleep_for(backoff(options, retry));
+    }
+  }
+
+  /*
+   * The state of an async request that is shared by its rounds. A round is the request itself plus, with hedging, a
+   * duplicate, and a round that fails in a way worth retrying is followed by another one after a backoff.
+   */
+  struct Requester::AsyncAttempt
+  {
+    Transport* transport;
+    Transport::Request request;
+    Endpoint endpoint;
+    RequesterOptions options;
+    shared_ptr<LatencyTracker> latencies;
+    function<void(ParsedResponse, exception_ptr)> done;
+    unsigned int retries = 0;
+  };
+
+  /*
+   * The copies of a request racing in one round. The first success settles the round, a failure only settles it
+   * once no other copy can succeed anymore.
+   */
+  struct Round
+  {
+    atomic<bool> settled{false};
+    atomic<int> outstanding{0};
+    steady_clock::time_point start;
+  };
+
+  void Requester::request_json_async(const string& request_url, const Endpoint& endpoint, const list<string>& conditions,
+                                     function<void(ParsedResponse, exception_ptr)> done) const
+  {
+    auto attempt = make_shared<AsyncAttempt>();
+    // The transport outlives every completion it runs, so the attempt can point at it without keeping it alive.
+    attempt->transport = transport.get();
+    attempt->request.url = request_url;
+    attempt->request.headers = {"X-eBirdApiToken: " + api_key};
+    attempt->request.headers.insert(attempt->request.headers.end(), conditions.begin(), conditions.end());
+    attempt->request.timeout = milliseconds(options.timeout(endpoint));
+    attempt->endpoint = endpoint;
+    attempt->options = options;
+    attempt->latencies = latencies;
+    attempt->done = move(done);
+    submit_round(move(attempt), milliseconds(0));
+  }
+
+  void Requester::submit_round(shared_ptr<AsyncAttempt> attempt, milliseconds delay)
+  {
+    auto round = make_shared<Round>();
+    round->start = steady_clock::now() + delay;
+    milliseconds hedge_after = attempt->options.hedging() ? attempt->latencies->percentile(attempt->endpoint, HEDGE_PERCENTILE) : milliseconds(0);
+    round->outstanding = hedge_after.count() > 0 ? 2 : 1;
+
+    auto complete = [attempt, round](ResponseBuffer& response, exception_ptr error) {
+      ParsedResponse parsed;
+      if(!error) {
+        try {
+          parsed = parse_response(response);
+        } catch(...) {
+          error = std::current_exception();
+        }
+      }
+      int others = --round->outstanding;
+      if(!error) {
+        if(round->settled.exchange(true)) {return;}
+        attempt->latencies->record(attempt->endpoint, duration_cast<milliseconds>(steady_clock::now() - round->start));
+        // The body is decoded after the transfer has let go of its buffer, so it is moved out of it.
+        parsed.own();
+        attempt->done(move(parsed), nullptr);
+        return;
+      }
+      bool retry = retryable(error);
+      // Another copy still racing may succeed, unless the request itself is at fault.
+      if(retry && others > 0) {return;}
+      if(round->settled.exchange(true)) {return;}
+      if(retry && attempt->retries < attempt->options.max_retries()) {
+        milliseconds wait = backoff(attempt->options, attempt->retries++);
+        submit_round(attempt, wait);
+        return;
+      }
+      attempt->done(ParsedResponse(), error);
+    };
+
+    Transport::Request request = attempt->request;
+    request.delay = delay;
+    attempt->transport->submit(request, complete);
+    if(hedge_after.count() > 0) {
+      request.delay = delay + hedge_after;
+      request.wanted = [round] { return !round->settled; };
+      attempt->transport->submit(request, complete);
+    }
+  }
+
+  milliseconds Requester::backoff(const RequesterOptions& options, unsigned int retry)
+  {
+    thread_local std::mt19937 generator(std::random_device{}());
+    unsigned long long ceiling = options.backoff_base();
+    for(unsigned int i = 0; i < retry && ceiling < options.backoff_cap(); ++i) {ceiling *= 2;}
+    ceiling = std::min<unsigned long long>(ceiling, options.backoff_cap());
+    std::uniform_int_distribution<unsigned long long> jitter(0, ceiling);
+    return milliseconds(jitter(generator));
+  }
+
+  bool Requester::retryable(exception_ptr error)
+  {
     try {
-      json response = json::parse(out_stream.str().substr(json_start));
-      return response;
+      std::rethrow_exception(error);
+    } catch(const RateLimited&) {
+      return true;
+    } catch(const HttpError& failed) {
+      return failed.status() >= 500;
+    } catch(const TransferFailed&) {
+      return true;
     } catch(...) {
-      throw RequestFailed();
+      return false;
     }
-
   }
 
+  Requester::ParsedResponse Requester::parse_response(ResponseBuffer& response)
+  {
+    ParsedResponse parsed;
+    parsed.etag = string(response.etag());
+    parsed.last_modified = string(response.last_modified());
+    switch(response.status()) {
+      case 304:
+        parsed.not_modified = true;
+        return parsed;
+      case 400:
+        throw BadRequest();
+      case 429:
+        throw RateLimited(response.retry_after());
+      default:
+        if(response.status() < 200 || response.status() >= 300) {throw HttpError(response.status());}
+    }
+    // An HTML error page served with a success status must not reach the JSON decoders either.
+    string_view type = response.content_type();
+    if(!type.empty() && type.find("json") == string_view::npos) {throw RequestFailed();}
+
+    parsed.buffer = &response;
+    return parsed;
+  }
 
 }
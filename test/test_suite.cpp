@@ -1,24 +1,79 @@
 #include "../include/cbirdpp/cbirdpp.h"
+#include "../include/cbirdpp/AsyncEngine.h"
+#include "../include/cbirdpp/ConnectionPool.h"
+#include "../include/cbirdpp/FieldTable.h"
+#include "../include/cbirdpp/JsonReader.h"
+#include "../include/cbirdpp/MemoryTransport.h"
+#include "../include/cbirdpp/ResponseBuffer.h"
+#include "../include/cbirdpp/StructuralIndex.h"
+#include "../include/cbirdpp/WorkerPool.h"
+#include "../bench/LocalH2Server.h"
+#include "../bench/LocalServer.h"
+using cbirdpp::AsyncEngine;
 using cbirdpp::Checklist;
+using cbirdpp::ConnectionPool;
 using cbirdpp::Checklists;
 using cbirdpp::DataOptionalParameters;
 using cbirdpp::DataSortType;
 using cbirdpp::DetailedObservations;
+using cbirdpp::Endpoint;
+using cbirdpp::JsonReader;
+using cbirdpp::LatencyTracker;
+using cbirdpp::MemoryTransport;
 using cbirdpp::Observations;
 using cbirdpp::RankType;
 using cbirdpp::RegionalStats;
 using cbirdpp::Requester;
+using cbirdpp::RateLimiter;
+using cbirdpp::RequesterOptions;
+using cbirdpp::ResponseBuffer;
+using cbirdpp::SharedContext;
+using cbirdpp::SingleFlight;
 using cbirdpp::SortType;
+using cbirdpp::Timestamp;
+using cbirdpp::StructuralIndex;
+using cbirdpp::ValidatorCache;
+using cbirdpp::WorkerPool;
 using cbirdpp::Top100;
+using cbirdpp::HttpVersion;
+using cbirdpp_bench::LocalH2Server;
+using cbirdpp_bench::LocalReply;
+using cbirdpp_bench::LocalRequest;
+using cbirdpp_bench::LocalServer;
 
 #include <gtest/gtest.h>
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+
 #include <string>
 #include <fstream>
 
+#include <atomic>
+
+#include <chrono>
+using std::chrono::milliseconds;
+
+#include <future>
+using std::future;
+
 #include <string>
 using std::string;
 
+#include <string_view>
+using std::string_view;
+
+#include <thread>
+
+#include <type_traits>
+using std::is_same_v;
+
+#include <vector>
+using std::vector;
+
 #include <utility>
 using std::pair;
 
@@ -59,6 +114,30 @@ TEST(GetRecentObsInRegionTest, Invalid)
   } catch(const cbirdpp::RequestFailed& rf) {}
 }
 
+TEST(AsyncGetRecentObsInRegionTest, Valid)
+{
+  Requester requester(APIKEY);
+  vector<future<Observations>> pending;
+  for(const string& region : region_codes) {
+    pending.push_back(requester.async_get_recent_observations_in_region(region));
+    for(const DataOptionalParameters& p : data_optional_params) {
+      pending.push_back(requester.async_get_recent_observations_in_region(region, p));
+    }
+  }
+  for(future<Observations>& result : pending) {
+    Observations obs = result.get();
+  }
+}
+
+TEST(AsyncGetRecentObsInRegionTest, Invalid)
+{
+  Requester requester(APIKEY);
+  future<Observations> result = requester.async_get_recent_observations_in_region("GIBBBBBBERISH");
+  try {
+    Observations obs = result.get();
+  } catch(const cbirdpp::RequestFailed& rf) {}
+}
+
 TEST(GetRecentNotableObsInRegionTest, SuccessTest)
 {
   Requester requester(APIKEY);
@@ -241,6 +320,971 @@ TEST(GetRegionalStatisticsOnDateTest, SuccessTest)
   }
 }
 
+TEST(ConnectionPoolTest, KeepsAtMostMaxIdleHandles)
+{
+  ConnectionPool pool(1);
+  {
+    ConnectionPool::Lease first = pool.acquire();
+    ConnectionPool::Lease second = pool.acquire();
+  }
+  EXPECT_EQ(pool.idle(), 1u);
+  ConnectionPool::Lease reused = pool.acquire();
+  EXPECT_EQ(pool.idle(), 0u);
+}
+
+TEST(ResponseBufferTest, ReservesFromContentLengthAndKeepsCapacity)
+{
+  ResponseBuffer buffer;
+  std::string header = "content-LENGTH: 100000\r\n";
+  buffer.header(header.data(), header.size());
+  EXPECT_GE(buffer.capacity(), 100000u);
+  std::string body = "[{\"speciesCode\":\"amecro\"}]";
+  buffer.append(body.data(), body.size());
+  EXPECT_EQ(buffer.view(), body);
+  buffer.clear();
+  EXPECT_TRUE(buffer.view().empty());
+  EXPECT_GE(buffer.capacity(), 100000u);
+}
+
+TEST(ResponseBufferTest, ReleaseMovesTheBodyOutInsteadOfCopyingIt)
+{
+  ResponseBuffer buffer;
+  std::string body = "[{\"speciesCode\":\"amecro\",\"comName\":\"American Crow\"}]";
+  buffer.append(body.data(), body.size());
+  const char* held = buffer.view().data();
+  std::string released = buffer.release();
+  EXPECT_EQ(released, body);
+  EXPECT_EQ(released.data(), held);
+  EXPECT_TRUE(buffer.view().empty());
+  buffer.append(body.data(), body.size());
+  EXPECT_EQ(buffer.view(), body);
+}
+
+TEST(ResponseBufferTest, RecordsStatusAndHeadersOfTheFinalResponse)
+{
+  ResponseBuffer buffer;
+  for(std::string line : {"HTTP/1.1 100 Continue\r\n", "\r\n", "HTTP/2 429 \r\n", "Retry-After: 30\r\n",
+                          "Content-Type: text/html; charset=utf-8\r\n", "\r\n"}) {
+    buffer.header(line.data(), line.size());
+  }
+  EXPECT_EQ(buffer.status(), 429);
+  EXPECT_EQ(buffer.retry_after(), 30);
+  EXPECT_EQ(buffer.content_type(), "text/html; charset=utf-8");
+  EXPECT_TRUE(buffer.view().empty());
+}
+
+TEST(SharedContextTest, OutlivesTheCallersReference)
+{
+  std::shared_ptr<SharedContext> context = std::make_shared<SharedContext>();
+  std::shared_ptr<ConnectionPool> connections = context->connections();
+  Requester requester(APIKEY, context);
+  context.reset();
+  {
+    ConnectionPool::Lease handle = connections->acquire();
+  }
+  EXPECT_EQ(connections->idle(), 1u);
+}
+
+TEST(RateLimiterTest, BacksOffOncePerRoundAndRecovers)
+{
+  RateLimiter limiter(0, 8);
+  std::vector<RateLimiter::Ticket> tickets;
+  for(int i = 0; i < 4; ++i) {tickets.push_back(limiter.acquire());}
+  EXPECT_EQ(limiter.in_flight(), 4u);
+  tickets[0].complete(429);
+  tickets[1].complete(503);
+  EXPECT_LT(limiter.concurrency_limit(), 4);
+  EXPECT_GE(limiter.concurrency_limit(), 1);
+  double backed_off = limiter.concurrency_limit();
+  tickets.clear();
+  EXPECT_EQ(limiter.in_flight(), 0u);
+  limiter.acquire().complete(200);
+  EXPECT_GT(limiter.concurrency_limit(), backed_off);
+}
+
+TEST(RateLimiterTest, TokenBucketAllowsOneSecondOfBurst)
+{
+  RateLimiter limiter(10);
+  for(int i = 0; i < 10; ++i) {
+    RateLimiter::Ticket ticket;
+    EXPECT_TRUE(limiter.try_acquire(ticket));
+  }
+  RateLimiter::Ticket ticket;
+  EXPECT_FALSE(limiter.try_acquire(ticket));
+  EXPECT_GT(limiter.next_available().count(), 0);
+  EXPECT_LE(limiter.next_available().count(), 100);
+}
+
+TEST(RequesterOptionsTest, RejectsOutOfRangeLimits)
+{
+  RequesterOptions options;
+  EXPECT_THROW(options.set_max_concurrent_streams(0), cbirdpp::ArgumentOutOfRange<unsigned int>);
+  EXPECT_THROW(options.set_max_host_connections(1001), cbirdpp::ArgumentOutOfRange<unsigned int>);
+  EXPECT_THROW(options.set_rate_limit(-1), cbirdpp::ArgumentOutOfRange<double>);
+  EXPECT_THROW(options.set_max_concurrency(1001), cbirdpp::ArgumentOutOfRange<unsigned int>);
+  options.set_http_version(cbirdpp::HttpVersion::http2);
+  EXPECT_TRUE(options.multiplexed());
+  options.reset();
+  EXPECT_FALSE(options.multiplexed());
+}
+
+TEST(RequesterOptionsTest, CompressionOnByDefault)
+{
+  RequesterOptions options;
+  EXPECT_TRUE(options.compression());
+  options.set_compression(false);
+  EXPECT_FALSE(options.compression());
+  options.reset();
+  EXPECT_TRUE(options.compression());
+}
+
+TEST(RequesterOptionsTest, TimeoutsAndRetries)
+{
+  RequesterOptions options;
+  EXPECT_EQ(options.timeout(Endpoint::historic_observations), 60000u);
+  options.set_timeout(Endpoint::top_100, 5000);
+  EXPECT_EQ(options.timeout(Endpoint::top_100), 5000u);
+  EXPECT_EQ(options.timeout(Endpoint::observations), 30000u);
+  EXPECT_THROW(options.set_timeout(Endpoint::observations, 600001), cbirdpp::ArgumentOutOfRange<unsigned int>);
+  EXPECT_THROW(options.set_max_retries(11), cbirdpp::ArgumentOutOfRange<unsigned int>);
+  EXPECT_THROW(options.set_backoff(0, 1000), cbirdpp::ArgumentOutOfRange<unsigned int>);
+  options.set_api_url("http://127.0.0.1:8080");
+  EXPECT_EQ(options.api_url(), "http://127.0.0.1:8080/");
+}
+
+TEST(LatencyTrackerTest, PercentileNeedsEnoughSamples)
+{
+  LatencyTracker tracker;
+  for(int i = 1; i < 20; ++i) {tracker.record(Endpoint::top_100, milliseconds(i));}
+  EXPECT_EQ(tracker.percentile(Endpoint::top_100, 0.95).count(), 0);
+  for(int i = 20; i <= 100; ++i) {tracker.record(Endpoint::top_100, milliseconds(i));}
+  EXPECT_GE(tracker.percentile(Endpoint::top_100, 0.95).count(), 94);
+  EXPECT_LE(tracker.percentile(Endpoint::top_100, 0.95).count(), 96);
+  EXPECT_EQ(tracker.percentile(Endpoint::observations, 0.95).count(), 0);
+}
+
+TEST(SingleFlightTest, WaitersShareTheLeadersOutcome)
+{
+  SingleFlight flights;
+  vector<int> received;
+  auto collect = [&](std::shared_ptr<const void> result, std::exception_ptr) { received.push_back(*std::static_pointer_cast<const int>(result)); };
+  EXPECT_TRUE(flights.join("a", collect));
+  EXPECT_FALSE(flights.join("a", collect));
+  EXPECT_TRUE(flights.join("b", collect));
+  EXPECT_EQ(flights.in_flight(), 2u);
+  flights.complete("a", std::make_shared<const int>(7), nullptr);
+  EXPECT_EQ(received, vector<int>({7, 7}));
+  EXPECT_EQ(flights.in_flight(), 1u);
+  EXPECT_EQ(flights.coalesced(), 1u);
+  EXPECT_TRUE(flights.join("a", collect));
+}
+
+TEST(MemoryTransportTest, ServesCannedResponsesOffline)
+{
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  transport->serve_file(options.api_url() + "product/top100/", "misc/top100_example.json");
+  transport->serve_file(options.api_url() + "product/stats/", "misc/regional_statistics_example.json");
+  Requester requester("offline", transport, options);
+
+  Top100 top = requester.get_top_100("US-NY", 2018, 1, 1);
+  ASSERT_FALSE(top.empty());
+  EXPECT_EQ(top[0].userDisplayName, "Elizabeth Cavazos");
+  EXPECT_EQ(requester.async_get_regional_statistics_on_date("US-NY", 2018, 1, 1).get().numSpecies, 601u);
+  EXPECT_THROW(requester.get_recent_checklists_feed("US-NY"), cbirdpp::HttpError);
+  EXPECT_EQ(transport->requests(), 3u);
+}
+
+TEST(MemoryTransportTest, RetriesServerErrors)
+{
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  options.set_backoff(1, 1);
+  transport->serve(options.api_url(), "", 503, "text/html");
+  Requester requester("offline", transport, options);
+  EXPECT_THROW(requester.get_top_100("US-NY", 2018, 1, 1), cbirdpp::HttpError);
+  EXPECT_EQ(transport->requests(), 1u + options.max_retries());
+}
+
+TEST(RevalidationTest, UnchangedResponsesAreNotDownloadedAgain)
+{
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  transport->serve_file(options.api_url() + "product/lists/", "misc/checklist_feed_example.json");
+  Requester requester("offline", transport, options);
+
+  Checklists first = requester.get_checklist_feed_on_date("US-NY", 2018, 1, 1);
+  std::size_t downloaded = transport->bytes_sent();
+  Checklists second = requester.async_get_checklist_feed_on_date("US-NY", 2018, 1, 1).get();
+  EXPECT_EQ(transport->requests(), 2u);
+  EXPECT_EQ(transport->bytes_sent(), downloaded);
+  ASSERT_EQ(second.size(), first.size());
+  EXPECT_EQ(second[0].subID, first[0].subID);
+
+  transport->serve(options.api_url() + "product/lists/", "[]");
+  EXPECT_TRUE(requester.get_checklist_feed_on_date("US-NY", 2018, 1, 1).empty());
+}
+
+TEST(ValidatorCacheTest, DropsTheLeastRecentlyUsedEntry)
+{
+  ValidatorCache cache(2);
+  cache.store("a", ValidatorCache::Entry{"\"1\"", "", nullptr});
+  cache.store("b", ValidatorCache::Entry{"", "Mon, 01 Jan 2018 00:00:00 GMT", nullptr});
+  ASSERT_NE(cache.find("a"), nullptr);
+  cache.store("c", ValidatorCache::Entry{"\"3\"", "", nullptr});
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_EQ(cache.find("b"), nullptr);
+  EXPECT_EQ(cache.find("a")->conditions(), std::list<string>({"If-None-Match: \"1\""}));
+  EXPECT_THROW(RequesterOptions().set_revalidation_cache(100001), cbirdpp::ArgumentOutOfRange<unsigned int>);
+}
+
+TEST(PrewarmTest, ReadinessReportsUnreachableHosts)
+{
+  RequesterOptions options;
+  EXPECT_THROW(options.set_prewarm(17), cbirdpp::ArgumentOutOfRange<unsigned int>);
+  EXPECT_EQ(Requester(APIKEY, options).ready().wait_for(std::chrono::seconds(0)), std::future_status::ready);
+  options.set_prewarm(2);
+  options.set_api_url("http://127.0.0.1:1/");
+  Requester requester(APIKEY, options);
+  EXPECT_THROW(requester.ready().get(), cbirdpp::TransferFailed);
+}
+
+TEST(AsyncEngineTest, ShutdownAbortsTransfersForGood)
+{
+  // A server that accepts connections but never answers, so the transfer is still running when the engine stops.
+  int server = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+  ASSERT_EQ(listen(server, 4), 0);
+  socklen_t length = sizeof(address);
+  getsockname(server, reinterpret_cast<sockaddr*>(&address), &length);
+
+  AsyncEngine::Request request;
+  request.url = "http://127.0.0.1:" + std::to_string(ntohs(address.sin_port)) + "/";
+  request.timeout = std::chrono::seconds(30);
+  std::promise<std::exception_ptr> cut_off;
+  std::promise<std::exception_ptr> retried;
+  {
+    AsyncEngine engine;
+    engine.submit(request, [&engine, &request, &cut_off, &retried](const ResponseBuffer&, std::exception_ptr error) {
+      cut_off.set_value(error);
+      // A retry from the completion is turned away at once instead of starting the loop again.
+      engine.submit(request, [&retried](const ResponseBuffer&, std::exception_ptr again) { retried.set_value(again); });
+    });
+    std::this_thread::sleep_for(milliseconds(100));
+  }
+  close(server);
+  EXPECT_THROW(std::rethrow_exception(cut_off.get_future().get()), cbirdpp::TransferAborted);
+  EXPECT_THROW(std::rethrow_exception(retried.get_future().get()), cbirdpp::TransferAborted);
+}
+
+// Compresses data into the gzip format, the way a server honouring "Accept-Encoding: gzip" would.
+static string gzip(const string& data)
+{
+  z_stream stream{};
+  deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+  string compressed(deflateBound(&stream, data.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+  stream.avail_out = static_cast<uInt>(compressed.size());
+  deflate(&stream, Z_FINISH);
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+  return compressed;
+}
+
+TEST(CompressionTest, GzipBodiesDecodeIntoRows)
+{
+  string body = "[";
+  for(int i = 0; i < 300; ++i) {
+    body += (i ? "," : "") + string("{\"speciesCode\":\"sp") + std::to_string(i) + "\",\"comName\":\"American Crow\"," +
+            "\"sciName\":\"Corvus brachyrhynchos\",\"locId\":\"L1\",\"locName\":\"Home\",\"obsDt\":\"2018-05-10 08:15\"," +
+            "\"howMany\":" + std::to_string(i) + ",\"lat\":42.5,\"lng\":-76.5,\"obsValid\":true,\"obsReviewed\":false," +
+            "\"locationPrivate\":false}";
+  }
+  body += "]";
+  string compressed = gzip(body);
+  ASSERT_LT(compressed.size(), body.size() / 4);
+  std::atomic<int> compressed_replies(0);
+  LocalServer server([&](const LocalRequest& request) {
+    LocalReply reply;
+    reply.headers.push_back({"Content-Type", "application/json;charset=utf-8"});
+    auto offered = request.headers.find("accept-encoding");
+    if(offered != request.headers.end() && offered->second.find("gzip") != string::npos) {
+      reply.headers.push_back({"Content-Encoding", "gzip"});
+      reply.body = compressed;
+      ++compressed_replies;
+    } else {
+      reply.body = body;
+    }
+    return reply;
+  });
+  for(bool compression : {true, false}) {
+    RequesterOptions options;
+    options.set_api_url(server.url());
+    options.set_compression(compression);
+    options.set_revalidation_cache(0);
+    Requester requester("offline", options);
+    // Once read whole from the buffer and once streamed row by row, both after libcurl has inflated the body.
+    Observations observations = requester.get_recent_observations_in_region("US-NY");
+    ASSERT_EQ(observations.size(), 300u);
+    for(unsigned int i = 0; i < 300; i += 29) {
+      EXPECT_EQ(observations[i].speciesCode, "sp" + std::to_string(i));
+      EXPECT_EQ(observations[i].howMany, i);
+    }
+    EXPECT_EQ(observations[299].comName, "American Crow");
+    unsigned int streamed = 0;
+    requester.for_each_recent_observations_in_region("US-NY", [&streamed](const cbirdpp::Observation& observation) {
+      EXPECT_EQ(observation.howMany, streamed++);
+    });
+    EXPECT_EQ(streamed, 300u);
+    // Only the two requests that offered gzip were answered with it.
+    EXPECT_EQ(compressed_replies, 2);
+  }
+}
+
+TEST(Http2Test, TransfersShareAConnectionWithinTheStreamLimit)
+{
+  RequesterOptions options;
+  options.set_http_version(HttpVersion::http2_prior_knowledge);
+  options.set_max_concurrent_streams(3);
+  options.set_max_host_connections(1);
+  LocalH2Server server("[]", [](std::size_t) { return milliseconds(30); }, 1000);
+  std::atomic<int> failed(0);
+  std::atomic<int> remaining(12);
+  std::promise<void> all_done;
+  {
+    AsyncEngine engine(options);
+    for(int i = 0; i < 12; ++i) {
+      engine.submit(server.url() + "region/" + std::to_string(i), {}, [&](const ResponseBuffer&, std::exception_ptr error) {
+        if(error) {++failed;}
+        if(--remaining == 0) {all_done.set_value();}
+      });
+    }
+    ASSERT_EQ(all_done.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+  }
+  EXPECT_EQ(failed, 0);
+  EXPECT_EQ(server.connections(), 1u);
+  // CURLMOPT_MAX_CONCURRENT_STREAMS holds the streams at the limit, multiplexing puts more than one on the connection.
+  EXPECT_LE(server.peak_streams(), 3u);
+  EXPECT_GE(server.peak_streams(), 2u);
+}
+
+TEST(JsonReaderTest, ReadsEscapesAndSkipsUnknownValues)
+{
+  // Once scanning byte by byte, once through a StructuralIndex.
+  for(std::size_t threshold : {JsonReader::INDEX_THRESHOLD, std::size_t(0)}) {
+    JsonReader reader(R"( {"name": "Caf\u00e9 \"A\"\n", "skip": [1, {"a": [true, null]}, "]"], "count": 2.0, "ok": false} )", threshold);
+    string name;
+    string_view key;
+    reader.begin_object();
+    ASSERT_TRUE(reader.next_key(key));
+    EXPECT_EQ(key, "name");
+    reader.read_string(name);
+    EXPECT_EQ(name, "Caf\xc3\xa9 \"A\"\n");
+    ASSERT_TRUE(reader.next_key(key));
+    reader.skip_value();
+    ASSERT_TRUE(reader.next_key(key));
+    EXPECT_EQ(reader.read_unsigned(), 2u);
+    ASSERT_TRUE(reader.next_key(key));
+    EXPECT_FALSE(reader.read_bool());
+    EXPECT_FALSE(reader.next_key(key));
+    reader.finish();
+
+    JsonReader truncated(R"([{"a": 1}, )", threshold);
+    truncated.begin_array();
+    ASSERT_TRUE(truncated.next_element());
+    truncated.skip_value();
+    ASSERT_TRUE(truncated.next_element());
+    EXPECT_THROW(truncated.skip_value(), cbirdpp::RequestFailed);
+  }
+}
+
+TEST(StructuralIndexTest, MatchesAByteByByteScan)
+{
+  // Strings that cross 64 byte blocks, with escaped quotes and backslash runs at and around block ends.
+  string text = "[";
+  for(int row = 0; row < 40; ++row) {
+    text += "{\"k" + std::to_string(row) + "\":\"" + string(row % 7, '\\') + string(row % 7, '\\') + "x\\\"y,[" +
+            string(row * 3, 'z') + "\\\\\",\"n\":[" + std::to_string(row) + ",{}]},";
+  }
+  text += "null]";
+  vector<std::uint32_t> expected;
+  bool in_string = false;
+  for(std::size_t i = 0; i < text.size(); ++i) {
+    char c = text[i];
+    if(in_string && c == '\\') {
+      ++i;
+    } else if(c == '"') {
+      expected.push_back(static_cast<std::uint32_t>(i));
+      in_string = !in_string;
+    } else if(!in_string && string_view("{}[]:,").find(c) != string_view::npos) {
+      expected.push_back(static_cast<std::uint32_t>(i));
+    }
+  }
+  EXPECT_EQ(StructuralIndex(text).positions(), expected);
+  EXPECT_THROW(StructuralIndex("[\"open"), cbirdpp::RequestFailed);
+  EXPECT_THROW(StructuralIndex("[\"a\nb\"]"), cbirdpp::RequestFailed);
+#if defined(__x86_64__)
+  // The AVX2 kernel is picked at run time, without the build having to target it.
+  EXPECT_EQ(string(StructuralIndex::implementation()), __builtin_cpu_supports("avx2") ? "avx2" : "sse2");
+#endif
+}
+
+TEST(StructuralIndexTest, LargeResponsesDecodeLikeSmallOnes)
+{
+  // Past INDEX_THRESHOLD a response is read through the index, a single row never is.
+  auto row = [](int i) {
+    return "{\"speciesCode\":\"sp" + std::to_string(i) + "\",\"comName\":\"Name \\\"" + std::to_string(i) +
+           "\\\" \\\\\",\"sciName\":\"" + string(i % 90, 's') + "\",\"locId\":\"L1\",\"locName\":\"Caf\\u00e9\"," +
+           "\"obsDt\":\"2018-05-10 08:15\",\"howMany\":" + std::to_string(i) + ",\"lat\":" + std::to_string(i) + ".25," +
+           "\"lng\":-76.5,\"obsValid\":true,\"obsReviewed\":false,\"locationPrivate\":false,\"extra\":[{\"a\":\"]}\"}]}";
+  };
+  string large = "[";
+  for(int i = 0; i < 400; ++i) {large += (i ? "," : "") + row(i);}
+  large += "]";
+  ASSERT_GE(large.size(), JsonReader::INDEX_THRESHOLD);
+
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  transport->serve(options.api_url() + "data/obs/", large);
+  Requester requester("offline", transport, options);
+  Observations indexed = requester.get_recent_observations_in_region("US-NY");
+  ASSERT_EQ(indexed.size(), 400u);
+  for(int i = 0; i < 400; i += 37) {
+    transport->serve(options.api_url() + "data/obs/geo/", "[" + row(i) + "]");
+    Observations single = requester.get_recent_nearby_observations(42.5, -76.5);
+    ASSERT_EQ(single.size(), 1u);
+    EXPECT_EQ(indexed[i].speciesCode, single[0].speciesCode);
+    EXPECT_EQ(indexed[i].comName, single[0].comName);
+    EXPECT_EQ(indexed[i].sciName, single[0].sciName);
+    EXPECT_EQ(indexed[i].locName, single[0].locName);
+    EXPECT_EQ(indexed[i].howMany, single[0].howMany);
+    EXPECT_DOUBLE_EQ(indexed[i].lat, single[0].lat);
+  }
+  EXPECT_EQ(indexed[3].comName, "Name \"3\" \\");
+}
+
+TEST(StructuralIndexTest, RetiredIndexesLendTheirMemoryToTheNext)
+{
+  string large = "[";
+  for(int i = 0; i < 2000; ++i) {large += (i ? "," : "") + string("{\"k\":\"v") + std::to_string(i) + "\"}";}
+  large += "]";
+  string small = "[{\"a\":[1,\"\\\"\"]}]";
+  StructuralIndex first = StructuralIndex::recycled(large);
+  const std::uint32_t* memory = first.positions().data();
+  EXPECT_EQ(first.positions(), StructuralIndex(large).positions());
+  StructuralIndex::retire(std::move(first));
+  StructuralIndex second = StructuralIndex::recycled(small);
+  EXPECT_EQ(second.positions().data(), memory);
+  EXPECT_EQ(second.positions(), StructuralIndex(small).positions());
+  EXPECT_TRUE(second.escapes());
+  // Each thread keeps memory of its own.
+  std::thread([&small, memory] { EXPECT_NE(StructuralIndex::recycled(small).positions().data(), memory); }).join();
+  second.assign(large);
+  EXPECT_EQ(second.positions().data(), memory);
+  EXPECT_FALSE(second.escapes());
+  EXPECT_THROW(second.assign("[\"open"), cbirdpp::RequestFailed);
+  EXPECT_TRUE(second.positions().empty());
+  StructuralIndex::retire(std::move(second));
+}
+
+TEST(StructuralIndexTest, RowsWithEscapesDecodeThroughTheBuffersOfTheThread)
+{
+  // Every row has escapes of its own, so a value left behind in the buffer of the thread would show in the next row.
+  auto row = [](int i) {
+    return "{\"speciesCode\":\"sp" + std::to_string(i) + "\",\"comName\":\"Name \\\"" + std::to_string(i) +
+           "\\\"\",\"sciName\":\"S\\u00e9" + string(i % 5, 's') + "\",\"locId\":\"L1\",\"locName\":\"Home\"," +
+           "\"obsDt\":\"2018\\u002d05-10 08:15\",\"lat\":42.5,\"lng\":-76.5,\"obsValid\":true,\"obsReviewed\":false," +
+           "\"locationPrivate\":false}";
+  };
+  string large = "[";
+  for(int i = 0; i < 600; ++i) {large += (i ? "," : "") + row(i);}
+  large += "]";
+  ASSERT_GE(large.size(), JsonReader::INDEX_THRESHOLD);
+
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  options.set_revalidation_cache(0);
+  transport->serve(options.api_url() + "data/obs/", large);
+  Requester requester("offline", transport, options);
+  for(int request = 0; request < 2; ++request) {
+    cbirdpp::InternedObservations interned = requester.intern_recent_observations_in_region("US-NY");
+    Observations owned = requester.get_recent_observations_in_region("US-NY");
+    ASSERT_EQ(interned.size(), 600u);
+    ASSERT_EQ(owned.size(), 600u);
+    for(int i = 0; i < 600; i += 7) {
+      EXPECT_EQ(interned[i].comName, "Name \"" + std::to_string(i) + "\"");
+      EXPECT_EQ(interned[i].sciName, "S\xc3\xa9" + string(i % 5, 's'));
+      EXPECT_EQ(interned[i].comName, owned[i].comName);
+      EXPECT_EQ(owned[i].obsDt, "2018-05-10 08:15");
+    }
+  }
+}
+
+TEST(ParallelDecodeTest, RunsAreJoinedInOrder)
+{
+  auto row = [](int i) {
+    return "{\"speciesCode\":\"sp" + std::to_string(i) + "\",\"comName\":\"Name, [" + std::to_string(i) +
+           "]\",\"sciName\":\"S\",\"locId\":\"L1\",\"locName\":\"Home\",\"obsDt\":\"2018-05-10 08:15\",\"howMany\":" +
+           std::to_string(i) + ",\"lat\":42.5,\"lng\":-76.5,\"obsValid\":true,\"obsReviewed\":false," +
+           "\"locationPrivate\":false,\"extra\":[{\"a\":[1,2]}]}";
+  };
+  string large = "[";
+  for(int i = 0; i < 1000; ++i) {large += (i ? ",\n" : "") + row(i);}
+  large += "]";
+  ASSERT_GE(large.size(), 128u * 1024);
+
+  vector<string_view> runs = JsonReader::split_array(large, 4);
+  ASSERT_EQ(runs.size(), 4u);
+  string joined;
+  for(string_view run : runs) {joined += run;}
+  EXPECT_EQ(joined + "]", large);
+  EXPECT_TRUE(JsonReader::split_array("{\"a\": [1, 2]}", 4).empty());
+
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  options.set_parallel_decode(64, 4);
+  transport->serve(options.api_url() + "data/obs/", large);
+  Requester requester("offline", transport, options);
+  Observations observations = requester.get_recent_observations_in_region("US-NY");
+  ASSERT_EQ(observations.size(), 1000u);
+  for(unsigned int i = 0; i < 1000; ++i) {EXPECT_EQ(observations[i].howMany, i);}
+  EXPECT_EQ(observations[999].comName, "Name, [999]");
+  EXPECT_EQ(requester.intern_recent_observations_in_region("US-NY")[500].comName, "Name, [500]");
+
+  large.insert(large.size() - 1, ",{\"speciesCode\": 1}");
+  transport->serve(options.api_url() + "data/obs/", large);
+  EXPECT_THROW(requester.get_recent_notable_observations_in_region("US-NY"), cbirdpp::RequestFailed);
+  EXPECT_THROW(options.set_parallel_decode(32, 4), cbirdpp::ArgumentOutOfRange<unsigned int>);
+}
+
+TEST(WorkerPoolTest, BatchesRunInsideTasksOfTheSamePool)
+{
+  std::atomic<int> calls{0};
+  {
+    WorkerPool workers(2);
+    EXPECT_EQ(workers.size(), 2u);
+    // Every thread runs a task waiting on a batch of its own, which then finishes on the waiting threads themselves.
+    for(int task = 0; task < 4; ++task) {
+      workers.post([&workers, &calls] { workers.run(8, [&calls](std::size_t) { ++calls; }); });
+    }
+    workers.run(0, [](std::size_t) { FAIL(); });
+    EXPECT_THROW(workers.run(4, [](std::size_t i) { if(i == 2) {throw cbirdpp::RequestFailed();} }), cbirdpp::RequestFailed);
+  }
+  // The pool runs what was posted before it is destroyed.
+  EXPECT_EQ(calls, 32);
+}
+
+TEST(JsonReaderTest, DecodesRowsWithoutADocument)
+{
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  transport->serve(options.api_url() + "data/obs/", R"([{"speciesCode": "amecro", "comName": "American Crow",
+    "sciName": "Corvus brachyrhynchos", "locId": "L1", "locName": "Caf\u00e9", "obsDt": "2018-05-10 08:15", "lat": 42.5,
+    "lng": -76.5, "obsValid": true, "obsReviewed": false, "locationPrivate": false, "extra": {"ignored": [1]}}])");
+  Requester requester("offline", transport, options);
+  Observations observations = requester.get_recent_observations_in_region("US-NY");
+  ASSERT_EQ(observations.size(), 1u);
+  EXPECT_EQ(observations[0].comName, "American Crow");
+  EXPECT_EQ(observations[0].howMany, 0u);
+  EXPECT_DOUBLE_EQ(observations[0].lng, -76.5);
+
+  cbirdpp::ObservationViews views = requester.view_recent_observations_in_region("US-NY");
+  ASSERT_EQ(views.size(), 1u);
+  EXPECT_EQ(views[0].comName, "American Crow");
+  EXPECT_EQ(views[0].locName, "Caf\xc3\xa9");
+  EXPECT_EQ(views.to_observations()[0].sciName, observations[0].sciName);
+
+  transport->serve(options.api_url() + "data/obs/", R"([{"speciesCode": "amecro"}])");
+  EXPECT_THROW(requester.get_recent_notable_observations_in_region("US-NY"), cbirdpp::RequestFailed);
+}
+
+TEST(ObservationViewsTest, EscapedTextOutlivesTheRequester)
+{
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  options.set_revalidation_cache(0);
+  transport->serve(options.api_url() + "data/obs/", R"([{"speciesCode": "amecro", "comName": "Crow \"A\"",
+    "sciName": "Corvus brachyrhynchos", "locId": "L1", "locName": "Caf\u00e9", "obsDt": "2018-05-10 08:15", "lat": 42.5,
+    "lng": -76.5, "obsValid": true, "obsReviewed": false, "locationPrivate": false},
+    {"speciesCode": "blujay", "comName": "Blue Jay", "sciName": "Cyanocitta\\cristata", "locId": "L2",
+    "locName": "Home", "obsDt": "2018-05-11 09:00", "lat": 42.6, "lng": -76.4, "obsValid": true,
+    "obsReviewed": false, "locationPrivate": false}])");
+  cbirdpp::ObservationViews views;
+  cbirdpp::ObservationViews async_views;
+  {
+    Requester requester("offline", transport, options);
+    views = requester.view_recent_observations_in_region("US-NY");
+    // Decoded on the worker pool from the body moved out of the transfer.
+    async_views = requester.async_view_recent_observations_in_region("US-NY").get();
+  }
+  transport->serve(options.api_url() + "data/obs/", "[]");
+
+  auto inside = [](string_view view, string_view text) {
+    return view.data() >= text.data() && view.data() + view.size() <= text.data() + text.size();
+  };
+  for(const cbirdpp::ObservationViews* result : {&views, &async_views}) {
+    ASSERT_EQ(result->size(), 2u);
+    const cbirdpp::ObservationViews::Text& text = *result->text;
+    const cbirdpp::ObservationView& crow = (*result)[0];
+    const cbirdpp::ObservationView& jay = (*result)[1];
+    EXPECT_EQ(crow.comName, "Crow \"A\"");
+    EXPECT_EQ(crow.locName, "Caf\xc3\xa9");
+    EXPECT_EQ(jay.sciName, "Cyanocitta\\cristata");
+    EXPECT_EQ(jay.obsDt, Timestamp(2018, 5, 11, 9, 0));
+    // Only the strings with escapes are copied, the times are parsed and not kept.
+    ASSERT_EQ(text.unescaped.size(), 3u);
+    EXPECT_EQ(text.unescaped[0], crow.comName);
+    EXPECT_EQ(text.unescaped[0].data(), crow.comName.data());
+    EXPECT_EQ(text.unescaped[1].data(), crow.locName.data());
+    EXPECT_EQ(text.unescaped[2].data(), jay.sciName.data());
+    EXPECT_TRUE(inside(crow.sciName, text.body));
+    EXPECT_TRUE(inside(jay.comName, text.body));
+    EXPECT_EQ(jay.locName, "Home");
+  }
+  EXPECT_NE(views.text, async_views.text);
+  cbirdpp::ObservationViews copy = views;
+  views = cbirdpp::ObservationViews();
+  EXPECT_EQ(copy[0].comName, "Crow \"A\"");
+  EXPECT_EQ(copy.to_observations()[1].sciName, "Cyanocitta\\cristata");
+}
+
+TEST(FieldProjectionTest, SkippedFieldsAreLeftEmpty)
+{
+  using cbirdpp::ObservationFields;
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  // A detailed row without locID, which only decodes when locID is not asked for.
+  transport->serve(options.api_url() + "data/obs/", R"([{"speciesCode": "amecro", "comName": "American Crow",
+    "sciName": "Corvus brachyrhynchos", "locId": "L1", "locName": "Home", "obsDt": "2018-05-10 08:15", "howMany": 3,
+    "lat": 42.5, "lng": -76.5, "obsValid": true, "obsReviewed": false, "locationPrivate": false, "subId": "S1",
+    "firstName": "Jo", "checklistId": "CL1", "countryCode": "US", "countryName": "United States", "hasComments": false,
+    "hasRichMedia": false, "obsId": "OBS1", "presenceNoted": false, "subnational1Code": "US-NY",
+    "subnational1Name": "New York", "subnational2Code": "US-NY-109", "subnational2Name": "Tompkins"}])");
+  Requester requester("offline", transport, options);
+  DataOptionalParameters params;
+  EXPECT_THROW(params.set_fields(0), cbirdpp::ArgumentOutOfRange<unsigned long>);
+  EXPECT_THROW(params.set_fields(ObservationFields::all + 1), cbirdpp::ArgumentOutOfRange<unsigned long>);
+  params.set_fields(ObservationFields::speciesCode | ObservationFields::obsDt | ObservationFields::lat |
+                    ObservationFields::lng | ObservationFields::firstName);
+
+  cbirdpp::DetailedObservations detailed = requester.get_detailed_recent_notable_observations_in_region("US-NY", params);
+  ASSERT_EQ(detailed.size(), 1u);
+  EXPECT_EQ(detailed[0].speciesCode, "amecro");
+  EXPECT_EQ(detailed[0].obsDt, "2018-05-10 08:15");
+  EXPECT_DOUBLE_EQ(detailed[0].lat, 42.5);
+  EXPECT_EQ(detailed[0].firstName, "Jo");
+  EXPECT_EQ(detailed[0].comName, "");
+  EXPECT_EQ(detailed[0].subnational1Name, "");
+  EXPECT_EQ(detailed[0].lastName, "");
+  EXPECT_EQ(detailed[0].howMany, 0u);
+
+  cbirdpp::ObservationViews views = requester.view_recent_observations_in_region("US-NY", params);
+  ASSERT_EQ(views.size(), 1u);
+  EXPECT_EQ(views[0].speciesCode, "amecro");
+  EXPECT_TRUE(views[0].locName.empty());
+
+  // The full projection is a different request, and it needs the missing field.
+  EXPECT_THROW(requester.get_detailed_recent_notable_observations_in_region("US-NY"), cbirdpp::RequestFailed);
+}
+
+TEST(FieldTableTest, FindsEveryFieldWithOneLookup)
+{
+  using Fields = cbirdpp::Fields<RegionalStats>;
+  constexpr auto table = cbirdpp::make_field_table(Fields::field("numChecklists", &RegionalStats::numChecklists),
+                                                   Fields::field("numContributors", &RegionalStats::numContributors),
+                                                   Fields::optional("numSpecies", &RegionalStats::numSpecies, 7));
+  static_assert(table.find("numContributors") == 1);
+  static_assert(table.find("numSpecie") == table.size());
+  EXPECT_EQ(table.find("numSpecies"), 2u);
+  EXPECT_EQ(table.required(), 3ul);
+
+  RegionalStats stats{};
+  JsonReader source(R"({"numContributors": 4, "extra": [1, {"numSpecies": 9}], "numChecklists": 12})");
+  EXPECT_TRUE(cbirdpp::read_fields(source, stats, table));
+  EXPECT_EQ(stats.numChecklists, 12u);
+  EXPECT_EQ(stats.numContributors, 4u);
+  EXPECT_EQ(stats.numSpecies, 7u);
+
+  JsonReader incomplete(R"({"numChecklists": 12, "numSpecies": 1})");
+  EXPECT_FALSE(cbirdpp::read_fields(incomplete, stats, table));
+}
+
+TEST(FieldTableTest, ChecklistsReadTheirLocationObject)
+{
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  transport->serve(options.api_url() + "product/lists/", R"([{"locId": "L1", "subId": "ignored", "subID": "S1",
+    "userDisplayName": "Jo", "numSpecies": 12, "obsDt": "1 Jan 2018", "obsTime": "08:00", "obsMonth": "Jan",
+    "obsDay": 1, "obsYear": 2018, "loc": {"locId": "L1", "name": "Home", "latitude": 42.5, "longitude": -76.5,
+    "countryCode": "US", "countryName": "United States", "subnational1Name": "New York", "subnational1Code": "US-NY",
+    "subnational2Name": "Tompkins", "subnational2Code": "US-NY-109", "isHotspot": true, "hierarchicalName": "Home, US"}}])");
+  Requester requester("offline", transport, options);
+  Checklists checklists = requester.get_checklist_feed_on_date("US-NY", 2018, 1, 1);
+  ASSERT_EQ(checklists.size(), 1u);
+  EXPECT_EQ(checklists[0].subID, "S1");
+  EXPECT_EQ(checklists[0].obsDt, Timestamp(2018, 1, 1, 8, 0));
+  EXPECT_EQ(checklists[0].name, "Home");
+  EXPECT_DOUBLE_EQ(checklists[0].longitude, -76.5);
+  EXPECT_TRUE(checklists[0].isHotspot);
+
+  transport->serve(options.api_url() + "product/top100/", R"([{"userDisplayName": "Jo", "numSpecies": 3,
+    "numCompleteChecklists": 2, "rowNum": 1, "userId": "U1"}])");
+  Top100 top = requester.get_top_100("US-NY", 2018, 1, 1);
+  ASSERT_EQ(top.size(), 1u);
+  EXPECT_EQ(top[0].profileHandle, "N/A");
+  EXPECT_EQ(top[0].numCompleteChecklists, 2u);
+}
+
+TEST(StringPoolTest, InternsEachStringOnce)
+{
+  cbirdpp::StringPool pool;
+  string text = "American Crow";
+  cbirdpp::InternedString first = pool.intern(text);
+  text = "Blue Jay";
+  EXPECT_EQ(first, "American Crow");
+  EXPECT_EQ(pool.intern("American Crow"), first);
+  EXPECT_NE(pool.intern("Blue Jay"), first);
+  EXPECT_EQ(pool.intern(""), cbirdpp::InternedString());
+  EXPECT_EQ(pool.intern(string(2 * cbirdpp::StringPool::CHUNK, 'x')).size(), 2 * cbirdpp::StringPool::CHUNK);
+  EXPECT_EQ(pool.intern("after a long one"), "after a long one");
+  EXPECT_EQ(pool.size(), 4u);
+  static_assert(sizeof(cbirdpp::InternedString) == sizeof(void*));
+
+  cbirdpp::InternedStrings strings(cbirdpp::StringPool().bytes() + 1);   // Full after the first string.
+  std::shared_ptr<cbirdpp::StringPool> full = strings.pool();
+  EXPECT_EQ(strings.pool(), full);
+  full->intern("anything");
+  EXPECT_NE(strings.pool(), full);
+}
+
+TEST(StringPoolTest, HandlesFromDifferentPoolsCompareTheirText)
+{
+  cbirdpp::StringPool before;
+  cbirdpp::StringPool after;
+  cbirdpp::InternedString first = before.intern("American Crow");
+  cbirdpp::InternedString second = after.intern("American Crow");
+  EXPECT_NE(first.data(), second.data());
+  EXPECT_EQ(first, second);
+  EXPECT_FALSE(first != second);
+  EXPECT_NE(first, after.intern("Blue Jay"));
+  EXPECT_NE(first, cbirdpp::InternedString());
+}
+
+TEST(StringPoolTest, InternedResultsShareTheirText)
+{
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  options.set_revalidation_cache(0);
+  transport->serve(options.api_url() + "data/obs/", R"([
+    {"speciesCode": "amecro", "comName": "American Crow", "sciName": "Corvus brachyrhynchos", "locId": "L1",
+     "locName": "Caf\u00e9", "obsDt": "2018-05-10 08:15", "lat": 42.5, "lng": -76.5, "obsValid": true,
+     "obsReviewed": false, "locationPrivate": false, "checklistId": "CL1", "countryCode": "US", "subId": "S1",
+     "countryName": "United States", "hasComments": false, "hasRichMedia": false, "locID": "L1", "obsId": "OBS1",
+     "presenceNoted": false, "subnational1Code": "US-NY", "subnational1Name": "New York",
+     "subnational2Code": "US-NY-109", "subnational2Name": "Tompkins"},
+    {"speciesCode": "amecro", "comName": "American Crow", "sciName": "Corvus brachyrhynchos", "locId": "L1",
+     "locName": "Caf\u00e9", "obsDt": "2018-05-11 09:00", "lat": 42.6, "lng": -76.4, "obsValid": true,
+     "obsReviewed": false, "locationPrivate": false}])");
+  cbirdpp::InternedObservations first;
+  cbirdpp::InternedObservations second;
+  {
+    Requester requester("offline", transport, options);
+    first = requester.intern_recent_observations_in_region("US-NY");
+    second = requester.intern_recent_observations_in_region("US-NY");
+    EXPECT_THROW(requester.intern_detailed_recent_notable_observations_in_region("US-NY"), cbirdpp::RequestFailed);
+    transport->serve(options.api_url() + "data/obs/", R"([{"speciesCode": "amecro", "comName": "American Crow",
+      "sciName": "Corvus brachyrhynchos", "locId": "L1", "locName": "Home", "obsDt": "2018-05-10 08:15", "lat": 42.5,
+      "lng": -76.5, "obsValid": true, "obsReviewed": false, "locationPrivate": false, "checklistId": "CL1",
+      "countryCode": "US", "subId": "S1", "countryName": "United States", "hasComments": false, "hasRichMedia": false,
+      "locID": "L1", "obsId": "OBS1", "presenceNoted": false, "subnational1Code": "US-NY",
+      "subnational1Name": "New York", "subnational2Code": "US-NY-109", "subnational2Name": "Tompkins"}])");
+    cbirdpp::InternedDetailedObservations detailed = requester.intern_detailed_recent_notable_observations_in_region("US-NY");
+    ASSERT_EQ(detailed.size(), 1u);
+    EXPECT_EQ(detailed[0].comName, first[0].comName);
+    EXPECT_EQ(detailed[0].firstName, "N/A");
+    EXPECT_EQ(detailed.to_observations()[0].subnational2Name, "Tompkins");
+  }
+  ASSERT_EQ(first.size(), 2u);
+  EXPECT_EQ(first[0].locName, "Caf\xc3\xa9");
+  EXPECT_EQ(first[0].comName, first[1].comName);
+  EXPECT_EQ(first[1].locName, second[0].locName);
+  EXPECT_NE(first[0].obsDt, first[1].obsDt);
+  EXPECT_EQ(first.pool, second.pool);
+  EXPECT_EQ(second.to_observations()[1].obsDt, "2018-05-11 09:00");
+}
+
+TEST(ArenaRowsTest, RowsAndTheirTextShareTheResultsArena)
+{
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  transport->serve(options.api_url() + "data/obs/", R"([{"speciesCode": "amecro", "comName": "American Crow",
+    "sciName": "Corvus brachyrhynchos", "locId": "L1", "locName": "A location name longer than any short string",
+    "obsDt": "2018-05-10 08:15", "lat": 42.5, "lng": -76.5, "obsValid": true, "obsReviewed": false,
+    "locationPrivate": false, "checklistId": "CL1", "countryCode": "US", "subId": "S1", "countryName": "United States",
+    "hasComments": false, "hasRichMedia": false, "locID": "L1", "obsId": "OBS1", "presenceNoted": false,
+    "subnational1Code": "US-NY", "subnational1Name": "New York", "subnational2Code": "US-NY-109",
+    "subnational2Name": "Tompkins"}])");
+  transport->serve(options.api_url() + "product/lists/", R"([{"locId": "L1", "subID": "S1", "userDisplayName": "Jo",
+    "numSpecies": 12, "obsDt": "1 Jan 2018", "obsTime": "08:00", "loc": {"name": "Home", "latitude": 42.5,
+    "longitude": -76.5, "countryCode": "US", "countryName": "United States", "subnational1Name": "New York",
+    "subnational1Code": "US-NY", "subnational2Name": "Tompkins", "subnational2Code": "US-NY-109", "isHotspot": true,
+    "hierarchicalName": "Home, Tompkins, New York, US"}}])");
+  transport->serve(options.api_url() + "product/top100/", R"([{"userDisplayName": "Jo", "numSpecies": 3,
+    "numCompleteChecklists": 2, "rowNum": 1, "userId": "U1"}])");
+  Requester requester("offline", transport, options);
+
+  cbirdpp::ArenaDetailedObservations detailed = requester.arena_detailed_recent_notable_observations_in_region("US-NY");
+  ASSERT_EQ(detailed.size(), 1u);
+  std::pmr::memory_resource* arena = detailed.rows().get_allocator().resource();
+  EXPECT_NE(arena, std::pmr::get_default_resource());
+  EXPECT_EQ(detailed[0].locName.get_allocator().resource(), arena);
+  EXPECT_EQ(detailed[0].subnational2Name.get_allocator().resource(), arena);
+  EXPECT_EQ(detailed[0].firstName, "N/A");
+  DetailedObservations owned = detailed.to_owned();
+  EXPECT_EQ(owned[0].locName, "A location name longer than any short string");
+  EXPECT_EQ(owned[0].obsDt, Timestamp(2018, 5, 10, 8, 15));
+  cbirdpp::ArenaDetailedObservations copy = detailed;
+  EXPECT_EQ(&copy[0], &detailed[0]);
+  // Copies share their rows with other callers, so only a const view of them is public.
+  static_assert(is_same_v<decltype(copy.rows()), const std::pmr::vector<cbirdpp::ArenaDetailedObservation>&>);
+
+  cbirdpp::ArenaChecklists checklists = requester.arena_checklist_feed_on_date("US-NY", 2018, 1, 1);
+  ASSERT_EQ(checklists.size(), 1u);
+  EXPECT_EQ(checklists[0].hierarchicalName.get_allocator().resource(), checklists.rows().get_allocator().resource());
+  EXPECT_EQ(checklists.to_owned()[0].hierarchicalName, "Home, Tompkins, New York, US");
+  EXPECT_EQ(checklists[0].obsDt, Timestamp(2018, 1, 1, 8, 0));
+  cbirdpp::ArenaTop100 top = requester.arena_top_100("US-NY", 2018, 1, 1);
+  ASSERT_EQ(top.size(), 1u);
+  EXPECT_EQ(top[0].profileHandle, "N/A");
+  EXPECT_EQ(top.to_owned()[0].userId, "U1");
+}
+
+TEST(TimestampTest, ParsesTheAPIsFormatsIntoComparableIntegers)
+{
+  Timestamp observed;
+  ASSERT_TRUE(Timestamp::parse("2018-01-01 23:51", observed));
+  EXPECT_EQ(observed, Timestamp(2018, 1, 1, 23, 51));
+  EXPECT_EQ(observed.to_string(), "2018-01-01 23:51");
+  EXPECT_EQ(observed.minutes(), 17532 * 1440 + 23 * 60 + 51);
+  EXPECT_FALSE(Timestamp::parse("2018-02-29", observed));
+  EXPECT_FALSE(Timestamp::parse("2018-01-01 24:00", observed));
+  EXPECT_EQ(observed, "2018-01-01 23:51");
+
+  Timestamp checklist;
+  ASSERT_TRUE(Timestamp::parse_time("8:05", checklist));
+  ASSERT_TRUE(Timestamp::parse_date("29 Feb 2000", checklist));
+  EXPECT_EQ(checklist.year(), 2000);
+  EXPECT_EQ(checklist.month(), 2u);
+  EXPECT_EQ(checklist.day(), 29u);
+  EXPECT_EQ(checklist.to_string(), "2000-02-29 08:05");
+  EXPECT_FALSE(Timestamp::parse_date("1 Foo 2018", checklist));
+
+  Timestamp untimed(2018, 1, 1);
+  EXPECT_FALSE(untimed.has_time());
+  EXPECT_EQ(untimed.to_string(), "2018-01-01");
+  EXPECT_LT(untimed, Timestamp(2018, 1, 1, 0, 0));
+  EXPECT_LT(checklist, untimed);
+  EXPECT_LT(Timestamp(1969, 12, 31, 23, 59), Timestamp());
+  EXPECT_THROW(Timestamp(2018, 13, 1), cbirdpp::ArgumentOutOfRange<unsigned int>);
+}
+
+TEST(StreamingTest, RowsAreHandedOutWhileTheBodyArrives)
+{
+  std::vector<std::string> elements;
+  cbirdpp::ArrayStream split;
+  std::string text = R"( [{"a": "x,]\"}", "b": [1, {"c": 2}]}, 3 , "s"] )";
+  for(char c : text) {
+    split.feed(std::string_view(&c, 1), [&elements](std::string_view element) { elements.emplace_back(element); });
+  }
+  split.finish();
+  ASSERT_EQ(elements.size(), 3u);
+  EXPECT_EQ(elements[0], R"({"a": "x,]\"}", "b": [1, {"c": 2}]})");
+  EXPECT_EQ(elements[1], "3 ");
+  EXPECT_EQ(split.pending(), 0u);
+  cbirdpp::ArrayStream unclosed;
+  unclosed.feed("[1, 2", [](std::string_view) {});
+  EXPECT_THROW(unclosed.finish(), cbirdpp::RequestFailed);
+
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  std::string body = "[";
+  for(int row = 0; row < 2000; ++row) {
+    body += std::string(row == 0 ? "" : ",") + R"({"speciesCode": "sp)" + std::to_string(row) + R"(", "comName": "Name",
+      "sciName": "Name", "locId": "L1", "locName": "Somewhere", "obsDt": "2018-05-10 08:15", "howMany": 2,
+      "lat": 42.5, "lng": -76.5, "obsValid": true, "obsReviewed": false, "locationPrivate": false})";
+  }
+  body += "]";
+  transport->serve(options.api_url() + "data/obs/US-NY/", body);
+  transport->serve(options.api_url() + "data/obs/US-PA/", "[{\"speciesCode\": 1}]");
+  Requester requester("offline", transport, options);
+
+  std::size_t rows = 0;
+  std::size_t sent_at_first_row = body.size();
+  requester.for_each_recent_observations_in_region("US-NY", [&](const cbirdpp::Observation& observation) {
+    if(rows == 0) {sent_at_first_row = transport->bytes_sent();}
+    EXPECT_EQ(observation.speciesCode, "sp" + std::to_string(rows++));
+  });
+  EXPECT_EQ(rows, 2000u);
+  EXPECT_LT(sent_at_first_row, MemoryTransport::CHUNK);
+
+  auto stop = [](const cbirdpp::Observation&) { throw std::runtime_error("enough"); };
+  EXPECT_THROW(requester.for_each_recent_observations_in_region("US-NY", stop), std::runtime_error);
+  EXPECT_THROW(requester.for_each_recent_observations_in_region("US-PA", [](const cbirdpp::Observation&) {}),
+               cbirdpp::RequestFailed);
+  EXPECT_THROW(requester.for_each_recent_checklists_feed("US-NY", [](const Checklist&) {}), cbirdpp::HttpError);
+}
+
+TEST(CheckedDecodeTest, BadRowsAreRecordedAndTheOthersKept)
+{
+  JsonReader reader(R"({"howMany": "x"})", JsonReader::INDEX_THRESHOLD, JsonReader::record_errors);
+  std::string_view key;
+  reader.begin_object();
+  ASSERT_TRUE(reader.next_key(key));
+  EXPECT_EQ(reader.read_unsigned(), 0u);
+  EXPECT_TRUE(reader.failed());
+  EXPECT_FALSE(reader.next_key(key));
+  EXPECT_NO_THROW(reader.finish());
+
+  auto row = [](const std::string& species, const std::string& howMany, const std::string& date) {
+    return R"({"speciesCode": ")" + species + R"(", "comName": "Name", "sciName": "Name", "locId": "L1",
+      "locName": "Somewhere", "obsDt": ")" + date + R"(", "howMany": )" + howMany + R"(, "lat": 42.5, "lng": -76.5,
+      "obsValid": true, "obsReviewed": false, "locationPrivate": false})";
+  };
+  std::string body = "[" + row("first", "1", "2018-05-10 08:15") + "," + row("wrong", "\"x\"", "2018-05-10") + "," +
+                     R"({"speciesCode": "missing"},)" + row("baddate", "2", "2018-13-10") + ",{\"broken\" 1}," +
+                     row("last", "3", "2018-05-11") + "]";
+  auto transport = std::make_shared<MemoryTransport>();
+  RequesterOptions options;
+  transport->serve(options.api_url() + "data/obs/US-NY/", body);
+  transport->serve(options.api_url() + "data/obs/US-PA/", "[" + row("kept", "1", "2018-05-10") + ",{\"speciesCode");
+  Requester requester("offline", transport, options);
+
+  cbirdpp::Checked<Observations> checked = requester.checked_recent_observations_in_region("US-NY");
+  EXPECT_FALSE(checked);
+  EXPECT_EQ(checked.error(), cbirdpp::no_decode_error);
+  ASSERT_EQ(checked->size(), 2u);
+  EXPECT_EQ(checked.value()[0].speciesCode, "first");
+  EXPECT_EQ(checked.value()[1].speciesCode, "last");
+  ASSERT_EQ(checked.failures().size(), 4u);
+  EXPECT_EQ(checked.failures()[0].row, 1u);
+  EXPECT_EQ(checked.failures()[0].error, cbirdpp::malformed_row);
+  EXPECT_EQ(checked.failures()[1].error, cbirdpp::invalid_row);
+  EXPECT_EQ(checked.failures()[2].error, cbirdpp::invalid_row);
+  EXPECT_EQ(checked.failures()[3].row, 4u);
+  EXPECT_EQ(checked.failures()[3].error, cbirdpp::malformed_row);
+  EXPECT_THROW(requester.get_recent_observations_in_region("US-NY"), cbirdpp::RequestFailed);
+
+  cbirdpp::Checked<Observations> truncated = requester.async_checked_recent_observations_in_region("US-PA").get();
+  EXPECT_EQ(truncated.error(), cbirdpp::malformed_response);
+  ASSERT_EQ(truncated->size(), 1u);
+  EXPECT_EQ(truncated.value()[0].speciesCode, "kept");
+}
+
 int main(int argc, char **argv)
 {
   if(!fin) {return -1;}